@@ -40,8 +40,16 @@ int main(int argc, const char** args)
     ops.args.dumpbin.datamode = SBDOP_DEFAULT_DATAMODE;
     ops.args.dumpbin.delay = SBDOP_DEFAULT_DELAY;
     ops.args.dumpbin.burst = SBDOP_DEFAULT_BURST;
+    ops.args.dumpbin.chunk = SBDOP_DEFAULT_CHUNK;
+    ops.args.dumpbin.ring = SBDOP_DEFAULT_RING_DEPTH;
+    ops.args.dumpbin.engine = SBDOP_DEFAULT_ENGINE;
+    ops.args.dumpbin.rate = NULL;
+    ops.args.dumpbin.gap = NULL;
     ops.args.dumpbin.portname = NULL;
     ops.args.dumpbin.filename = NULL;
+    ops.args.dumpbin.watch = NULL;
+    ops.args.dumpbin.progress = NULL;
+    ops.args.dumpbin.manifest = NULL;
 
 	for(int i = 0; i < argc; i++)
 	{
@@ -89,6 +97,19 @@ int main(int argc, const char** args)
             }
         }
 
+        if(strcmp(args[i], "-wt") == 0)
+        {
+            if((i+1) < argc)
+            {
+                ops.args.dumpbin.watch = args[i+1];
+            }
+            else
+            {
+                ops.op = OP_INVALID;
+                break;
+            }
+        }
+
         if(strcmp(args[i], "-dm") == 0)
         {
             if((i+1) < argc)
@@ -141,10 +162,101 @@ int main(int argc, const char** args)
             }
         }
 
+        if(strcmp(args[i], "-ck") == 0)
+        {
+            if((i+1) < argc)
+            {
+                ops.args.dumpbin.chunk = args[i+1];
+            }
+            else
+            {
+                ops.op = OP_INVALID;
+                break;
+            }
+        }
+
+        if(strcmp(args[i], "-rd") == 0)
+        {
+            if((i+1) < argc)
+            {
+                ops.args.dumpbin.ring = args[i+1];
+            }
+            else
+            {
+                ops.op = OP_INVALID;
+                break;
+            }
+        }
+
+        if(strcmp(args[i], "-io") == 0)
+        {
+            if((i+1) < argc)
+            {
+                ops.args.dumpbin.engine = args[i+1];
+            }
+            else
+            {
+                ops.op = OP_INVALID;
+                break;
+            }
+        }
+
+        if((strcmp(args[i], "-rt") == 0) || (strcmp(args[i], "--rate") == 0))
+        {
+            if((i+1) < argc)
+            {
+                ops.args.dumpbin.rate = args[i+1];
+            }
+            else
+            {
+                ops.op = OP_INVALID;
+                break;
+            }
+        }
+
+        if((strcmp(args[i], "-gp") == 0) || (strcmp(args[i], "--gap") == 0))
+        {
+            if((i+1) < argc)
+            {
+                ops.args.dumpbin.gap = args[i+1];
+            }
+            else
+            {
+                ops.op = OP_INVALID;
+                break;
+            }
+        }
+
+        if((strcmp(args[i], "-pg") == 0) || (strcmp(args[i], "--progress") == 0))
+        {
+            if((i+1) < argc)
+            {
+                ops.args.dumpbin.progress = args[i+1];
+            }
+            else
+            {
+                ops.op = OP_INVALID;
+                break;
+            }
+        }
+
+        if((strcmp(args[i], "-mf") == 0) || (strcmp(args[i], "--manifest") == 0))
+        {
+            if((i+1) < argc)
+            {
+                ops.args.dumpbin.manifest = args[i+1];
+            }
+            else
+            {
+                ops.op = OP_INVALID;
+                break;
+            }
+        }
+
         if(i == (argc-1))
         {
-            // last loop iteration, no error and no other options: assume OP_DUMP_BINARY
-            ops.op = OP_DUMP_BINARY;
+            // last loop iteration, no error and no other options: assume OP_DUMP_BINARY (or OP_DUMP_MANIFEST)
+            ops.op = (ops.args.dumpbin.manifest != NULL) ? OP_DUMP_MANIFEST : OP_DUMP_BINARY;
         }
 
 	}
@@ -163,7 +275,7 @@ int main(int argc, const char** args)
 	    }
 	    case OP_DUMP_BINARY:
 	    {
-	        if(ops.args.dumpbin.portname == NULL)
+	        if((ops.args.dumpbin.portname == NULL) && (ops.args.dumpbin.watch == NULL))
 	        {
 	            printf("Error! Mandatory portname argument not given.\n");
 	            break;
@@ -173,15 +285,24 @@ int main(int argc, const char** args)
                 printf("Error! Mandatory filename argument not given.\n");
                 break;
             }
-            int portnum = -1;
-	        if(!SBDOP_ValidComPort(ops.args.dumpbin.portname))
+	        std::vector<std::string> ports;
+	        if((ops.args.dumpbin.watch == NULL) && !SBDOP_GetPortNames(ops.args.dumpbin.portname, ports))
+	        {
+	            printf("Error! Given port list: %s is invalid.\n", ops.args.dumpbin.portname);
+	            break;
+	        }
+	        if((ports.size() == 1) && !SBDOP_ValidComPort(ops.args.dumpbin.portname))
 	        {
 	            printf("Error! Com port with name: %s does not exist on this system.\n", ops.args.dumpbin.portname);
 	            break;
 	        }
-	        else
+	        // with several ports, a missing one fails its own dump only
+	        for(size_t i = 0; (ports.size() > 1) && (i < ports.size()); i++)
 	        {
-	            portnum = SBDOP_GetComPortNumFromName(ops.args.dumpbin.portname);
+	            if(!SBDOP_ValidComPort(ports[i].c_str()))
+	            {
+	                printf("Warning! Com port with name: %s does not exist on this system.\n", ports[i].c_str());
+	            }
 	        }
 	        int baud = SBDOP_GetBaudRateFromName(ops.args.dumpbin.baudrate);
 	        if(baud == -1)
@@ -194,12 +315,16 @@ int main(int argc, const char** args)
 	            printf("Error! Given data mode: %s is not supported.\n", ops.args.dumpbin.datamode);
 	            break;
 	        }
-	        uint32_t filesize = 0;
+	        uint64_t filesize = 0;
 	        if(!SBDOP_ValidFile(ops.args.dumpbin.filename, &filesize))
 	        {
-	            printf("Error! Cannot open file: %s.\nFile may not exist, is unable to be opened or exceeds size limit (%d bytes). \n",
-	                    ops.args.dumpbin.filename,
-	                    SBDOP_MAX_FILESIZE);
+	            printf("Error! Cannot open file: %s.\nFile may not exist, is unable to be opened or is not a regular file. \n",
+	                    ops.args.dumpbin.filename);
+	            break;
+	        }
+	        if((filesize == SBDOP_FILESIZE_UNKNOWN) && ((ops.args.dumpbin.watch != NULL) || (ports.size() > 1)))
+	        {
+	            printf("Error! Stream %s can be dumped to a single port only.\n", ops.args.dumpbin.filename);
 	            break;
 	        }
 	        int delay = SBDOP_GetDelayFromName(ops.args.dumpbin.delay);
@@ -219,30 +344,160 @@ int main(int argc, const char** args)
                 printf("Error! Given burst: %s is invalid.\n", ops.args.dumpbin.burst);
                 break;
 	        }
-	        if(!SBDOP_ValidBurst(burst, filesize))
+	        // a stream ends where it ends, its last burst may be shorter
+	        if((filesize != SBDOP_FILESIZE_UNKNOWN) && !SBDOP_ValidBurst(burst, filesize))
 	        {
                 printf("Error! Given burst: %s is invalid.\n"
-                        "It is either greater than filesize (%d bytes) or filesize is not"
+                        "It is either greater than filesize (%" PRIu64 " bytes) or filesize is not "
                         "dividable by burst.\n",
                         ops.args.dumpbin.burst,
                         filesize);
                 break;
 	        }
+	        int chunk = SBDOP_GetChunkFromName(ops.args.dumpbin.chunk);
+	        if(chunk <= 0 || chunk > SBDOP_MAX_CHUNK)
+	        {
+	            printf("Error! Given chunk: %s is invalid.\n", ops.args.dumpbin.chunk);
+	            break;
+	        }
+	        int ring_depth = SBDOP_GetRingDepthFromName(ops.args.dumpbin.ring);
+	        if(ring_depth <= 0 || ring_depth > SBDOP_MAX_RING_DEPTH)
+	        {
+	            printf("Error! Given ring depth: %s is invalid.\n", ops.args.dumpbin.ring);
+	            break;
+	        }
+	        sbdop_engine_t engine = SBDOP_GetEngineFromName(ops.args.dumpbin.engine);
+	        if(engine == SBDOP_ENGINE_INVALID)
+	        {
+	            printf("Error! Given I/O engine: %s is invalid.\n", ops.args.dumpbin.engine);
+	            break;
+	        }
+	        uint64_t rate = 0;
+	        if(ops.args.dumpbin.rate != NULL)
+	        {
+	            rate = SBDOP_GetRateFromName(ops.args.dumpbin.rate);
+	            if(rate == 0)
+	            {
+	                printf("Error! Given rate: %s is invalid.\n", ops.args.dumpbin.rate);
+	                break;
+	            }
+	        }
+	        int gap = 0;
+	        if(ops.args.dumpbin.gap != NULL)
+	        {
+	            gap = SBDOP_GetDelayFromName(ops.args.dumpbin.gap);
+	            if(gap <= 0)
+	            {
+	                printf("Error! Given gap: %s is invalid.\n", ops.args.dumpbin.gap);
+	                break;
+	            }
+	        }
+	        if(((rate > 0) && (gap > 0)) || (((rate > 0) || (gap > 0)) && (delay > 0)))
+	        {
+	            printf("Error! Only one of: delay, rate, gap can be given.\n");
+	            break;
+	        }
+	        if(ops.args.dumpbin.progress != NULL)
+	        {
+	            sbdop_progress_t progress = SBDOP_GetProgressFromName(ops.args.dumpbin.progress);
+	            if(progress == SBDOP_PROGRESS_INVALID)
+	            {
+	                printf("Error! Given progress format: %s is invalid.\n", ops.args.dumpbin.progress);
+	                break;
+	            }
+	            SBDOP_SetProgressFormat(progress);
+	        }
 
 
-	        printf("portname: %s.\n", ops.args.dumpbin.portname);
+	        if(ops.args.dumpbin.watch != NULL)
+	        {
+	            printf("watch: %s.\n", ops.args.dumpbin.watch);
+	        }
+	        else
+	        {
+	            printf("portname: %s.\n", ops.args.dumpbin.portname);
+	        }
 	        printf("baud: %d.\n", baud);
 	        printf("delay: %d ms.\n", delay);
-	        printf("datamode: %s.\n", ops.args.dumpbin.datamode);
+	        int bits = SerialPort::GetBitsPerByte(ops.args.dumpbin.datamode);
+	        printf("datamode: %s (%d bits per byte, %d B/s on the wire).\n",
+	                ops.args.dumpbin.datamode, bits, baud / bits);
 	        printf("filename: %s.\n", ops.args.dumpbin.filename);
-	        printf("filesize: %d bytes.\n", filesize);
+	        if(filesize == SBDOP_FILESIZE_UNKNOWN)
+	        {
+	            printf("filesize: unknown (streamed).\n");
+	        }
+	        else
+	        {
+	            printf("filesize: %" PRIu64 " bytes.\n", filesize);
+	        }
 	        printf("burst: %d bytes.\n", burst);
+	        printf("chunk: %d bytes.\n", chunk);
+	        printf("ring: %d blocks.\n", ring_depth);
+	        printf("engine: %s.\n", ops.args.dumpbin.engine);
+	        if(rate > 0)
+	        {
+	            printf("rate: %" PRIu64 " B/s.\n", rate);
+	        }
+	        if(gap > 0)
+	        {
+	            printf("gap: %d us.\n", gap);
+	        }
+
+	        if(ops.args.dumpbin.watch != NULL)
+	        {
+	            SBDOP_WatchAndDump(
+	                    ops.args.dumpbin.watch,
+	                    baud,
+	                    delay,
+	                    burst,
+	                    chunk,
+	                    ring_depth,
+	                    engine,
+	                    rate,
+	                    (uint32_t)gap,
+	                    ops.args.dumpbin.datamode,
+	                    ops.args.dumpbin.filename,
+	                    filesize);
+	            break;
+	        }
+
+	        if(ports.size() > 1)
+	        {
+	            int ec = SBDOP_DumpBinaryToPorts(
+	                    ports,
+	                    baud,
+	                    delay,
+	                    burst,
+	                    chunk,
+	                    ring_depth,
+	                    engine,
+	                    rate,
+	                    (uint32_t)gap,
+	                    ops.args.dumpbin.datamode,
+	                    ops.args.dumpbin.filename,
+	                    filesize);
+	            if(ec == -1)
+	            {
+	                printf("Error! Dumping binary file to some of the ports failed.\n");
+	            }
+	            else
+	            {
+	                printf("Binary file successfully dumped to all the ports.\n");
+	            }
+	            break;
+	        }
 
 	        int ec = SBDOP_DumpBinaryToPort(
-	                portnum,
+	                ops.args.dumpbin.portname,
 	                baud,
 	                delay,
 	                burst,
+	                chunk,
+	                ring_depth,
+	                engine,
+	                rate,
+	                (uint32_t)gap,
 	                ops.args.dumpbin.datamode,
 	                ops.args.dumpbin.filename,
 	                filesize);
@@ -257,6 +512,51 @@ int main(int argc, const char** args)
 
 	        break;
 	    }
+	    case OP_DUMP_MANIFEST:
+	    {
+	        int ring_depth = SBDOP_GetRingDepthFromName(ops.args.dumpbin.ring);
+	        if(ring_depth <= 0 || ring_depth > SBDOP_MAX_RING_DEPTH)
+	        {
+	            printf("Error! Given ring depth: %s is invalid.\n", ops.args.dumpbin.ring);
+	            break;
+	        }
+	        sbdop_engine_t engine = SBDOP_GetEngineFromName(ops.args.dumpbin.engine);
+	        if(engine == SBDOP_ENGINE_INVALID)
+	        {
+	            printf("Error! Given I/O engine: %s is invalid.\n", ops.args.dumpbin.engine);
+	            break;
+	        }
+	        if(ops.args.dumpbin.progress != NULL)
+	        {
+	            sbdop_progress_t progress = SBDOP_GetProgressFromName(ops.args.dumpbin.progress);
+	            if(progress == SBDOP_PROGRESS_INVALID)
+	            {
+	                printf("Error! Given progress format: %s is invalid.\n", ops.args.dumpbin.progress);
+	                break;
+	            }
+	            SBDOP_SetProgressFormat(progress);
+	        }
+	        std::vector<sbdop_step_t> steps;
+	        if(!SBDOP_LoadManifest(ops.args.dumpbin.manifest, steps))
+	        {
+	            break;
+	        }
+
+	        printf("manifest: %s (%u steps).\n", ops.args.dumpbin.manifest, (unsigned int)steps.size());
+	        printf("ring: %d blocks.\n", ring_depth);
+	        printf("engine: %s.\n", ops.args.dumpbin.engine);
+
+	        if(SBDOP_DumpManifest(steps, ring_depth, engine) == -1)
+	        {
+	            printf("Error! Running the manifest failed.\n");
+	        }
+	        else
+	        {
+	            printf("Manifest successfully run.\n");
+	        }
+
+	        break;
+	    }
 	    default:
 	    {
 	        printf("Error! Bad or insufficient arguments given. \n");
@@ -29,45 +29,71 @@
 #include <stdint.h>
 #include <inttypes.h>
 #include <string.h>
+#include <errno.h>
+#include <signal.h>
+#include <math.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <list>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
 
 #if defined(__linux__) || defined(__FreeBSD__)   /* Linux & FreeBSD */
 #include <time.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#if defined(__linux__)
+#include <sys/eventfd.h>
+#endif
 #else
-#include <chrono>
+#include <fcntl.h>
+#include <io.h>
+#include <sys/stat.h>
 using high_res_clock_t = std::chrono::high_resolution_clock;
 using steady_clock_t = std::chrono::steady_clock;
 using milliseconds_t = std::chrono::milliseconds;
 using microseconds_t = std::chrono::microseconds;
 #endif
 
+#include "serialport/SerialHotplug.hpp"
+#include "serialport/SerialPortList.hpp"
+#include "serialport/SerialReactor.hpp"
+#include "serialport/SerialUring.hpp"
 #include "sbdop.h"
 
+//!< Time (in miliseconds) given to a plugged in port to settle (i.e. udev to set its permissions).
+#define SBDOP_WATCH_SETTLE_MS 500
 
-#if defined(__linux__) || defined(__FreeBSD__)   /* Linux & FreeBSD */
-const char* portnames_h[MAX_SYS_COMPORTS] =
-{
-"ttyS0","ttyS1","ttyS2","ttyS3","ttyS4","ttyS5",
-"ttyS6","ttyS7","ttyS8","ttyS9","ttyS10","ttyS11",
-"ttyS12","ttyS13","ttyS14","ttyS15","ttyUSB0",
-"ttyUSB1","ttyUSB2","ttyUSB3","ttyUSB4","ttyUSB5",
-"ttyAMA0","ttyAMA1","ttyACM0","ttyACM1",
-"rfcomm0","rfcomm1","ircomm0","ircomm1",
-"cuau0","cuau1","cuau2","cuau3",
-"cuaU0","cuaU1","cuaU2","cuaU3"
-};
-#else /* windows */
-const char* portnames_h[MAX_SYS_COMPORTS] =
-{
-    "COM1",  "COM2",  "COM3",  "COM4",
-    "COM5",  "COM6",  "COM7",  "COM8",
-    "COM9",  "COM10", "COM11", "COM12",
-    "COM13", "COM14", "COM15", "COM16",
-    "COM17", "COM18", "COM19", "COM20",
-    "COM21", "COM22", "COM23", "COM24",
-    "COM25", "COM26", "COM27", "COM28",
-    "COM29", "COM30", "COM31", "COM32"
-};
-#endif
+//!< Maximum time (in miliseconds) of waiting for hotplug events, before finished dumps are collected.
+#define SBDOP_WATCH_POLL_MS 200
+
+//!< Maximum time (in microseconds) paced bursts may catch up on after being late.
+#define SBDOP_PACE_CATCHUP_US 2000
+
+//!< Maximum wire time (in microseconds) of data kept queued in the port's output buffer.
+#define SBDOP_TXQ_MAX_US 20000
+
+//!< Minimum number of bytes the port's output buffer may hold (for high baud rates).
+#define SBDOP_TXQ_MIN 64
+
+//!< Stride (in bytes) of touching a block of mapped source, so its pages are faulted in by the reader thread.
+#define SBDOP_PAGE_SIZE 4096
+
+//!< How dump progress is reported, see SBDOP_SetProgressFormat().
+static sbdop_progress_t sbdop_progress_format = SBDOP_PROGRESS_TEXT;
+
+//!< Watch mode state, shared with the signal handler.
+static SerialHotplug* sbdop_watch_hotplug = NULL;
+static volatile sig_atomic_t sbdop_watch_stop = 0;
 
 
 void SBDOP_DispHelpInfo(void)
@@ -83,9 +109,25 @@ void SBDOP_DispHelpInfo(void)
     printf("SerialBinaryDumper -h\n\t Displays this help information.\n");
     printf("SerialBinaryDumper -l\n\t Lists serial portnames available on the machine.\n");
     printf("SerialBinaryDumper -p <portname> -f <filename> [<options>]\n\t"
-            "Dumps binary file pointed by filename to the port pointed by portname.\n"
-            "\tMaximum supported filesize is: %d bytes.\n\n",
-            SBDOP_MAX_FILESIZE);
+            "Dumps binary file pointed by filename to the port pointed by portname.\n\t"
+            "Several ports can be given as a comma separated list (i.e. ttyUSB0,ttyUSB1,ttyUSB2):\n\t"
+            "the file is read once and dumped to all of them in parallel, each port paced on its own.\n");
+    printf("SerialBinaryDumper -mf <manifest> [-rd <depth>] [-io <engine>] [-pg <format>]\n\t"
+            "Runs a manifest: ordered dump steps, one per line, each given by options as on the command line:\n\t"
+            "-p <port> [-f <filename> [-of <offset>] [-ln <length>]] [-b, -dm, -dl, -rt, -gp, -bst, -ck] [-wa <wait>]\n\t"
+            "-of/-ln: part of the file to dump (bytes, decimal or 0x hex), -wa: wait (miliseconds) after the step.\n\t"
+            "Options not given take the defaults. Text following '#' is a comment.\n\t"
+            "All the files are loaded before the first step. Steps of a port run in order with the port kept open,\n\t"
+            "ports run in parallel.\n");
+    printf("SerialBinaryDumper -wt <pattern> -f <filename> [<options>]\n\t"
+            "Watch mode: dumps binary file to each port matching pattern as soon as it is plugged in,\n\t"
+            "ports in parallel. Ctrl+C stops watching (dumps in progress are finished first).\n\t"
+            "Pattern is a port pattern (i.e. ttyUSB*, 0403:*) or a device path pattern\n\t"
+            "(i.e. /dev/serial/by-id/*, /tmp/ttyV*, no wildcards in the directory part).\n\n");
+    printf("Streaming: -f - reads the data from stdin (i.e. a pipe from the generator of the image),\n"
+            "-f <fifo> from a named pipe (Linux). The data is sent as it comes, paced the same way,\n"
+            "until the stream ends. Streams are dumped to a single port (no -wt, no port list, no -mf steps)\n"
+            "and burst does not need to divide their size. The uring engine falls back to rw for streams.\n\n");
     printf("Possible options are:\n"
             "-b <baudrate>\t A baudrate (in bps) to open serial port with.\n"
             "Default baudrate is: %s.\n"
@@ -104,11 +146,42 @@ void SBDOP_DispHelpInfo(void)
             SBDOP_MAX_DELAYMS);
     printf("-bst <burst>\t A burst (in terms of number of bytes) used to group the data being dumped to port.\n"
             "Default burst is: %s.\n"
-            "Supported burst value range is: <1, %d>.\n"
+            "Supported burst value range is: <1, size of the file being dumped>.\n"
             "burst cannot be greater than size of the file being dumped, and also such file size needs "
-            "to be dividable by burst.\n\n",
-            SBDOP_DEFAULT_BURST,
-            SBDOP_MAX_FILESIZE);
+            "to be dividable by burst.\n",
+            SBDOP_DEFAULT_BURST);
+    printf("-ck <chunk>\t Maximum number of bytes written to the port at once (by a single write).\n"
+            "Default chunk is: %s.\n"
+            "Supported chunk value range is: <1, %d>.\n"
+            "Chunk is independent of burst: a burst larger than chunk is written in several chunks,\n"
+            "and chunks never span the delay between bursts.\n",
+            SBDOP_DEFAULT_CHUNK,
+            SBDOP_MAX_CHUNK);
+    printf("-rd <depth>\t Depth (in blocks of %d bytes) of the ring between the file reader thread and the port writer.\n"
+            "Default depth is: %s.\n"
+            "Supported depth value range is: <1, %d>.\n"
+            "Stalls of both sides (which one is the bottleneck) are displayed at the end.\n",
+            SBDOP_STREAM_BLOCK_SIZE,
+            SBDOP_DEFAULT_RING_DEPTH,
+            SBDOP_MAX_RING_DEPTH);
+    printf("-io <engine>\t I/O engine: rw (default) or uring.\n"
+            "rw reads the file in a reader thread and writes the port with write() calls.\n"
+            "uring (Linux 5.17+) sends the file with io_uring: linked read and write requests on -rd registered buffers\n"
+            "and timeouts for the delays, a few system calls per -rd blocks. A single thread keeps all the ports busy\n"
+            "(-p list, manifest). Falls back to rw if io_uring is not available.\n\n");
+    printf("-rt <rate>\t Target rate (bytes/s) to pace bursts with, i.e. 40000, 40000B/s, 40kB/s.\n"
+            "-gp <gap>\t Time (in microseconds) between starts of consecutive bursts.\n"
+            "Paced bursts start on absolute deadlines, so the rate does not drift. Use -bst to set the burst\n"
+            "(the largest amount of data sent at once). Achieved rate and burst start jitter are displayed at the end.\n"
+            "Pacing cannot be combined with delay (-dl), -rt and -gp cannot be combined with each other.\n\n");
+    printf("-pg <format>\t Progress format: text (default), line (machine-readable), none.\n"
+            "Progress is reported every %d ms: bytes sent, percentage, rate, ETA and jitter of paced bursts.\n"
+            "line format prints a line per report:\n"
+            "progress port=<port> sent=<bytes> size=<bytes> percent=<0-100> rate=<bytes/s> eta_s=<s> "
+            "[jitter_us=<mean> jitter_max_us=<max>] state=<running|done|failed>\n"
+            "Streams (-f -) report bytes sent and rate only, size, percent and eta_s are left out.\n"
+            "With several ports and in watch mode text progress is not displayed (dumps run in parallel), line progress is.\n\n",
+            SBDOP_PROGRESS_INTERVAL_MS);
 #if defined(__linux__) || defined(__FreeBSD__)   /* Linux & FreeBSD */
     printf("Sample invocations:\n"
             "sudo SerialBinaryDumper -l \n"
@@ -138,18 +211,6 @@ void SBDOP_DispHelpInfo(void)
 #endif
 }
 
-int SBDOP_GetComPortNumFromName(const char* portname)
-{
-    if(portname == NULL)
-    {
-        return -1;
-    }
-    else
-    {
-        return RS232_GetPortnr(portname);
-    }
-}
-
 int SBDOP_GetBaudRateFromName(const char* baudrate)
 {
     if(baudrate == NULL)
@@ -315,61 +376,116 @@ uint8_t SBDOP_ValidDataMode(const char* datamode)
 
 uint8_t SBDOP_ValidFile(
         const char* filename,
-        uint32_t* filesize)
+        uint64_t* filesize)
 {
     if(filename == NULL)
     {
         return FALSE;
     }
 
-    FILE* binfile = fopen(filename, "rb");
-    if(binfile == NULL)
+    // streams: size is known once they end
+    if(strcmp(filename, "-") == 0)
     {
-        return FALSE;
+        if(filesize != NULL)
+        {
+            *filesize = SBDOP_FILESIZE_UNKNOWN;
+        }
+        return TRUE;
     }
-
-    uint8_t temp = 0;
-    uint32_t size = 0;
-    while((feof(binfile) == 0) && (size < SBDOP_MAX_FILESIZE))
+#if defined(__linux__) || defined(__FreeBSD__)   /* Linux & FreeBSD */
+    // FIFO is not opened here, open blocks until its writer opens it
+    struct stat fifo_st;
+    if((stat(filename, &fifo_st) == 0) && S_ISFIFO(fifo_st.st_mode))
     {
-        int ec = fread(&temp, 1, 1, binfile);
-        if(ec == 0) // fread tells us nothing new read, end-of-file reached or error occured
+        if(access(filename, R_OK) != 0)
         {
-            break;
+            return FALSE;
         }
-        size++;
+        if(filesize != NULL)
+        {
+            *filesize = SBDOP_FILESIZE_UNKNOWN;
+        }
+        return TRUE;
     }
+#endif
 
-    if(feof(binfile) == 0) // end-of-file not reached due to max size exceed
+    FILE* binfile = fopen(filename, "rb");
+    if(binfile == NULL)
     {
         return FALSE;
     }
 
-    if(filesize != NULL)
+    // size is taken from the file system, the file is not read
+#if defined(__linux__) || defined(__FreeBSD__)   /* Linux & FreeBSD */
+    struct stat st;
+    int ec = fstat(fileno(binfile), &st);
+#else
+    struct _stati64 st;
+    int ec = _fstati64(_fileno(binfile), &st);
+#endif
+    fclose(binfile);
+
+    if((ec != 0) || !S_ISREG(st.st_mode))
     {
-        *filesize = size;
+        return FALSE;
     }
 
-    fclose(binfile);
+    if(filesize != NULL)
+    {
+        *filesize = (uint64_t)st.st_size;
+    }
 
     return TRUE;
 }
 
 uint8_t SBDOP_ValidComPort(const char* portname)
 {
-    int portnum = SBDOP_GetComPortNumFromName(portname);
-    if(portnum == -1)
+    if(portname == NULL)
     {
         return FALSE;
     }
 
-    if(RS232_OpenComport(portnum, 9600, "8n1", 0) != 0)
+    SerialPort port;
+    if(port.Open(portname, 9600, "8n1") != EC_OK)
     {
         return FALSE;
     }
-    else
+
+    return TRUE;
+}
+
+uint8_t SBDOP_GetPortNames(
+        const char* portnames,
+        std::vector<std::string>& ports)
+{
+    ports.clear();
+    if(portnames == NULL)
+    {
+        return FALSE;
+    }
+
+    const char* name = portnames;
+    while(true)
     {
-        RS232_CloseComport(portnum);
+        const char* comma = strchr(name, ',');
+        std::string port = (comma != NULL) ? std::string(name, comma - name) : std::string(name);
+        if(port.empty())
+        {
+            return FALSE;
+        }
+        for(size_t i = 0; i < ports.size(); i++)
+        {
+            if(ports[i] == port)
+            {
+                return FALSE;
+            }
+        }
+        ports.push_back(port);
+        if(comma == NULL)
+        {
+            break;
+        }
+        name = comma + 1;
     }
 
     return TRUE;
@@ -402,9 +518,99 @@ int SBDOP_GetBurstFromName(const char* burst)
     return SBDOP_GetDelayFromName(burst);
 }
 
+int SBDOP_GetChunkFromName(const char* chunk)
+{
+    return SBDOP_GetDelayFromName(chunk);
+}
+
+int SBDOP_GetRingDepthFromName(const char* ring)
+{
+    return SBDOP_GetDelayFromName(ring);
+}
+
+sbdop_engine_t SBDOP_GetEngineFromName(const char* engine)
+{
+    if(engine == NULL)
+    {
+        return SBDOP_ENGINE_INVALID;
+    }
+
+    if(strcmp(engine, "rw") == 0)
+    {
+        return SBDOP_ENGINE_RW;
+    }
+    if(strcmp(engine, "uring") == 0)
+    {
+        return SBDOP_ENGINE_URING;
+    }
+
+    return SBDOP_ENGINE_INVALID;
+}
+
+uint64_t SBDOP_GetRateFromName(const char* rate)
+{
+    if(rate == NULL)
+    {
+        return 0;
+    }
+
+    char* end = NULL;
+    double val = strtod(rate, &end);
+    if((end == rate) || (val <= 0))
+    {
+        return 0;
+    }
+
+    // optional multiplier, then optional unit
+    if((*end == 'k') || (*end == 'K'))
+    {
+        val *= 1000;
+        end++;
+    }
+    else if(*end == 'M')
+    {
+        val *= 1000000;
+        end++;
+    }
+    if((strcmp(end, "") != 0) && (strcmp(end, "B/s") != 0))
+    {
+        return 0;
+    }
+
+    return (uint64_t)val;
+}
+
+sbdop_progress_t SBDOP_GetProgressFromName(const char* progress)
+{
+    if(progress == NULL)
+    {
+        return SBDOP_PROGRESS_INVALID;
+    }
+
+    if(strcmp(progress, "text") == 0)
+    {
+        return SBDOP_PROGRESS_TEXT;
+    }
+    if(strcmp(progress, "line") == 0)
+    {
+        return SBDOP_PROGRESS_LINE;
+    }
+    if(strcmp(progress, "none") == 0)
+    {
+        return SBDOP_PROGRESS_NONE;
+    }
+
+    return SBDOP_PROGRESS_INVALID;
+}
+
+void SBDOP_SetProgressFormat(sbdop_progress_t format)
+{
+    sbdop_progress_format = format;
+}
+
 uint8_t SBDOP_ValidBurst(
         uint32_t burst,
-        uint32_t datasize)
+        uint64_t datasize)
 {
     if(burst == 0)
     {
@@ -426,115 +632,2573 @@ uint8_t SBDOP_ValidBurst(
 
 void SBDOP_ListComPorts(void)
 {
-    uint8_t cp_found = 0;
+    std::vector<SerialPortList::port_info_t> ports = SerialPortList::Get();
 
-    for(uint8_t i = 0; i < MAX_SYS_COMPORTS; i++)
+    for(size_t i = 0; i < ports.size(); i++)
     {
-        int port_num = SBDOP_GetComPortNumFromName(portnames_h[i]);
-        if(port_num == -1)
+        const SerialPortList::port_info_t& port = ports[i];
+        printf("%s", port.name.c_str());
+        if(!port.driver.empty())
         {
-            printf("Error! Failed to list serial portnames. \n");
-            break;
+            printf(" [%s]", port.driver.c_str());
+        }
+        if(port.vid != 0)
+        {
+            printf(" %s", SerialPortList::GetUsbId(port).c_str());
         }
-        if(RS232_OpenComport(port_num, 9600, "8n1", 0) == 0)
+        if(!port.serial.empty())
         {
-            printf("%s\n",portnames_h[i]);
-            RS232_CloseComport(port_num);
-            cp_found++;
+            printf(" SN:%s", port.serial.c_str());
         }
+        if(!port.byIdPath.empty())
+        {
+            printf(" %s", port.byIdPath.c_str());
+        }
+        printf("\n");
     }
-    printf("Total serial ports found: %d. \n", cp_found);
+    printf("Total serial ports found: %d. \n", static_cast<int>(ports.size()));
 
     return;
 }
 
-int SBDOP_DumpBinaryToPort(
-        int portnum,
-        int baud,
-        int delay_ms,
-        int burst,
-        const char* datamode,
+/*
+ * Source of the data being dumped.
+ * The file is mapped into memory and slices of the mapping are handed to the port writer,
+ * files that cannot be mapped (i.e. pipes) are streamed through a block buffer.
+ */
+typedef struct
+{
+    const uint8_t* data; //!< unsent data: mapping or block buffer
+    size_t size; //!< size of data
+    size_t pos; //!< offset of the next byte to send within data
+#if defined(__linux__) || defined(__FreeBSD__)   /* Linux & FreeBSD */
+    void* map; //!< file mapping, NULL if streaming
+    int stop_fd; //!< readable when waiting for streamed data shall stop, -1 if none
+#endif
+    FILE* file; //!< streamed file, NULL if mapped
+    uint8_t* block; //!< block buffer of streamed file
+}sbdop_source_t;
+
+/*
+ * @brief Opens source of the data to be dumped.
+ * @param filename Name of the file, "-" for stdin.
+ * @param filesize Number of bytes to be dumped (size of the file), SBDOP_FILESIZE_UNKNOWN for streams.
+ * @retval TRUE If opened.
+ * @retval FALSE If failed.
+ */
+static uint8_t SBDOP_SourceOpen(
+        sbdop_source_t* src,
         const char* filename,
-        uint32_t filesize)
+        uint64_t filesize)
 {
-    int ret = 0;
-    if(datamode == NULL || filename == NULL)
+    memset(src, 0, sizeof(*src));
+
+#if defined(__linux__) || defined(__FreeBSD__)   /* Linux & FreeBSD */
+    src->stop_fd = -1;
+    int fd = (strcmp(filename, "-") == 0) ? fcntl(STDIN_FILENO, F_DUPFD_CLOEXEC, 0) : open(filename, O_RDONLY | O_CLOEXEC);
+    if(fd == -1)
     {
-        return -1;
+        return FALSE;
     }
+    struct stat st;
+    // file too big for the address space (32-bit build) is streamed
+    if((filesize > 0) && (filesize <= (uint64_t)SIZE_MAX) &&
+       (fstat(fd, &st) == 0) && S_ISREG(st.st_mode) && ((uint64_t)st.st_size >= filesize))
+    {
+        void* map = mmap(NULL, (size_t)filesize, PROT_READ, MAP_PRIVATE, fd, 0);
+        if(map != MAP_FAILED)
+        {
+            // data is read once, front to back: aggressive read-ahead, pages dropped behind
+            madvise(map, (size_t)filesize, MADV_SEQUENTIAL);
+            posix_fadvise(fd, 0, (off_t)filesize, POSIX_FADV_SEQUENTIAL);
+            posix_fadvise(fd, 0, (off_t)filesize, POSIX_FADV_WILLNEED);
+            close(fd); // mapping stays valid
 
-    int ec = RS232_OpenComport(portnum, baud, datamode, 0);
-    if(ec != 0)
+            src->map = map;
+            src->data = (const uint8_t*)map;
+            src->size = (size_t)filesize;
+            return TRUE;
+        }
+    }
+    // pipes are not reopened: data written already would be lost
+    src->file = fdopen(fd, "rb");
+    if(src->file == NULL)
     {
-        printf("Error! Unable to open serial port.\n");
-        return -1;
+        close(fd);
+    }
+#else
+    if(strcmp(filename, "-") == 0)
+    {
+        _setmode(_fileno(stdin), _O_BINARY);
+        src->file = _fdopen(_dup(_fileno(stdin)), "rb");
+    }
+    else
+    {
+        src->file = fopen(filename, "rb");
     }
+#endif
 
-    FILE* binfile = fopen(filename, "rb");
-    if(binfile == NULL)
+    src->block = (uint8_t*)malloc(SBDOP_STREAM_BLOCK_SIZE);
+    if((src->file == NULL) || (src->block == NULL))
     {
-        return -1;
+        if(src->file != NULL)
+        {
+            fclose(src->file);
+        }
+        free(src->block);
+        memset(src, 0, sizeof(*src));
+        return FALSE;
     }
+    src->data = src->block;
 
-    uint8_t data;
-    int burst_cnt = 0;
-    for(uint32_t i = 0; i < filesize; i++)
+    return TRUE;
+}
+
+/*
+ * @brief Returns a slice of unsent data, without copying it.
+ * @details Waiting for streamed data ends when src->stop_fd becomes readable.
+ * @param data A pointer where this function will save the address of the slice.
+ * @retval >0 Size of the slice (in bytes).
+ * @retval 0 End-of-file reached, error or stopped.
+ */
+static size_t SBDOP_SourcePeek(
+        sbdop_source_t* src,
+        const uint8_t** data)
+{
+    if((src->pos == src->size) && (src->file != NULL))
     {
-        uint16_t perc = SBDOP_PercentageCompletion((i+1), filesize);
-        if(perc != 0xffff)
+#if defined(__linux__) || defined(__FreeBSD__)   /* Linux & FreeBSD */
+        // an idle writer must not keep the dump from stopping
+        struct pollfd fds[2];
+        fds[0].fd = fileno(src->file);
+        fds[0].events = POLLIN;
+        fds[1].fd = src->stop_fd;
+        fds[1].events = POLLIN;
+        int ready;
+        do
+        {
+            fds[0].revents = 0;
+            fds[1].revents = 0;
+            ready = poll(fds, (src->stop_fd != -1) ? 2 : 1, -1);
+        }while((ready == -1) && (errno == EINTR));
+
+        ssize_t n = -1;
+        if((ready > 0) && !(fds[1].revents & POLLIN))
         {
-            if(i == 0 && filesize == 1)
+            // a pipe returns what is there, so data of a slow writer is sent without waiting for a full block
+            do
             {
-                printf("Progress: %d%%\n", perc);
-            }
-            else if(i == 0)
+                n = read(fds[0].fd, src->block, SBDOP_STREAM_BLOCK_SIZE);
+            }while((n == -1) && (errno == EINTR));
+        }
+        src->size = (n > 0) ? (size_t)n : 0;
+#else
+        src->size = fread(src->block, 1, SBDOP_STREAM_BLOCK_SIZE, src->file);
+#endif
+        src->pos = 0;
+    }
+
+    *data = src->data + src->pos;
+
+    return src->size - src->pos;
+}
+
+//!< Marks size bytes of the slice returned by SBDOP_SourcePeek() as sent.
+static void SBDOP_SourceConsume(
+        sbdop_source_t* src,
+        size_t size)
+{
+    src->pos += size;
+}
+
+//!< Closes source opened by SBDOP_SourceOpen().
+static void SBDOP_SourceClose(sbdop_source_t* src)
+{
+#if defined(__linux__) || defined(__FreeBSD__)   /* Linux & FreeBSD */
+    if(src->map != NULL)
+    {
+        munmap(src->map, src->size);
+    }
+#endif
+    if(src->file != NULL)
+    {
+        fclose(src->file);
+    }
+    free(src->block);
+    memset(src, 0, sizeof(*src));
+}
+
+/*
+ * @brief Reads the rest of streamed source into memory, so it can be shared (see SBDOP_SourceView()).
+ * @details Mapped source is in memory already.
+ * @retval TRUE If the whole source is in memory.
+ * @retval FALSE If failed (i.e. file too big for the address space), the source stays as it was.
+ */
+static uint8_t SBDOP_SourceLoad(
+        sbdop_source_t* src,
+        uint64_t filesize)
+{
+    if(src->file == NULL)
+    {
+        return TRUE;
+    }
+    if(filesize > (uint64_t)SIZE_MAX)
+    {
+        return FALSE;
+    }
+
+    uint8_t* image = (uint8_t*)malloc((filesize > 0) ? (size_t)filesize : 1);
+    if(image == NULL)
+    {
+        return FALSE;
+    }
+    size_t size = fread(image, 1, (size_t)filesize, src->file);
+
+    fclose(src->file);
+    free(src->block);
+    src->file = NULL;
+    src->block = image; // freed by SBDOP_SourceClose()
+    src->data = image;
+    src->size = size;
+    src->pos = 0;
+
+    return TRUE;
+}
+
+//!< Sets view up as a read-only source of size bytes at offset of image (mapped or loaded), closing view does not release the data.
+static void SBDOP_SourceView(
+        sbdop_source_t* view,
+        const sbdop_source_t* image,
+        uint64_t offset,
+        uint64_t size)
+{
+    memset(view, 0, sizeof(*view));
+#if defined(__linux__) || defined(__FreeBSD__)   /* Linux & FreeBSD */
+    view->stop_fd = -1;
+#endif
+    if(offset > image->size)
+    {
+        offset = image->size;
+    }
+    if(size > (image->size - offset))
+    {
+        size = image->size - offset;
+    }
+    view->data = image->data + offset;
+    view->size = (size_t)size;
+}
+
+/*
+ * Ring of blocks between the reader thread (file I/O) and the dump (port I/O),
+ * so a stall on one side (i.e. slow network file system, full tty buffer) does not stall the other.
+ * Blocks of a source in memory (mapped or loaded) are slices of it, the reader only faults their pages in,
+ * streamed sources are copied into the ring's own buffers.
+ * Single producer, single consumer: blocks are passed by head/tail counters only,
+ * the mutex and the condition variable are used just to sleep on an empty or full ring.
+ */
+typedef struct
+{
+    uint8_t* blocks; //!< depth buffers of SBDOP_STREAM_BLOCK_SIZE bytes, NULL if the source is in memory
+    const uint8_t** data; //!< data of each block: its buffer or a slice of the source
+    size_t* sizes; //!< number of bytes in each block
+    uint32_t depth;
+    std::atomic<uint64_t> head; //!< blocks filled by the reader
+    std::atomic<uint64_t> tail; //!< blocks sent by the dump
+    std::atomic<bool> eof; //!< reader is done (end-of-file or read error), no more blocks
+    std::atomic<bool> stop; //!< dump is done, reader shall stop
+#if defined(__linux__) || defined(__FreeBSD__)   /* Linux & FreeBSD */
+    sbdop_source_t* src; //!< source the reader fills the ring from
+    int stop_fds[2]; //!< pipe waking the reader up from waiting for streamed data on stop, -1 if none
+#endif
+    std::atomic<bool> reader_waiting;
+    std::atomic<bool> writer_waiting;
+    std::mutex mutex;
+    std::condition_variable cv;
+    size_t pos; //!< offset of the next byte to send within the block at tail
+    std::thread reader;
+    uint64_t reader_stalls; //!< reader found the ring full (port is the bottleneck)
+    uint64_t reader_stall_us;
+    uint64_t writer_stalls; //!< dump found the ring empty (file is the bottleneck)
+    uint64_t writer_stall_us;
+}sbdop_ring_t;
+
+//!< Wakes up the other side of the ring, if it sleeps.
+static void SBDOP_RingWake(
+        sbdop_ring_t* ring,
+        std::atomic<bool>* waiting)
+{
+    if(waiting->load())
+    {
+        // the sleeper either has not checked the ring yet, or already waits on cv
+        std::lock_guard<std::mutex> lock(ring->mutex);
+    }
+    ring->cv.notify_one();
+}
+
+/*
+ * @brief Sleeps until ready() returns true.
+ * @param stall_cnt, stall_us Stall counters of the sleeping side.
+ */
+template<typename Ready>
+static void SBDOP_RingSleep(
+        sbdop_ring_t* ring,
+        std::atomic<bool>* waiting,
+        uint64_t* stall_cnt,
+        uint64_t* stall_us,
+        Ready ready)
+{
+    auto start = std::chrono::steady_clock::now();
+    {
+        std::unique_lock<std::mutex> lock(ring->mutex);
+        waiting->store(true);
+        ring->cv.wait(lock, ready);
+        waiting->store(false);
+    }
+    (*stall_cnt)++;
+    *stall_us += (uint64_t)std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now() - start).count();
+}
+
+//!< Reader thread: fills the ring from src, until end-of-file or the dump stops.
+static void SBDOP_RingReader(
+        sbdop_ring_t* ring,
+        sbdop_source_t* src,
+        uint64_t filesize)
+{
+    uint64_t read = 0;
+    while((read < filesize) && !ring->stop)
+    {
+        uint64_t head = ring->head.load(std::memory_order_relaxed);
+        if((head - ring->tail.load(std::memory_order_acquire)) == ring->depth)
+        {
+            SBDOP_RingSleep(ring, &ring->reader_waiting, &ring->reader_stalls, &ring->reader_stall_us,
+                    [ring, head]() { return ((head - ring->tail.load()) < ring->depth) || ring->stop; });
+            continue;
+        }
+
+        const uint8_t* data = NULL;
+        size_t size = 0;
+        if(src->file == NULL)
+        {
+            // source is in memory already, the block is a slice of it
+            size = SBDOP_SourcePeek(src, &data);
+            if(size > SBDOP_STREAM_BLOCK_SIZE)
             {
-                printf("Progress: %d%% ", perc);
+                size = SBDOP_STREAM_BLOCK_SIZE;
             }
-            else if(i > 0 && i < (filesize-1))
+            if(size > (filesize - read))
             {
-                putchar(0x0D);
-                printf("Progress: %d%% ", perc);
+                size = (size_t)(filesize - read);
             }
-            else // i > 0 && i == filesize-1
+            // page faults (file I/O of a mapping) are taken here rather than by the dump
+            for(size_t i = 0; i < size; i += SBDOP_PAGE_SIZE)
             {
-                putchar(0x0D);
-                printf("Progress: %d%%\n", perc);
+                (void)((const volatile uint8_t*)data)[i];
             }
+            SBDOP_SourceConsume(src, size);
+            read += size;
         }
-
-        ec = fread(&data, 1, 1, binfile);
-        if(ec == 0) // nothing read
-        {
-            printf("Error! Unexpected end-of-file reached.\n");
-            ret = -1;
-            break;
-        }
-
-        ec = RS232_SendByte(portnum, data);
-        if(ec == 1)
+        else
         {
-            printf("Error! Failed to send data.\n");
-            ret = -1;
-            break;
+            uint8_t* block = ring->blocks + ((head % ring->depth) * SBDOP_STREAM_BLOCK_SIZE);
+            while((size < SBDOP_STREAM_BLOCK_SIZE) && (read < filesize))
+            {
+                size_t n = SBDOP_SourcePeek(src, &data);
+                if(n == 0)
+                {
+                    break;
+                }
+                if(n > (SBDOP_STREAM_BLOCK_SIZE - size))
+                {
+                    n = SBDOP_STREAM_BLOCK_SIZE - size;
+                }
+                if(n > (filesize - read))
+                {
+                    n = (size_t)(filesize - read);
+                }
+                memcpy(block + size, data, n);
+                SBDOP_SourceConsume(src, n);
+                size += n;
+                read += n;
+                if(src->pos == src->size)
+                {
+                    break; // streamed data is sent as it comes, the next read may wait for the writer
+                }
+            }
+            data = block;
         }
-        burst_cnt++;
-        if(burst_cnt == burst)
+        if(size == 0)
         {
-            burst_cnt = 0;
-            SBDOP_Delay(delay_ms);
+            break; // unexpected end-of-file, the dump finds out on the empty ring
         }
+
+        ring->data[head % ring->depth] = data;
+        ring->sizes[head % ring->depth] = size;
+        ring->head.store(head + 1);
+        SBDOP_RingWake(ring, &ring->writer_waiting);
     }
 
-    RS232_CloseComport(portnum);
-    fclose(binfile);
+    ring->eof.store(true);
+    SBDOP_RingWake(ring, &ring->writer_waiting);
+}
+
+/*
+ * @brief Allocates the ring of depth blocks and starts the reader thread filling it from src.
+ * @retval TRUE If started.
+ * @retval FALSE If failed (out of memory).
+ */
+static uint8_t SBDOP_RingStart(
+        sbdop_ring_t* ring,
+        uint32_t depth,
+        sbdop_source_t* src,
+        uint64_t filesize)
+{
+    ring->blocks = NULL;
+    if(src->file != NULL)
+    {
+        ring->blocks = (uint8_t*)malloc((size_t)depth * SBDOP_STREAM_BLOCK_SIZE);
+    }
+    ring->data = (const uint8_t**)malloc((size_t)depth * sizeof(const uint8_t*));
+    ring->sizes = (size_t*)malloc((size_t)depth * sizeof(size_t));
+    if(((ring->blocks == NULL) && (src->file != NULL)) || (ring->data == NULL) || (ring->sizes == NULL))
+    {
+        free(ring->blocks);
+        free(ring->data);
+        free(ring->sizes);
+        return FALSE;
+    }
+#if defined(__linux__) || defined(__FreeBSD__)   /* Linux & FreeBSD */
+    ring->stop_fds[0] = -1;
+    ring->stop_fds[1] = -1;
+    if((src->file != NULL) && (pipe2(ring->stop_fds, O_CLOEXEC | O_NONBLOCK) != 0))
+    {
+        free(ring->blocks);
+        free(ring->data);
+        free(ring->sizes);
+        return FALSE;
+    }
+    ring->src = src;
+    src->stop_fd = ring->stop_fds[0];
+#endif
+    ring->depth = depth;
+    ring->head = 0;
+    ring->tail = 0;
+    ring->eof = false;
+    ring->stop = false;
+    ring->reader_waiting = false;
+    ring->writer_waiting = false;
+    ring->pos = 0;
+    ring->reader_stalls = 0;
+    ring->reader_stall_us = 0;
+    ring->writer_stalls = 0;
+    ring->writer_stall_us = 0;
+    ring->reader = std::thread(SBDOP_RingReader, ring, src, filesize);
+
+    return TRUE;
+}
+
+/*
+ * @brief Returns unsent data of the block at the tail of the ring, without copying it.
+ * @details Sleeps while the ring is empty.
+ * @param data A pointer where this function will save the address of the data.
+ * @retval >0 Size of the data (in bytes).
+ * @retval 0 Reader is done and the ring is empty (end-of-file reached or read error).
+ */
+static size_t SBDOP_RingPeek(
+        sbdop_ring_t* ring,
+        const uint8_t** data)
+{
+    uint64_t tail = ring->tail.load(std::memory_order_relaxed);
+    if(ring->head.load(std::memory_order_acquire) == tail)
+    {
+        if(ring->eof && (ring->head.load() == tail))
+        {
+            return 0;
+        }
+        SBDOP_RingSleep(ring, &ring->writer_waiting, &ring->writer_stalls, &ring->writer_stall_us,
+                [ring, tail]() { return (ring->head.load() != tail) || ring->eof; });
+        if(ring->head.load(std::memory_order_acquire) == tail)
+        {
+            return 0;
+        }
+    }
+
+    *data = ring->data[tail % ring->depth] + ring->pos;
+
+    return ring->sizes[tail % ring->depth] - ring->pos;
+}
+
+//!< Marks size bytes of the data returned by SBDOP_RingPeek() as sent, passing done blocks back to the reader.
+static void SBDOP_RingConsume(
+        sbdop_ring_t* ring,
+        size_t size)
+{
+    uint64_t tail = ring->tail.load(std::memory_order_relaxed);
+    ring->pos += size;
+    if(ring->pos == ring->sizes[tail % ring->depth])
+    {
+        ring->pos = 0;
+        ring->tail.store(tail + 1);
+        SBDOP_RingWake(ring, &ring->reader_waiting);
+    }
+}
+
+//!< Stops the reader thread and frees the ring.
+static void SBDOP_RingStop(sbdop_ring_t* ring)
+{
+    ring->stop.store(true);
+    SBDOP_RingWake(ring, &ring->reader_waiting);
+#if defined(__linux__) || defined(__FreeBSD__)   /* Linux & FreeBSD */
+    if(ring->stop_fds[1] != -1)
+    {
+        uint8_t one = 1;
+        ssize_t r = write(ring->stop_fds[1], &one, sizeof(one));
+        (void)r;
+    }
+#endif
+    ring->reader.join();
+#if defined(__linux__) || defined(__FreeBSD__)   /* Linux & FreeBSD */
+    if(ring->stop_fds[1] != -1)
+    {
+        close(ring->stop_fds[0]);
+        close(ring->stop_fds[1]);
+        ring->src->stop_fd = -1;
+    }
+#endif
+    free(ring->blocks);
+    free(ring->data);
+    free(ring->sizes);
+    ring->blocks = NULL;
+    ring->data = NULL;
+    ring->sizes = NULL;
+}
+
+//!< Displays stall counters of both sides of the ring, lines prefixed with tag (see SBDOP_PaceReport()).
+static void SBDOP_RingReport(
+        sbdop_ring_t* ring,
+        const char* tag)
+{
+    printf("%sPipeline stalls: reader (ring full) %" PRIu64 " times, %.1f ms; "
+            "writer (ring empty) %" PRIu64 " times, %.1f ms.\n",
+            tag,
+            ring->reader_stalls,
+            (double)ring->reader_stall_us / 1000,
+            ring->writer_stalls,
+            (double)ring->writer_stall_us / 1000);
+}
+
+/*
+ * Pacing of bursts (see -rt, -gp options): a token bucket refilled with a burst every period.
+ * Bursts start on absolute deadlines (start + n * period), so sleep inaccuracies do not add up.
+ * Bursts that are late are sent right away to catch up, the bucket holds up to
+ * SBDOP_PACE_CATCHUP_US worth of bursts (at least one), older credit is dropped.
+ */
+typedef struct
+{
+    uint64_t period_ns; //!< time between starts of consecutive bursts, 0 if pacing is disabled
+    std::chrono::steady_clock::time_point first; //!< start of the first burst
+    std::chrono::steady_clock::time_point deadline; //!< start of the next burst
+    std::atomic<uint64_t> bursts; //!< bursts started
+    std::atomic<double> late_sum_us; //!< sum of burst start latenesses (wake up time - deadline)
+    double late_sq_sum_us; //!< sum of squares of latenesses
+    std::atomic<double> late_max_us;
+}sbdop_pace_t;
+
+//!< Sets up pacing of bursts, either given by rate (bytes/s) or by gap_us (microseconds).
+static void SBDOP_PaceInit(
+        sbdop_pace_t* pace,
+        uint64_t rate,
+        uint32_t gap_us,
+        int burst)
+{
+    pace->bursts = 0;
+    pace->late_sum_us = 0;
+    pace->late_sq_sum_us = 0;
+    pace->late_max_us = 0;
+    if(rate > 0)
+    {
+        pace->period_ns = ((uint64_t)burst * 1000000000ull) / rate;
+    }
+    else
+    {
+        pace->period_ns = (uint64_t)gap_us * 1000ull;
+    }
+    pace->first = std::chrono::steady_clock::now();
+    pace->deadline = pace->first;
+}
+
+//!< Sleeps until the absolute deadline.
+static void SBDOP_SleepUntil(std::chrono::steady_clock::time_point deadline)
+{
+#if defined(__linux__)
+    // steady_clock is CLOCK_MONOTONIC
+    uint64_t ns = (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+            deadline.time_since_epoch()).count();
+    struct timespec ts;
+    ts.tv_sec = (time_t)(ns / 1000000000ull);
+    ts.tv_nsec = (long)(ns % 1000000000ull);
+    while(clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL) == EINTR)
+    {
+    }
+#else
+    std::this_thread::sleep_until(deadline);
+#endif
+}
+
+//!< Moves the deadline to the start of the next burst and returns it.
+static std::chrono::steady_clock::time_point SBDOP_PaceAdvance(sbdop_pace_t* pace)
+{
+    auto period = std::chrono::nanoseconds(pace->period_ns);
+    auto now = std::chrono::steady_clock::now();
+
+    auto catchup = std::chrono::nanoseconds(SBDOP_PACE_CATCHUP_US * 1000ull);
+    if(catchup < period)
+    {
+        catchup = period;
+    }
+
+    pace->deadline += period;
+    if(pace->deadline + catchup < now)
+    {
+        // too far behind, the bucket is full: drop the rest of the credit
+        pace->deadline = now - catchup;
+    }
+
+    return pace->deadline;
+}
+
+/*
+ * @brief Waits for the start of the next burst.
+ * @details Called at the end of each burst (the first one starts right away).
+ */
+static void SBDOP_PaceNextBurst(sbdop_pace_t* pace)
+{
+    SBDOP_SleepUntil(SBDOP_PaceAdvance(pace));
+
+    double late_us = (double)std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - pace->deadline).count() / 1000.0;
+    if(late_us < 0)
+    {
+        late_us = 0;
+    }
+    // written by the dump only, read by the progress reporter
+    pace->late_sum_us.store(pace->late_sum_us.load(std::memory_order_relaxed) + late_us, std::memory_order_relaxed);
+    pace->late_sq_sum_us += late_us * late_us;
+    if(late_us > pace->late_max_us.load(std::memory_order_relaxed))
+    {
+        pace->late_max_us.store(late_us, std::memory_order_relaxed);
+    }
+    pace->bursts.store(pace->bursts.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+}
+
+/*
+ * @brief Displays achieved rate and burst start jitter.
+ * @param tag Prefix of the lines (i.e. "ttyUSB0: " when dumping to several ports), "" if none.
+ */
+static void SBDOP_PaceReport(
+        sbdop_pace_t* pace,
+        uint64_t sent,
+        uint64_t rate,
+        const char* tag)
+{
+    double elapsed_s = (double)std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - pace->first).count() / 1e9;
+    if(elapsed_s > 0)
+    {
+        // a single printf per line, so lines of parallel dumps do not interleave
+        char target[48] = "";
+        if(rate > 0)
+        {
+            snprintf(target, sizeof(target), " (target: %" PRIu64 " B/s)", rate);
+        }
+        printf("%sAchieved rate: %.0f B/s%s.\n", tag, (double)sent / elapsed_s, target);
+    }
+    if(pace->bursts > 0)
+    {
+        double mean = pace->late_sum_us / (double)pace->bursts.load();
+        double var = (pace->late_sq_sum_us / (double)pace->bursts.load()) - (mean * mean);
+        printf("%sBurst start jitter: mean %.1f us, stddev %.1f us, max %.1f us (%" PRIu64 " bursts).\n",
+                tag,
+                mean,
+                sqrt((var > 0) ? var : 0),
+                pace->late_max_us.load(),
+                pace->bursts.load());
+    }
+}
+
+/*
+ * State of a single dump, shared by the blocking and the reactor driven loop.
+ */
+typedef struct
+{
+    const char* portname;
+    const char* tag; //!< prefix of messages, see SBDOP_PaceReport()
+    SerialPort* port;
+    sbdop_ring_t* ring;
+    uint64_t file_offset; //!< offset of the dumped data within the file (read by the io_uring engine)
+    std::atomic<uint64_t> filesize; //!< SBDOP_FILESIZE_UNKNOWN for a stream, until it ends
+    uint8_t stream; //!< size of the data is not known up front
+    std::atomic<uint64_t> sent; //!< bytes sent so far, written by the dump only, read by the progress reporter
+    int burst;
+    int burst_cnt; //!< bytes sent in the current burst
+    int chunk; //!< maximum number of bytes sent by a single write
+    int delay_ms;
+    sbdop_pace_t pace;
+    uint64_t byte_ns; //!< time a byte takes on the wire (baud rate and data mode)
+    uint64_t txq_max; //!< maximum number of bytes kept queued in the port's output buffer
+    std::chrono::steady_clock::time_point wire_idle; //!< when bytes written so far leave the wire (model)
+    uint8_t uring; //!< sent by the io_uring engine, which does not measure burst start jitter
+    int ret;
+}sbdop_dump_t;
+
+//!< Returns TRUE if bursts are separated (by delay or pacing).
+static uint8_t SBDOP_DumpPaced(sbdop_dump_t* dump)
+{
+    return ((dump->delay_ms > 0) || (dump->pace.period_ns > 0)) ? TRUE : FALSE;
+}
+
+//!< Sets up the wire time model of the dump.
+static void SBDOP_DumpWireInit(
+        sbdop_dump_t* dump,
+        int baud,
+        const char* datamode)
+{
+    int bits = SerialPort::GetBitsPerByte(datamode);
+    dump->byte_ns = ((uint64_t)bits * 1000000000ull) / (uint64_t)baud;
+    dump->txq_max = (SBDOP_TXQ_MAX_US * 1000ull) / dump->byte_ns;
+    if(dump->txq_max < SBDOP_TXQ_MIN)
+    {
+        dump->txq_max = SBDOP_TXQ_MIN;
+    }
+    dump->wire_idle = std::chrono::steady_clock::now();
+}
+
+//!< Records n bytes just written in the wire time model.
+static void SBDOP_DumpWireWritten(
+        sbdop_dump_t* dump,
+        int n)
+{
+    auto now = std::chrono::steady_clock::now();
+    if(dump->wire_idle < now)
+    {
+        dump->wire_idle = now;
+    }
+    dump->wire_idle += std::chrono::nanoseconds((uint64_t)n * dump->byte_ns);
+}
+
+/*
+ * @brief Returns number of bytes written to the port, but not transmitted yet.
+ * @details Asks the OS (TIOCOUTQ), the wire time model is used if the OS does not tell.
+ */
+static uint64_t SBDOP_DumpTxQueued(sbdop_dump_t* dump)
+{
+    int queued = dump->port->GetTxQueued();
+    if(queued >= 0)
+    {
+        return (uint64_t)queued;
+    }
+
+    auto now = std::chrono::steady_clock::now();
+    if(dump->wire_idle <= now)
+    {
+        return 0;
+    }
+    uint64_t ns = (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(dump->wire_idle - now).count();
+    return (ns + dump->byte_ns - 1) / dump->byte_ns;
+}
+
+//!< Returns number of bytes that may be written without exceeding the output queue bound.
+static uint64_t SBDOP_DumpTxRoom(sbdop_dump_t* dump)
+{
+    uint64_t queued = SBDOP_DumpTxQueued(dump);
+    return (queued < dump->txq_max) ? (dump->txq_max - queued) : 0;
+}
+
+//!< Returns time (in nanoseconds) it takes the output queue to go down to target bytes.
+static uint64_t SBDOP_DumpTxWaitNs(
+        sbdop_dump_t* dump,
+        uint64_t target)
+{
+    uint64_t queued = SBDOP_DumpTxQueued(dump);
+    return (queued > target) ? ((queued - target) * dump->byte_ns) : 0;
+}
+
+//!< Sleeps for ns nanoseconds.
+static void SBDOP_SleepNs(uint64_t ns)
+{
+    SBDOP_SleepUntil(std::chrono::steady_clock::now() + std::chrono::nanoseconds(ns));
+}
+
+/*
+ * Progress reporter of a dump: a thread reporting the dump's counters
+ * every SBDOP_PROGRESS_INTERVAL_MS, see SBDOP_SetProgressFormat().
+ */
+typedef struct
+{
+    std::thread thread;
+    std::mutex mutex;
+    std::condition_variable cv;
+    bool stop;
+    std::chrono::steady_clock::time_point start;
+    std::chrono::steady_clock::time_point last; //!< time of the previous report
+    uint64_t last_sent;
+    uint64_t last_bursts;
+    double last_late_sum_us;
+}sbdop_reporter_t;
+
+//!< Reports progress of the dump, final is TRUE for the report made when the dump finished.
+static void SBDOP_ReportProgress(
+        sbdop_reporter_t* reporter,
+        sbdop_dump_t* dump,
+        uint8_t final)
+{
+    auto now = std::chrono::steady_clock::now();
+    uint64_t sent = dump->sent.load(std::memory_order_relaxed);
+    uint64_t bursts = dump->pace.bursts.load(std::memory_order_acquire);
+    double late_sum_us = dump->pace.late_sum_us.load(std::memory_order_relaxed);
+
+    // final rate is the average of the whole dump
+    auto since = final ? reporter->start : reporter->last;
+    uint64_t since_sent = final ? 0 : reporter->last_sent;
+    double elapsed_s = (double)std::chrono::duration_cast<std::chrono::microseconds>(now - since).count() / 1e6;
+    double rate = (elapsed_s > 0) ? ((double)(sent - since_sent) / elapsed_s) : 0;
+    uint64_t filesize = dump->filesize.load();
+    uint64_t eta_s = (rate > 0) ? (uint64_t)ceil((double)(filesize - sent) / rate) : 0;
+    uint16_t perc = (filesize > 0) ? SBDOP_PercentageCompletion(sent, filesize) : 100;
+
+    uint8_t jitter = ((dump->pace.period_ns > 0) && !dump->uring) ? TRUE : FALSE;
+    double jitter_us = 0;
+    if(bursts > reporter->last_bursts)
+    {
+        jitter_us = (late_sum_us - reporter->last_late_sum_us) / (double)(bursts - reporter->last_bursts);
+    }
+    double jitter_max_us = dump->pace.late_max_us.load(std::memory_order_relaxed);
+
+    if(sbdop_progress_format == SBDOP_PROGRESS_LINE)
+    {
+        char jitter_str[64] = "";
+        if(jitter)
+        {
+            snprintf(jitter_str, sizeof(jitter_str), " jitter_us=%.1f jitter_max_us=%.1f", jitter_us, jitter_max_us);
+        }
+        const char* state = !final ? "running" : ((dump->ret == 0) ? "done" : "failed");
+        if(dump->stream)
+        {
+            // size of a stream is not known, neither are percentage and ETA
+            printf("progress port=%s sent=%" PRIu64 " rate=%.0f%s state=%s\n",
+                    dump->portname,
+                    sent,
+                    rate,
+                    jitter_str,
+                    state);
+        }
+        else
+        {
+            printf("progress port=%s sent=%" PRIu64 " size=%" PRIu64 " percent=%u rate=%.0f eta_s=%" PRIu64 "%s state=%s\n",
+                    dump->portname,
+                    sent,
+                    filesize,
+                    (unsigned int)perc,
+                    rate,
+                    eta_s,
+                    jitter_str,
+                    state);
+        }
+    }
+    else
+    {
+        char jitter_str[64] = "";
+        if(jitter)
+        {
+            snprintf(jitter_str, sizeof(jitter_str), ", jitter %.1f us (max %.1f us)", jitter_us, jitter_max_us);
+        }
+        if(dump->stream)
+        {
+            printf("\rProgress: %" PRIu64 " B, %.0f B/s%s ", sent, rate, jitter_str);
+        }
+        else
+        {
+            printf("\rProgress: %u%% (%" PRIu64 " / %" PRIu64 " B), %.0f B/s, ETA %" PRIu64 ":%02u:%02u%s ",
+                    (unsigned int)perc,
+                    sent,
+                    filesize,
+                    rate,
+                    eta_s / 3600,
+                    (unsigned int)((eta_s / 60) % 60),
+                    (unsigned int)(eta_s % 60),
+                    jitter_str);
+        }
+        if(final)
+        {
+            printf("\n");
+        }
+    }
+    fflush(stdout);
+
+    reporter->last = now;
+    reporter->last_sent = sent;
+    reporter->last_bursts = bursts;
+    reporter->last_late_sum_us = late_sum_us;
+}
+
+//!< Starts reporting progress of the dump (unless progress is not displayed).
+static void SBDOP_ReporterStart(
+        sbdop_reporter_t* reporter,
+        sbdop_dump_t* dump)
+{
+    reporter->stop = false;
+    reporter->start = std::chrono::steady_clock::now();
+    reporter->last = reporter->start;
+    reporter->last_sent = 0;
+    reporter->last_bursts = 0;
+    reporter->last_late_sum_us = 0;
+    if(sbdop_progress_format == SBDOP_PROGRESS_NONE)
+    {
+        return;
+    }
+
+    reporter->thread = std::thread([reporter, dump]()
+    {
+        std::unique_lock<std::mutex> lock(reporter->mutex);
+        while(!reporter->cv.wait_for(lock,
+                std::chrono::milliseconds(SBDOP_PROGRESS_INTERVAL_MS),
+                [reporter]() { return reporter->stop; }))
+        {
+            SBDOP_ReportProgress(reporter, dump, FALSE);
+        }
+        SBDOP_ReportProgress(reporter, dump, TRUE);
+    });
+}
+
+//!< Stops reporting progress, after the final report (dump->ret must be set by then).
+static void SBDOP_ReporterStop(sbdop_reporter_t* reporter)
+{
+    if(!reporter->thread.joinable())
+    {
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(reporter->mutex);
+        reporter->stop = true;
+    }
+    reporter->cv.notify_one();
+    reporter->thread.join();
+}
+
+/*
+ * @brief Sends next chunk of the file with a single write.
+ * @details Chunk is limited by the chunk size, by the rest of the current burst
+ * (when a delay is applied between bursts), by the block available in the ring
+ * and by room in the port's output queue.
+ * @param room Maximum number of bytes to send (see SBDOP_DumpTxRoom()).
+ * @retval >0 Number of bytes sent (may be less than the chunk, the rest is sent by the next call).
+ * @retval 0 Port's output buffer is full (or the stream ended, see filesize), nothing sent.
+ * @retval -1 Error.
+ */
+static int SBDOP_DumpNextChunk(
+        sbdop_dump_t* dump,
+        uint64_t room)
+{
+    const uint8_t* data = NULL;
+    size_t size = SBDOP_RingPeek(dump->ring, &data);
+    if((size == 0) && dump->stream)
+    {
+        dump->filesize = dump->sent.load(); // end of the stream, all the data is sent
+        return 0;
+    }
+    if(size == 0)
+    {
+        printf("%sError! Unexpected end-of-file reached.\n", dump->tag);
+        return -1;
+    }
+
+    if(size > (size_t)dump->chunk)
+    {
+        size = (size_t)dump->chunk;
+    }
+    if(SBDOP_DumpPaced(dump) && (size > (size_t)(dump->burst - dump->burst_cnt)))
+    {
+        size = (size_t)(dump->burst - dump->burst_cnt);
+    }
+    if(size > (dump->filesize - dump->sent))
+    {
+        size = (size_t)(dump->filesize - dump->sent);
+    }
+    if(size > room)
+    {
+        size = (size_t)room;
+    }
+
+    int n = dump->port->Write(data, size);
+    if(n < 0)
+    {
+        printf("%sError! Failed to send data.\n", dump->tag);
+        return -1;
+    }
+    if(n == 0)
+    {
+        return 0;
+    }
+
+    SBDOP_RingConsume(dump->ring, (size_t)n);
+    SBDOP_DumpWireWritten(dump, n);
+    dump->sent.store(dump->sent.load(std::memory_order_relaxed) + (uint64_t)n, std::memory_order_relaxed);
+
+    return n;
+}
+
+/*
+ * @brief Returns TRUE if a delay shall be applied after the bytes just sent.
+ * @param sent Number of bytes just sent.
+ */
+static uint8_t SBDOP_DumpBurstDone(
+        sbdop_dump_t* dump,
+        int sent)
+{
+    // with bursts separated chunks end on burst boundaries, otherwise bursts do not matter
+    dump->burst_cnt += sent;
+    if(dump->burst_cnt >= dump->burst)
+    {
+        dump->burst_cnt %= dump->burst;
+        return TRUE;
+    }
+
+    return FALSE;
+}
+
+/*
+ * Drives a dump on SerialReactor events:
+ * - writable: sends chunks until the burst is done, the output queue bound is reached
+ *   or port's output buffer gets full,
+ * - timeout: the output queue went down (by the wire time), or the delay after a burst expired.
+ * Paced bursts (see sbdop_pace_t) wait for their deadlines right in the handler.
+ */
+class SBDOP_DumpHandler : public SerialReactor::Handler
+{
+public:
+    SBDOP_DumpHandler(SerialReactor* reactor, sbdop_dump_t* dump):
+        reactor(reactor),
+        dump(dump),
+        draining(false)
+    {
+    }
+
+    void OnPortEvent(int fd, uint32_t events) override
+    {
+        if(events & SerialReactor::EVENT_ERROR)
+        {
+            printf("%sError! Failed to send data.\n", dump->tag);
+            Finish(fd, -1);
+            return;
+        }
+
+        if(events & SerialReactor::EVENT_TIMEOUT)
+        {
+            if(draining)
+            {
+                // the delay starts once the burst has left the wire
+                uint64_t wait_ns = SBDOP_DumpTxWaitNs(dump, 0);
+                if(wait_ns > 0)
+                {
+                    Sleep(fd, wait_ns);
+                    return;
+                }
+                draining = false;
+                reactor->SetTimeout(fd, static_cast<uint32_t>(dump->delay_ms));
+                return;
+            }
+            reactor->Modify(fd, SerialReactor::EVENT_WRITABLE);
+            return;
+        }
+
+        while(dump->sent < dump->filesize)
+        {
+            uint64_t room = SBDOP_DumpTxRoom(dump);
+            if(room == 0)
+            {
+                Sleep(fd, SBDOP_DumpTxWaitNs(dump, dump->txq_max / 2));
+                return;
+            }
+            int n = SBDOP_DumpNextChunk(dump, room);
+            if(n < 0)
+            {
+                Finish(fd, -1);
+                return;
+            }
+            if(n == 0)
+            {
+                if(dump->sent == dump->filesize)
+                {
+                    break; // end of the stream
+                }
+                return; // wait for writable
+            }
+            if(!SBDOP_DumpBurstDone(dump, n) || (dump->sent == dump->filesize))
+            {
+                continue;
+            }
+            if(dump->pace.period_ns > 0)
+            {
+                // deadlines are finer than reactor timeouts, the reactor serves this port only
+                SBDOP_PaceNextBurst(&dump->pace);
+            }
+            else if(dump->delay_ms > 0)
+            {
+                draining = true;
+                Sleep(fd, SBDOP_DumpTxWaitNs(dump, 0));
+                return;
+            }
+        }
+
+        Finish(fd, 0);
+    }
+
+private:
+    SerialReactor* reactor;
+    sbdop_dump_t* dump;
+    bool draining; //!< waiting for the burst to leave the wire, before the delay
+
+    //!< Stops waiting for writable, until ns nanoseconds (rounded up to miliseconds) pass.
+    void Sleep(int fd, uint64_t ns)
+    {
+        uint64_t ms = (ns + 999999ull) / 1000000ull;
+        reactor->Modify(fd, 0);
+        reactor->SetTimeout(fd, static_cast<uint32_t>((ms > 0) ? ms : 1));
+    }
+
+    void Finish(int fd, int ret)
+    {
+        dump->ret = ret;
+        reactor->Remove(fd);
+    }
+};
+
+//!< Kinds of io_uring requests of a dump, kept in the low bits of their user data (buffer and dump slot above).
+#define SBDOP_URING_READ 0
+#define SBDOP_URING_WRITE 1
+#define SBDOP_URING_TIMEOUT 2
+#define SBDOP_URING_WAIT 3 //!< for room in the port's output queue
+
+//!< User data of a request of the dump in slot, on its buffer buf.
+#define SBDOP_URING_DATA(slot, buf, kind) ((((uint64_t)(slot)) << 16) | (((uint64_t)(buf)) << 2) | (uint64_t)(kind))
+
+//!< User data of the read of the engine's wake up eventfd.
+#define SBDOP_URING_WAKE UINT64_MAX
+
+//!< Maximum number of chains in a row which send nothing, before the io_uring dump gives up.
+#define SBDOP_URING_MAX_RETRIES 3
+
+/*
+ * A dump attached to the io_uring engine: its file, its port and its chain of requests.
+ */
+typedef struct
+{
+    sbdop_dump_t* dump;
+    int file_fd;
+    int port_fd;
+    uint32_t base; //!< index of the first of the dump's registered buffers
+    std::vector<uint32_t> lens; //!< bytes of each buffer of the chain
+    std::vector<int32_t> written; //!< result of the write of each buffer of the chain
+    std::vector<uint64_t> timeouts; //!< timeout after each buffer (ns, absolute if paced by rate), 0 if none
+    std::vector<std::chrono::steady_clock::time_point> deadlines; //!< start of the paced burst after each buffer
+    uint32_t slots; //!< buffers used by the chain, 0 if it only waits for room in the port's output queue
+    uint32_t pending; //!< requests of the chain not completed yet, 0 if no chain is in flight
+    std::chrono::steady_clock::time_point deadline; //!< start of the last paced burst the chain got to
+    int retries; //!< chains in a row which sent nothing
+    bool done; //!< dump finished, dump->ret holds the result (guarded by the engine's mutex)
+}sbdop_uring_dump_t;
+
+/*
+ * io_uring engine (see SBDOP_ENGINE_URING): a single thread keeps a chain of requests
+ * of each attached dump in flight on one io_uring, so any number of ports
+ * is kept busy by a system call per round of completions.
+ * Each dump slot has depth registered buffers of its own.
+ */
+typedef struct
+{
+    SerialUring uring;
+    uint8_t* buffers; //!< depth buffers of SBDOP_STREAM_BLOCK_SIZE bytes per slot
+    uint32_t depth;
+    int wake_fd; //!< eventfd, signalled when a dump is attached or the engine stops
+    uint64_t wake_cnt; //!< read from wake_fd
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::vector<sbdop_uring_dump_t*> dumps; //!< attached dumps by slot, NULL if the slot is free
+    bool stop;
+    bool failed; //!< the engine thread gave up, dumps can no longer be attached
+    std::thread thread;
+}sbdop_uring_t;
+
+#if defined(__linux__)
+//!< Wakes the engine's thread up, see SBDOP_URING_WAKE.
+static void SBDOP_UringWake(sbdop_uring_t* engine)
+{
+    uint64_t one = 1;
+    ssize_t r = write(engine->wake_fd, &one, sizeof(one));
+    (void)r;
+}
+
+/*
+ * @brief Prepares the next chain of the dump in slot, over its buffers:
+ * read (file -> buffer) -> write (buffer -> port) -> [timeout] -> read -> write -> ...
+ * @details Timeouts are the delay (plus wire time of the burst, so the gap is on the wire)
+ * or the absolute deadline of the next paced burst. Data of the chain is bounded by room
+ * in the port's output queue (see SBDOP_DumpTxRoom()), if there is none,
+ * the chain just waits for the queue to go half way down.
+ */
+static void SBDOP_UringPrepChain(
+        sbdop_uring_t* engine,
+        uint32_t slot,
+        sbdop_uring_dump_t* chain)
+{
+    sbdop_dump_t* dump = chain->dump;
+    chain->slots = 0;
+    chain->pending = 0;
+    chain->deadline = dump->pace.deadline; // of the last burst started
+
+    uint64_t room = SBDOP_DumpTxRoom(dump);
+    if(room == 0)
+    {
+        engine->uring.PrepTimeout(SBDOP_DumpTxWaitNs(dump, dump->txq_max / 2), false,
+                SBDOP_URING_DATA(slot, 0, SBDOP_URING_WAIT), false);
+        chain->pending = 1;
+        return;
+    }
+
+    uint64_t offset = dump->sent;
+    int burst_cnt = dump->burst_cnt;
+    while((chain->slots < engine->depth) && (offset < dump->filesize) && (room > 0))
+    {
+        uint64_t len = SBDOP_STREAM_BLOCK_SIZE;
+        if(len > (uint64_t)dump->chunk)
+        {
+            len = (uint64_t)dump->chunk;
+        }
+        if(SBDOP_DumpPaced(dump) && (len > (uint64_t)(dump->burst - burst_cnt)))
+        {
+            len = (uint64_t)(dump->burst - burst_cnt);
+        }
+        if(len > (dump->filesize - offset))
+        {
+            len = dump->filesize - offset;
+        }
+        if(len > room)
+        {
+            len = room;
+        }
+
+        uint32_t i = chain->slots++;
+        chain->lens[i] = (uint32_t)len;
+        chain->written[i] = -ECANCELED;
+        chain->timeouts[i] = 0;
+        offset += len;
+        room -= len;
+
+        if(!SBDOP_DumpPaced(dump))
+        {
+            continue;
+        }
+        burst_cnt += (int)len;
+        if((burst_cnt < dump->burst) || (offset == dump->filesize))
+        {
+            continue;
+        }
+        burst_cnt = 0;
+        if(dump->pace.period_ns > 0)
+        {
+            chain->deadlines[i] = SBDOP_PaceAdvance(&dump->pace);
+            chain->timeouts[i] = (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+                    chain->deadlines[i].time_since_epoch()).count();
+        }
+        else
+        {
+            // write completes once the burst is queued, the delay starts once it has left the wire
+            chain->timeouts[i] = ((uint64_t)dump->delay_ms * 1000000ull) + ((uint64_t)dump->burst * dump->byte_ns);
+        }
+    }
+
+    // requests of the dump are linked up to its last one, chains of other dumps run independently
+    offset = dump->sent;
+    for(uint32_t i = 0; i < chain->slots; i++)
+    {
+        uint32_t buf = chain->base + i;
+        uint8_t* buffer = engine->buffers + ((size_t)buf * SBDOP_STREAM_BLOCK_SIZE);
+        bool last = ((i + 1) == chain->slots);
+        engine->uring.PrepReadFixed(chain->file_fd, buf, buffer, chain->lens[i], dump->file_offset + offset,
+                SBDOP_URING_DATA(slot, i, SBDOP_URING_READ), true);
+        engine->uring.PrepWriteFixed(chain->port_fd, buf, buffer, chain->lens[i], (uint64_t)-1,
+                SBDOP_URING_DATA(slot, i, SBDOP_URING_WRITE), !last || (chain->timeouts[i] > 0));
+        chain->pending += 2;
+        offset += chain->lens[i];
+        if(chain->timeouts[i] > 0)
+        {
+            engine->uring.PrepTimeout(chain->timeouts[i], (dump->pace.period_ns > 0),
+                    SBDOP_URING_DATA(slot, i, SBDOP_URING_TIMEOUT), !last);
+            chain->pending++;
+        }
+    }
+}
+
+//!< Takes a completed request of the chain into account.
+static void SBDOP_UringComplete(
+        sbdop_uring_dump_t* chain,
+        uint32_t buf,
+        uint32_t kind,
+        int32_t res)
+{
+    chain->pending--;
+    switch(kind)
+    {
+        case SBDOP_URING_READ:
+            if(((res < 0) && (res != -ECANCELED) && (res != -EINTR)) || (res == 0))
+            {
+                printf("%sError! Failed to read file.\n", chain->dump->tag);
+                chain->dump->ret = -1;
+            }
+            break;
+        case SBDOP_URING_WRITE:
+            chain->written[buf] = res;
+            if((res < 0) && (res != -ECANCELED) && (res != -EINTR) && (res != -EAGAIN))
+            {
+                printf("%sError! Failed to send data.\n", chain->dump->tag);
+                chain->dump->ret = -1;
+            }
+            break;
+        case SBDOP_URING_TIMEOUT:
+            if((res == -ETIME) && (chain->dump->pace.period_ns > 0))
+            {
+                chain->deadline = chain->deadlines[buf];
+            }
+            break;
+        default:
+            break;
+    }
+}
+
+/*
+ * @brief Accounts the data sent by the completed chain.
+ * @details A chain broken on the way (i.e. write interrupted by a signal) is resumed
+ * from the last byte written by the next one.
+ * @retval TRUE If the dump is finished (all the data sent, or failed).
+ */
+static uint8_t SBDOP_UringChainDone(sbdop_uring_dump_t* chain)
+{
+    sbdop_dump_t* dump = chain->dump;
+    if((chain->slots == 0) || (dump->ret != 0))
+    {
+        return (dump->ret != 0) ? TRUE : FALSE;
+    }
+    // bursts of a broken chain which did not start are paced again by the next chain
+    dump->pace.deadline = chain->deadline;
+
+    // writes are linked, so they complete in order: count them up to the first incomplete one
+    uint64_t progress = 0;
+    for(uint32_t i = 0; i < chain->slots; i++)
+    {
+        if(chain->written[i] > 0)
+        {
+            progress += (uint64_t)chain->written[i];
+        }
+        if(chain->written[i] != (int32_t)chain->lens[i])
+        {
+            break;
+        }
+    }
+    dump->sent.store(dump->sent.load(std::memory_order_relaxed) + progress, std::memory_order_relaxed);
+    SBDOP_DumpWireWritten(dump, (int)progress);
+    if(SBDOP_DumpPaced(dump))
+    {
+        dump->burst_cnt = (int)((dump->burst_cnt + progress) % (uint64_t)dump->burst);
+    }
+
+    chain->retries = (progress > 0) ? 0 : (chain->retries + 1);
+    if(chain->retries >= SBDOP_URING_MAX_RETRIES)
+    {
+        printf("%sError! Failed to send data.\n", dump->tag);
+        dump->ret = -1;
+    }
+
+    return ((dump->ret != 0) || (dump->sent == dump->filesize)) ? TRUE : FALSE;
+}
+
+//!< Detaches the finished dump in slot and wakes its thread up.
+static void SBDOP_UringFinish(
+        sbdop_uring_t* engine,
+        uint32_t slot)
+{
+    {
+        std::lock_guard<std::mutex> lock(engine->mutex);
+        engine->dumps[slot]->done = true;
+        engine->dumps[slot] = NULL;
+    }
+    engine->cv.notify_all();
+}
+
+//!< io_uring engine thread: keeps a chain of each attached dump in flight, until the engine stops.
+static void SBDOP_UringRun(sbdop_uring_t* engine)
+{
+    std::vector<sbdop_uring_dump_t*> dumps;
+    bool wake_armed = false;
+    while(true)
+    {
+        {
+            std::lock_guard<std::mutex> lock(engine->mutex);
+            if(engine->stop)
+            {
+                break;
+            }
+            dumps = engine->dumps;
+        }
+
+        if(!wake_armed)
+        {
+            engine->uring.PrepRead(engine->wake_fd, (uint8_t*)&engine->wake_cnt, sizeof(engine->wake_cnt), 0,
+                    SBDOP_URING_WAKE, false);
+            wake_armed = true;
+        }
+        for(uint32_t slot = 0; slot < dumps.size(); slot++)
+        {
+            if((dumps[slot] != NULL) && (dumps[slot]->pending == 0))
+            {
+                SBDOP_UringPrepChain(engine, slot, dumps[slot]);
+            }
+        }
+
+        // a single system call submits the new chains and waits for any completion
+        if(engine->uring.Submit(1) != EC_OK)
+        {
+            std::lock_guard<std::mutex> lock(engine->mutex);
+            for(uint32_t slot = 0; slot < engine->dumps.size(); slot++)
+            {
+                if(engine->dumps[slot] != NULL)
+                {
+                    printf("%sError! Failed to submit io_uring requests.\n", engine->dumps[slot]->dump->tag);
+                    engine->dumps[slot]->dump->ret = -1;
+                    engine->dumps[slot]->done = true;
+                    engine->dumps[slot] = NULL;
+                }
+            }
+            engine->failed = true;
+            engine->cv.notify_all();
+            break;
+        }
+
+        SerialUring::completion_t completion;
+        while(engine->uring.PopCompletion(completion))
+        {
+            if(completion.userData == SBDOP_URING_WAKE)
+            {
+                wake_armed = false;
+                continue;
+            }
+            uint32_t slot = (uint32_t)(completion.userData >> 16);
+            sbdop_uring_dump_t* chain = dumps[slot];
+            SBDOP_UringComplete(chain, (uint32_t)((completion.userData >> 2) & 0x3FFF),
+                    (uint32_t)(completion.userData & 0x03), completion.res);
+            if((chain->pending == 0) && SBDOP_UringChainDone(chain))
+            {
+                SBDOP_UringFinish(engine, slot);
+                dumps[slot] = NULL;
+            }
+        }
+    }
+}
+#endif
+
+/*
+ * @brief Sets the io_uring engine up for up to ports dumps at once and starts its thread.
+ * @param depth Number of registered buffers (SBDOP_STREAM_BLOCK_SIZE bytes each) of each dump.
+ * @retval TRUE If started.
+ * @retval FALSE If failed (i.e. io_uring not supported, out of memory).
+ */
+static uint8_t SBDOP_UringStart(
+        sbdop_uring_t* engine,
+        uint32_t ports,
+        uint32_t depth)
+{
+#if defined(__linux__)
+    engine->buffers = NULL;
+    engine->depth = depth;
+    engine->wake_cnt = 0;
+    engine->dumps.assign(ports, NULL);
+    engine->stop = false;
+    engine->failed = false;
+    engine->wake_fd = eventfd(0, EFD_CLOEXEC);
+    if(engine->wake_fd == -1)
+    {
+        return FALSE;
+    }
+
+    // a request per read, write and timeout of each buffer, and the wake up read
+    size_t count = (size_t)ports * depth;
+    if((posix_memalign((void**)&engine->buffers, 4096, count * SBDOP_STREAM_BLOCK_SIZE) != 0) ||
+       (engine->uring.Init((uint32_t)(count * 3) + 1) != EC_OK) ||
+       (engine->uring.RegisterBuffers(engine->buffers, (uint32_t)count, SBDOP_STREAM_BLOCK_SIZE) != EC_OK))
+    {
+        free(engine->buffers);
+        close(engine->wake_fd);
+        return FALSE;
+    }
+
+    engine->thread = std::thread(SBDOP_UringRun, engine);
+
+    return TRUE;
+#else
+    (void)engine;
+    (void)ports;
+    (void)depth;
+    return FALSE;
+#endif
+}
+
+//!< Stops the io_uring engine started by SBDOP_UringStart(), once no dumps are attached.
+static void SBDOP_UringStop(sbdop_uring_t* engine)
+{
+#if defined(__linux__)
+    {
+        std::lock_guard<std::mutex> lock(engine->mutex);
+        engine->stop = true;
+    }
+    SBDOP_UringWake(engine);
+    engine->thread.join();
+    free(engine->buffers);
+    close(engine->wake_fd);
+#else
+    (void)engine;
+#endif
+}
+
+/*
+ * @brief Dumps the file with the io_uring engine (see SBDOP_ENGINE_URING).
+ * @details Attaches the dump to the engine and waits until the engine's thread is done with it.
+ * Each chain of the dump is submitted along with the chains of the other dumps,
+ * see SBDOP_UringPrepChain().
+ * @retval 0 If dumped.
+ * @retval -1 If failed.
+ */
+static int SBDOP_UringDump(
+        sbdop_uring_t* engine,
+        sbdop_dump_t* dump,
+        const char* filename)
+{
+#if defined(__linux__)
+    if(dump->sent == dump->filesize)
+    {
+        return 0;
+    }
+
+    int file_fd = open(filename, O_RDONLY | O_CLOEXEC);
+    if(file_fd == -1)
+    {
+        printf("%sError! Unable to open file.\n", dump->tag);
+        return -1;
+    }
+    posix_fadvise(file_fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+
+    // io_uring returns -EAGAIN on non-blocking ports rather than waiting for room
+    int port_fd = dump->port->GetFd();
+    int port_flags = fcntl(port_fd, F_GETFL);
+    fcntl(port_fd, F_SETFL, port_flags & ~O_NONBLOCK);
+
+    sbdop_uring_dump_t chain;
+    chain.dump = dump;
+    chain.file_fd = file_fd;
+    chain.port_fd = port_fd;
+    chain.base = 0;
+    chain.lens.resize(engine->depth);
+    chain.written.resize(engine->depth);
+    chain.timeouts.resize(engine->depth);
+    chain.deadlines.resize(engine->depth);
+    chain.slots = 0;
+    chain.pending = 0;
+    chain.retries = 0;
+    chain.done = false;
+
+    uint8_t attached = FALSE;
+    {
+        std::lock_guard<std::mutex> lock(engine->mutex);
+        for(uint32_t slot = 0; (slot < engine->dumps.size()) && !engine->failed; slot++)
+        {
+            if(engine->dumps[slot] == NULL)
+            {
+                chain.base = slot * engine->depth;
+                engine->dumps[slot] = &chain;
+                attached = TRUE;
+                break;
+            }
+        }
+    }
+    if(attached)
+    {
+        SBDOP_UringWake(engine);
+        std::unique_lock<std::mutex> lock(engine->mutex);
+        engine->cv.wait(lock, [&chain]() { return chain.done; });
+    }
+    else
+    {
+        printf("%sError! io_uring engine is not available.\n", dump->tag);
+        dump->ret = -1;
+    }
+
+    fcntl(port_fd, F_SETFL, port_flags);
+    close(file_fd);
+
+    return dump->ret;
+#else
+    (void)engine;
+    (void)dump;
+    (void)filename;
+    return -1;
+#endif
+}
+
+/*
+ * @brief Dumps binary file (or a part of it) to opened com port, see SBDOP_DumpBinaryToPort().
+ * @param offset Offset of the data to be dumped within the file, filesize bytes are dumped from there.
+ * @param image The data to be dumped, in memory shared by several dumps (see SBDOP_SourceView()),
+ * NULL to open the file (offset must be 0 then). The io_uring engine always reads the file by itself.
+ * @param tag Prefix of report lines, see SBDOP_PaceReport().
+ * @param uring_engine io_uring engine shared by several dumps (see SBDOP_UringStart()),
+ * NULL to set one up for this dump (if the io_uring engine is used).
+ */
+static int SBDOP_DumpOnPort(
+        SerialPort* port,
+        const char* portname,
+        int baud,
+        int delay_ms,
+        int burst,
+        int chunk,
+        int ring_depth,
+        sbdop_engine_t engine,
+        uint64_t rate,
+        uint32_t gap_us,
+        const char* datamode,
+        const char* filename,
+        uint64_t offset,
+        uint64_t filesize,
+        const sbdop_source_t* image,
+        const char* tag,
+        sbdop_uring_t* uring_engine)
+{
+    if(port == NULL || portname == NULL || datamode == NULL || filename == NULL || burst <= 0 || chunk <= 0 || ring_depth <= 0)
+    {
+        return -1;
+    }
+    // the opened file is dumped from its start, parts of it are dumped from image
+    if((offset > 0) && (image == NULL))
+    {
+        return -1;
+    }
+
+    uint8_t uring = ((engine == SBDOP_ENGINE_URING) && SerialUring::IsSupported() && (port->GetFd() >= 0)) ?
+            TRUE : FALSE;
+    if((engine == SBDOP_ENGINE_URING) && !uring)
+    {
+        printf("%sio_uring is not available, using rw engine.\n", tag);
+    }
+    // chains of the io_uring engine read the file at offsets
+    if(uring && (filesize == SBDOP_FILESIZE_UNKNOWN))
+    {
+        printf("%sio_uring engine does not stream, using rw engine.\n", tag);
+        uring = FALSE;
+    }
+
+    // io_uring engine reads the file by itself
+    sbdop_source_t src;
+    sbdop_ring_t ring;
+    if(!uring)
+    {
+        if(image != NULL)
+        {
+            SBDOP_SourceView(&src, image, offset, filesize);
+        }
+        else if(!SBDOP_SourceOpen(&src, filename, filesize))
+        {
+            printf("%sError! Unable to open file.\n", tag);
+            return -1;
+        }
+        if(!SBDOP_RingStart(&ring, (uint32_t)ring_depth, &src, filesize))
+        {
+            printf("%sError! Unable to allocate the ring.\n", tag);
+            SBDOP_SourceClose(&src);
+            return -1;
+        }
+    }
+
+    sbdop_dump_t dump;
+    dump.portname = portname;
+    dump.tag = tag;
+    dump.port = port;
+    dump.file_offset = offset;
+    dump.ring = uring ? NULL : &ring;
+    dump.filesize = filesize;
+    dump.stream = (filesize == SBDOP_FILESIZE_UNKNOWN) ? TRUE : FALSE;
+    dump.sent = 0;
+    dump.burst = burst;
+    dump.burst_cnt = 0;
+    dump.chunk = chunk;
+    dump.delay_ms = delay_ms;
+    SBDOP_PaceInit(&dump.pace, rate, gap_us, burst);
+    SBDOP_DumpWireInit(&dump, baud, datamode);
+    dump.uring = uring;
+    dump.ret = 0;
+
+    sbdop_reporter_t reporter;
+    SBDOP_ReporterStart(&reporter, &dump);
+
+    if(uring && (uring_engine != NULL))
+    {
+        dump.ret = SBDOP_UringDump(uring_engine, &dump, filename);
+    }
+    else if(uring)
+    {
+        sbdop_uring_t engine;
+        if(SBDOP_UringStart(&engine, 1, (uint32_t)ring_depth))
+        {
+            dump.ret = SBDOP_UringDump(&engine, &dump, filename);
+            SBDOP_UringStop(&engine);
+        }
+        else
+        {
+            printf("%sError! Unable to set io_uring up.\n", tag);
+            dump.ret = -1;
+        }
+    }
+    else if(SerialReactor::IsSupported() && (port->GetFd() >= 0))
+    {
+        SerialReactor reactor;
+        SBDOP_DumpHandler handler(&reactor, &dump);
+        if((filesize > 0) &&
+           ((reactor.Add(port->GetFd(), &handler, SerialReactor::EVENT_WRITABLE) != EC_OK) ||
+            (reactor.Run() != EC_OK)))
+        {
+            dump.ret = -1;
+        }
+    }
+    else
+    {
+        while(dump.sent < dump.filesize)
+        {
+            uint64_t room = SBDOP_DumpTxRoom(&dump);
+            if(room == 0)
+            {
+                SBDOP_SleepNs(SBDOP_DumpTxWaitNs(&dump, dump.txq_max / 2));
+                continue;
+            }
+            int n = SBDOP_DumpNextChunk(&dump, room);
+            if((n == 0) && (dump.sent == dump.filesize))
+            {
+                break; // end of the stream
+            }
+            if(n == 0)
+            {
+                // the port is non-blocking, wait for room in its output buffer
+                uint32_t wait_ms = (uint32_t)(SBDOP_DumpTxWaitNs(&dump, dump.txq_max / 2) / 1000000) + 1;
+                if(port->WaitWritable(wait_ms) == EC_OK)
+                {
+                    continue;
+                }
+                printf("%sError! Failed to send data.\n", tag);
+            }
+            if(n <= 0)
+            {
+                dump.ret = -1;
+                break;
+            }
+            if(!SBDOP_DumpBurstDone(&dump, n) || (dump.sent == dump.filesize))
+            {
+                continue;
+            }
+            if(dump.pace.period_ns > 0)
+            {
+                SBDOP_PaceNextBurst(&dump.pace);
+            }
+            else if(delay_ms > 0)
+            {
+                // the delay starts once the burst has left the wire
+                SBDOP_SleepNs(SBDOP_DumpTxWaitNs(&dump, 0));
+                SBDOP_Delay(delay_ms);
+            }
+        }
+    }
+
+    if(!uring)
+    {
+        SBDOP_RingStop(&ring);
+        SBDOP_SourceClose(&src);
+    }
+
+    // the tail is bounded by the output queue, so this does not take long
+    if((dump.ret == 0) && (port->Drain() != EC_OK))
+    {
+        printf("%sError! Failed to send data.\n", tag);
+        dump.ret = -1;
+    }
+
+    SBDOP_ReporterStop(&reporter);
+
+    if((dump.ret == 0) && (dump.pace.period_ns > 0))
+    {
+        SBDOP_PaceReport(&dump.pace, dump.sent, rate, tag);
+    }
+    if((dump.ret == 0) && !uring)
+    {
+        SBDOP_RingReport(&ring, tag);
+    }
+
+    return dump.ret;
+}
+
+/*
+ * @brief Dumps binary file to com port, see SBDOP_DumpBinaryToPort().
+ * @param image Data of the file in memory shared by several dumps (see SBDOP_SourceView()),
+ * NULL to open the file.
+ * @param tag Prefix of report lines, see SBDOP_PaceReport().
+ * @param uring_engine io_uring engine shared by several dumps, see SBDOP_DumpOnPort().
+ */
+static int SBDOP_DumpToPort(
+        const char* portname,
+        int baud,
+        int delay_ms,
+        int burst,
+        int chunk,
+        int ring_depth,
+        sbdop_engine_t engine,
+        uint64_t rate,
+        uint32_t gap_us,
+        const char* datamode,
+        const char* filename,
+        uint64_t filesize,
+        const sbdop_source_t* image,
+        const char* tag,
+        sbdop_uring_t* uring_engine)
+{
+    if(portname == NULL || datamode == NULL)
+    {
+        return -1;
+    }
+
+    SerialPort port;
+    if(port.Open(portname, baud, datamode) != EC_OK)
+    {
+        printf("%sError! Unable to open serial port.\n", tag);
+        return -1;
+    }
+
+    return SBDOP_DumpOnPort(&port, portname, baud, delay_ms, burst, chunk, ring_depth, engine, rate, gap_us,
+            datamode, filename, 0, filesize, image, tag, uring_engine);
+}
+
+int SBDOP_DumpBinaryToPort(
+        const char* portname,
+        int baud,
+        int delay_ms,
+        int burst,
+        int chunk,
+        int ring_depth,
+        sbdop_engine_t engine,
+        uint64_t rate,
+        uint32_t gap_us,
+        const char* datamode,
+        const char* filename,
+        uint64_t filesize)
+{
+    return SBDOP_DumpToPort(portname, baud, delay_ms, burst, chunk, ring_depth, engine, rate, gap_us,
+            datamode, filename, filesize, NULL, "", NULL);
+}
+
+/*
+ * A dump to one of several ports (watch mode, fan-out), running in its own thread.
+ */
+typedef struct
+{
+    std::string port;
+    std::thread thread;
+    std::atomic<bool> done;
+    int ret;
+    uint8_t unplugged; //!< port was unplugged during the dump
+    uint32_t time_ms;
+}sbdop_port_dump_t;
+
+/*
+ * @brief Reports finished dump to one of several ports.
+ * @retval TRUE If dump succeeded.
+ * @retval FALSE If dump failed.
+ */
+static uint8_t SBDOP_PortDumpDone(sbdop_port_dump_t* dump)
+{
+    dump->thread.join();
+    printf("Dump to %s: %s (%.1f s).\n",
+            dump->port.c_str(),
+            (dump->ret == 0) ? "done" : (dump->unplugged ? "UNPLUGGED" : "FAILED"),
+            (float)dump->time_ms / 1000);
+    fflush(stdout);
+
+    return (dump->ret == 0) ? TRUE : FALSE;
+}
+
+/*
+ * @brief Runs dump(port, tag) for each of ports in its own thread and reports the dumps as they finish,
+ * so a slow or failed port does not hold the others up.
+ * @details dump returns 0 on success, tag is the prefix of its report lines (see SBDOP_PaceReport()).
+ * @returns Number of dumps that succeeded.
+ */
+template<typename Dump>
+static uint32_t SBDOP_PortDumpsRun(
+        const std::vector<std::string>& ports,
+        Dump dump_fn)
+{
+    // text progress of parallel dumps would interleave, progress lines tell their ports
+    sbdop_progress_t progress_format = sbdop_progress_format;
+    if((progress_format == SBDOP_PROGRESS_TEXT) && (ports.size() > 1))
+    {
+        sbdop_progress_format = SBDOP_PROGRESS_NONE;
+    }
+
+    std::list<sbdop_port_dump_t> running; // list, so dumps stay in place for their threads
+    std::mutex mutex;
+    std::condition_variable cv;
+    for(size_t i = 0; i < ports.size(); i++)
+    {
+        running.emplace_back();
+        sbdop_port_dump_t& dump = running.back();
+        dump.port = ports[i];
+        dump.done = false;
+        dump.ret = -1;
+        dump.unplugged = FALSE;
+        dump.time_ms = 0;
+        dump.thread = std::thread([&dump, &mutex, &cv, &dump_fn]()
+        {
+            auto start = std::chrono::steady_clock::now();
+            std::string tag = dump.port + ": ";
+            dump.ret = dump_fn(dump.port, tag.c_str());
+            dump.time_ms = (uint32_t)std::chrono::duration_cast<std::chrono::milliseconds>(
+                    std::chrono::steady_clock::now() - start).count();
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                dump.done = true;
+            }
+            cv.notify_one();
+        });
+    }
+
+    uint32_t dumps_ok = 0;
+    while(!running.empty())
+    {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            cv.wait(lock, [&running]()
+            {
+                for(std::list<sbdop_port_dump_t>::iterator it = running.begin(); it != running.end(); it++)
+                {
+                    if(it->done)
+                    {
+                        return true;
+                    }
+                }
+                return false;
+            });
+        }
+        for(std::list<sbdop_port_dump_t>::iterator it = running.begin(); it != running.end(); )
+        {
+            if(!it->done)
+            {
+                it++;
+                continue;
+            }
+            dumps_ok += SBDOP_PortDumpDone(&(*it));
+            it = running.erase(it);
+        }
+    }
+    sbdop_progress_format = progress_format;
+
+    return dumps_ok;
+}
+
+int SBDOP_DumpBinaryToPorts(
+        const std::vector<std::string>& portnames,
+        int baud,
+        int delay_ms,
+        int burst,
+        int chunk,
+        int ring_depth,
+        sbdop_engine_t engine,
+        uint64_t rate,
+        uint32_t gap_us,
+        const char* datamode,
+        const char* filename,
+        uint64_t filesize)
+{
+    if(portnames.empty() || datamode == NULL || filename == NULL)
+    {
+        return -1;
+    }
+
+    // the file is mapped (or read) once, all the dumps send from it
+    sbdop_source_t image;
+    if(!SBDOP_SourceOpen(&image, filename, filesize))
+    {
+        printf("Error! Unable to open file.\n");
+        return -1;
+    }
+    const sbdop_source_t* shared = &image;
+    if(!SBDOP_SourceLoad(&image, filesize))
+    {
+        printf("File does not fit in memory, each port reads it on its own.\n");
+        shared = NULL;
+    }
+
+    // a single io_uring engine thread keeps all the ports busy
+    sbdop_uring_t uring;
+    sbdop_uring_t* uring_engine = NULL;
+    if((engine == SBDOP_ENGINE_URING) && SerialUring::IsSupported() && (filesize != SBDOP_FILESIZE_UNKNOWN) &&
+       SBDOP_UringStart(&uring, (uint32_t)portnames.size(), (uint32_t)ring_depth))
+    {
+        uring_engine = &uring;
+    }
+
+    printf("Dumping to %u ports in parallel.\n", (unsigned int)portnames.size());
+    fflush(stdout);
+
+    uint32_t dumps_ok = SBDOP_PortDumpsRun(portnames,
+            [baud, delay_ms, burst, chunk, ring_depth, engine, rate, gap_us, datamode, filename, filesize, shared,
+             uring_engine](const std::string& port, const char* tag)
+            {
+                return SBDOP_DumpToPort(port.c_str(), baud, delay_ms, burst, chunk, ring_depth, engine, rate, gap_us,
+                        datamode, filename, filesize, shared, tag, uring_engine);
+            });
+    if(uring_engine != NULL)
+    {
+        SBDOP_UringStop(uring_engine);
+    }
+    SBDOP_SourceClose(&image);
+
+    printf("Dumps succeeded: %u / %u.\n", dumps_ok, (unsigned int)portnames.size());
+
+    return (dumps_ok == portnames.size()) ? 0 : -1;
+}
+
+/*
+ * @brief Returns value (uint64_t) of a manifest option, i.e. 4096, 0x1000.
+ * @retval FALSE If value is invalid.
+ */
+static uint8_t SBDOP_GetSizeFromName(
+        const char* name,
+        uint64_t* value)
+{
+    if((name == NULL) || (name[0] < '0') || (name[0] > '9'))
+    {
+        return FALSE;
+    }
+    char* end = NULL;
+    errno = 0;
+    *value = strtoull(name, &end, 0);
+
+    return ((errno == 0) && (*end == '\0')) ? TRUE : FALSE;
+}
+
+/*
+ * @brief Parses a step (option value pairs) of the manifest.
+ * @param filesizes Sizes of the files validated already, so each file is validated once.
+ * @retval NULL If the step is valid.
+ * @retval !NULL Description of the error.
+ */
+static const char* SBDOP_ParseStep(
+        const std::vector<const char*>& tokens,
+        sbdop_step_t* step,
+        std::map<std::string, uint64_t>& filesizes)
+{
+    const char* baudrate = SBDOP_DEFAULT_BAUDRATE;
+    const char* datamode = SBDOP_DEFAULT_DATAMODE;
+    const char* delay = SBDOP_DEFAULT_DELAY;
+    const char* burst = SBDOP_DEFAULT_BURST;
+    const char* chunk = SBDOP_DEFAULT_CHUNK;
+    const char* rate = NULL;
+    const char* gap = NULL;
+    const char* offset = NULL;
+    const char* length = NULL;
+    const char* wait = NULL;
+    const char* port = NULL;
+    const char* file = NULL;
+
+    const struct
+    {
+        const char* name;
+        const char** value;
+    }options[] = {
+            {"-p", &port}, {"-f", &file}, {"-b", &baudrate}, {"-dm", &datamode}, {"-dl", &delay}, {"-bst", &burst},
+            {"-ck", &chunk}, {"-rt", &rate}, {"-gp", &gap}, {"-of", &offset}, {"-ln", &length}, {"-wa", &wait}
+    };
+    for(size_t i = 0; i < tokens.size(); i += 2)
+    {
+        if((i + 1) == tokens.size())
+        {
+            return "option without value";
+        }
+        size_t opt = 0;
+        while((opt < ARRAY_LENGTH(options)) && (strcmp(tokens[i], options[opt].name) != 0))
+        {
+            opt++;
+        }
+        if(opt == ARRAY_LENGTH(options))
+        {
+            return "unknown option";
+        }
+        *options[opt].value = tokens[i + 1];
+    }
+
+    if(port == NULL)
+    {
+        return "port (-p) not given";
+    }
+    if((file == NULL) && (wait == NULL))
+    {
+        return "neither file (-f) nor wait (-wa) given";
+    }
+    step->port = port;
+    step->filename = (file != NULL) ? file : "";
+    step->baud = SBDOP_GetBaudRateFromName(baudrate);
+    if(step->baud == -1)
+    {
+        return "baudrate not supported";
+    }
+    if(!SBDOP_ValidDataMode(datamode))
+    {
+        return "data mode not supported";
+    }
+    step->datamode = datamode;
+    step->delay_ms = SBDOP_GetDelayFromName(delay);
+    if((step->delay_ms == -1) || (step->delay_ms > SBDOP_MAX_DELAYMS))
+    {
+        return "invalid delay";
+    }
+    step->burst = SBDOP_GetBurstFromName(burst);
+    if(step->burst <= 0)
+    {
+        return "invalid burst";
+    }
+    step->chunk = SBDOP_GetChunkFromName(chunk);
+    if((step->chunk <= 0) || (step->chunk > SBDOP_MAX_CHUNK))
+    {
+        return "invalid chunk";
+    }
+    step->rate = 0;
+    if((rate != NULL) && ((step->rate = SBDOP_GetRateFromName(rate)) == 0))
+    {
+        return "invalid rate";
+    }
+    int gap_us = 0;
+    if((gap != NULL) && ((gap_us = SBDOP_GetDelayFromName(gap)) <= 0))
+    {
+        return "invalid gap";
+    }
+    step->gap_us = (uint32_t)gap_us;
+    if(((step->rate > 0) && (gap_us > 0)) || (((step->rate > 0) || (gap_us > 0)) && (step->delay_ms > 0)))
+    {
+        return "only one of: delay, rate, gap can be given";
+    }
+    int wait_ms = 0;
+    if((wait != NULL) && ((wait_ms = SBDOP_GetDelayFromName(wait)) == -1))
+    {
+        return "invalid wait";
+    }
+    step->wait_ms = (uint32_t)wait_ms;
+
+    step->offset = 0;
+    step->length = 0;
+    if(file == NULL)
+    {
+        return ((offset == NULL) && (length == NULL)) ? NULL : "offset or length without file";
+    }
+    std::map<std::string, uint64_t>::iterator found = filesizes.find(file);
+    if(found == filesizes.end())
+    {
+        uint64_t filesize = 0;
+        if(!SBDOP_ValidFile(file, &filesize))
+        {
+            return "cannot open file (or not a regular file)";
+        }
+        if(filesize == SBDOP_FILESIZE_UNKNOWN)
+        {
+            return "streams (stdin, FIFO) cannot be steps";
+        }
+        found = filesizes.insert(std::make_pair(std::string(file), filesize)).first;
+    }
+    if((offset != NULL) && !SBDOP_GetSizeFromName(offset, &step->offset))
+    {
+        return "invalid offset";
+    }
+    if(step->offset > found->second)
+    {
+        return "offset beyond the end of file";
+    }
+    step->length = found->second - step->offset;
+    if((length != NULL) && !SBDOP_GetSizeFromName(length, &step->length))
+    {
+        return "invalid length";
+    }
+    if((step->length == 0) || (step->length > (found->second - step->offset)))
+    {
+        return "length out of the file";
+    }
+    if(!SBDOP_ValidBurst((uint32_t)step->burst, step->length))
+    {
+        return "burst greater than length, or length not dividable by burst";
+    }
+
+    return NULL;
+}
+
+uint8_t SBDOP_LoadManifest(
+        const char* manifest,
+        std::vector<sbdop_step_t>& steps)
+{
+    steps.clear();
+    if(manifest == NULL)
+    {
+        return FALSE;
+    }
+
+    FILE* file = fopen(manifest, "r");
+    if(file == NULL)
+    {
+        printf("Error! Cannot open manifest: %s.\n", manifest);
+        return FALSE;
+    }
+
+    std::map<std::string, uint64_t> filesizes;
+    char line[1024];
+    uint32_t line_nr = 0;
+    uint8_t valid = TRUE;
+    while(fgets(line, sizeof(line), file) != NULL)
+    {
+        line_nr++;
+        char* comment = strchr(line, '#');
+        if(comment != NULL)
+        {
+            *comment = '\0';
+        }
+        std::vector<const char*> tokens;
+        for(char* token = strtok(line, " \t\r\n"); token != NULL; token = strtok(NULL, " \t\r\n"))
+        {
+            tokens.push_back(token);
+        }
+        if(tokens.empty())
+        {
+            continue;
+        }
+
+        sbdop_step_t step;
+        const char* error = SBDOP_ParseStep(tokens, &step, filesizes);
+        if(error != NULL)
+        {
+            printf("Error! Manifest line %u: %s.\n", line_nr, error);
+            valid = FALSE;
+            break;
+        }
+        step.line = line_nr;
+        steps.push_back(step);
+    }
+    fclose(file);
+
+    if(valid && steps.empty())
+    {
+        printf("Error! Manifest %s has no steps.\n", manifest);
+        valid = FALSE;
+    }
+
+    return valid;
+}
+
+int SBDOP_DumpManifest(
+        const std::vector<sbdop_step_t>& steps,
+        int ring_depth,
+        sbdop_engine_t engine)
+{
+    if(steps.empty() || ring_depth <= 0)
+    {
+        return -1;
+    }
+
+    std::vector<std::string> ports;
+    std::map<std::string, uint64_t> sizes; // of the files, up to the end of the last part dumped
+    for(size_t i = 0; i < steps.size(); i++)
+    {
+        if(std::find(ports.begin(), ports.end(), steps[i].port) == ports.end())
+        {
+            ports.push_back(steps[i].port);
+        }
+        if(!steps[i].filename.empty())
+        {
+            uint64_t& size = sizes[steps[i].filename];
+            size = std::max(size, steps[i].offset + steps[i].length);
+        }
+    }
+
+    // all the files are opened (mapped, read-ahead started) before the first step, and shared by the steps
+    std::map<std::string, sbdop_source_t> images;
+    int ret = 0;
+    for(std::map<std::string, uint64_t>::iterator it = sizes.begin(); it != sizes.end(); it++)
+    {
+        sbdop_source_t& image = images[it->first];
+        if(!SBDOP_SourceOpen(&image, it->first.c_str(), it->second) || !SBDOP_SourceLoad(&image, it->second))
+        {
+            printf("Error! Unable to load file: %s.\n", it->first.c_str());
+            ret = -1;
+            break;
+        }
+    }
+
+    if(ret == 0)
+    {
+        printf("Prefetched %u file(s), running %u step(s) on %u port(s).\n",
+                (unsigned int)images.size(),
+                (unsigned int)steps.size(),
+                (unsigned int)ports.size());
+        fflush(stdout);
+
+        // a single io_uring engine thread keeps all the ports busy
+        sbdop_uring_t uring;
+        sbdop_uring_t* uring_engine = NULL;
+        if((engine == SBDOP_ENGINE_URING) && SerialUring::IsSupported() &&
+           SBDOP_UringStart(&uring, (uint32_t)ports.size(), (uint32_t)ring_depth))
+        {
+            uring_engine = &uring;
+        }
+
+        uint32_t ports_ok = SBDOP_PortDumpsRun(ports,
+                [&steps, &images, ring_depth, engine, uring_engine](const std::string& portname, const char* tag)
+                {
+                    // the port stays open between the steps, settings are changed in place
+                    SerialPort port;
+                    int baud = 0;
+                    std::string datamode;
+                    for(size_t i = 0; i < steps.size(); i++)
+                    {
+                        const sbdop_step_t& step = steps[i];
+                        if(step.port != portname)
+                        {
+                            continue;
+                        }
+                        if(!port.IsOpened())
+                        {
+                            if(port.Open(portname.c_str(), step.baud, step.datamode.c_str()) != EC_OK)
+                            {
+                                printf("%sError! Unable to open serial port.\n", tag);
+                                return -1;
+                            }
+                        }
+                        else if(((step.baud != baud) || (step.datamode != datamode)) &&
+                                (port.Configure(step.baud, step.datamode.c_str()) != EC_OK))
+                        {
+                            printf("%sError! Unable to change port settings (manifest line %u).\n", tag, step.line);
+                            return -1;
+                        }
+                        baud = step.baud;
+                        datamode = step.datamode;
+
+                        if(!step.filename.empty())
+                        {
+                            printf("%sstep (manifest line %u): %s, %" PRIu64 " bytes at %" PRIu64 ", %d bps %s.\n",
+                                    tag,
+                                    step.line,
+                                    step.filename.c_str(),
+                                    step.length,
+                                    step.offset,
+                                    step.baud,
+                                    step.datamode.c_str());
+                            fflush(stdout);
+                            if(SBDOP_DumpOnPort(&port, portname.c_str(), step.baud, step.delay_ms, step.burst, step.chunk,
+                                    ring_depth, engine, step.rate, step.gap_us, step.datamode.c_str(), step.filename.c_str(),
+                                    step.offset, step.length, &images.find(step.filename)->second, tag,
+                                    uring_engine) != 0)
+                            {
+                                printf("%sError! Step (manifest line %u) failed.\n", tag, step.line);
+                                return -1;
+                            }
+                        }
+                        if(step.wait_ms > 0)
+                        {
+                            std::this_thread::sleep_for(std::chrono::milliseconds(step.wait_ms));
+                        }
+                    }
+                    return 0;
+                });
+
+        if(uring_engine != NULL)
+        {
+            SBDOP_UringStop(uring_engine);
+        }
+
+        printf("Ports succeeded: %u / %u.\n", ports_ok, (unsigned int)ports.size());
+        if(ports_ok != ports.size())
+        {
+            ret = -1;
+        }
+    }
+
+    for(std::map<std::string, sbdop_source_t>::iterator it = images.begin(); it != images.end(); it++)
+    {
+        SBDOP_SourceClose(&it->second);
+    }
+
+    return ret;
+}
+
+static void SBDOP_WatchSignalHandler(int sig)
+{
+    (void)sig;
+    sbdop_watch_stop = 1;
+    if(sbdop_watch_hotplug != NULL)
+    {
+        sbdop_watch_hotplug->Interrupt();
+    }
+
+    // the next Ctrl+C terminates the app right away
+    signal(SIGINT, SIG_DFL);
+    signal(SIGTERM, SIG_DFL);
+}
+
+int SBDOP_WatchAndDump(
+        const char* pattern,
+        int baud,
+        int delay_ms,
+        int burst,
+        int chunk,
+        int ring_depth,
+        sbdop_engine_t engine,
+        uint64_t rate,
+        uint32_t gap_us,
+        const char* datamode,
+        const char* filename,
+        uint64_t filesize)
+{
+    if(pattern == NULL || datamode == NULL || filename == NULL)
+    {
+        return -1;
+    }
+
+    SerialHotplug hotplug;
+    if(!SerialHotplug::IsSupported() || (hotplug.Start(pattern) != EC_OK))
+    {
+        printf("Error! Unable to watch for serial ports matching: %s.\n", pattern);
+        return -1;
+    }
+    printf("Watching (%s) for serial ports matching: %s. Press Ctrl+C to stop.\n",
+            hotplug.GetSource(),
+            pattern);
+    fflush(stdout);
+
+    // text progress of parallel dumps would interleave, progress lines tell their ports
+    sbdop_progress_t progress_format = sbdop_progress_format;
+    if(progress_format == SBDOP_PROGRESS_TEXT)
+    {
+        sbdop_progress_format = SBDOP_PROGRESS_NONE;
+    }
+
+    std::list<sbdop_port_dump_t> running; // list, so dumps stay in place for their threads
+    uint32_t dumps_cnt = 0;
+    uint32_t dumps_ok = 0;
+    int ret = 0;
+
+    sbdop_watch_stop = 0;
+    sbdop_watch_hotplug = &hotplug;
+    signal(SIGINT, SBDOP_WatchSignalHandler);
+    signal(SIGTERM, SBDOP_WatchSignalHandler);
+
+    while(!sbdop_watch_stop)
+    {
+        std::vector<SerialHotplug::event_t> events;
+        if(hotplug.Wait(events, SBDOP_WATCH_POLL_MS) != EC_OK)
+        {
+            printf("Error! Watching for serial ports failed.\n");
+            ret = -1;
+            break;
+        }
+
+        for(size_t i = 0; i < events.size(); i++)
+        {
+            const SerialHotplug::event_t& event = events[i];
+            if(event.change == SerialHotplug::PORT_REMOVED)
+            {
+                printf("Port %s unplugged.\n", event.port.c_str());
+                for(std::list<sbdop_port_dump_t>::iterator it = running.begin(); it != running.end(); it++)
+                {
+                    if((it->port == event.port) && !it->done)
+                    {
+                        it->unplugged = TRUE;
+                    }
+                }
+                continue;
+            }
+
+            printf("Port %s plugged in, dumping.\n", event.port.c_str());
+            running.emplace_back();
+            sbdop_port_dump_t& dump = running.back();
+            dump.port = event.port;
+            dump.done = false;
+            dump.ret = -1;
+            dump.unplugged = FALSE;
+            dump.time_ms = 0;
+            dump.thread = std::thread([&dump, baud, delay_ms, burst, chunk, ring_depth, engine, rate, gap_us, datamode, filename, filesize]()
+            {
+                std::this_thread::sleep_for(std::chrono::milliseconds(SBDOP_WATCH_SETTLE_MS));
+                auto start = std::chrono::steady_clock::now();
+                std::string tag = dump.port + ": ";
+                dump.ret = SBDOP_DumpToPort(
+                        dump.port.c_str(), baud, delay_ms, burst, chunk, ring_depth, engine, rate, gap_us, datamode, filename, filesize,
+                        NULL, tag.c_str(), NULL);
+                dump.time_ms = (uint32_t)std::chrono::duration_cast<std::chrono::milliseconds>(
+                        std::chrono::steady_clock::now() - start).count();
+                dump.done = true;
+            });
+        }
+        fflush(stdout);
+
+        // collect finished dumps
+        for(std::list<sbdop_port_dump_t>::iterator it = running.begin(); it != running.end(); )
+        {
+            if(!it->done)
+            {
+                it++;
+                continue;
+            }
+            dumps_cnt++;
+            dumps_ok += SBDOP_PortDumpDone(&(*it));
+            it = running.erase(it);
+        }
+    }
+
+    signal(SIGINT, SIG_DFL);
+    signal(SIGTERM, SIG_DFL);
+    sbdop_watch_hotplug = NULL;
+    hotplug.Stop();
+
+    if(!running.empty())
+    {
+        printf("Waiting for %u dump(s) in progress...\n", (unsigned int)running.size());
+        fflush(stdout);
+    }
+    for(std::list<sbdop_port_dump_t>::iterator it = running.begin(); it != running.end(); it++)
+    {
+        dumps_cnt++;
+        dumps_ok += SBDOP_PortDumpDone(&(*it));
+    }
+    sbdop_progress_format = progress_format;
+
+    printf("Dumps succeeded: %u / %u.\n", dumps_ok, dumps_cnt);
+    if(dumps_ok != dumps_cnt)
+    {
+        ret = -1;
+    }
 
     return ret;
 }
 
 uint16_t SBDOP_PercentageCompletion(
-        uint32_t x,
-        uint32_t y)
+        uint64_t x,
+        uint64_t y)
 {
     if(x > y)
     {
@@ -548,8 +3212,10 @@ void SBDOP_Delay(uint32_t delay_ms)
 {
 #if defined(__linux__) || defined(__FreeBSD__)   /* Linux & FreeBSD */
         //usleep((delay_ms*1000)); //POSIX, <unistd.h> - deprecated
-        uint32_t delay_ns = delay_ms * 1000000;
-        nanosleep(&((struct timespec){.tv_nsec = delay_ns, .tv_sec= 0}), NULL);
+        struct timespec ts;
+        ts.tv_sec = delay_ms / 1000;
+        ts.tv_nsec = (long)(delay_ms % 1000) * 1000000L;
+        nanosleep(&ts, NULL);
 #else
         /*
          * TIP:
@@ -27,60 +27,111 @@
 #ifndef SBDOP_H_
 #define SBDOP_H_
 
-#include "rs232.h"
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+#include "serialport/SerialPort.hpp"
 
-#if defined(__linux__) || defined(__FreeBSD__)   /* Linux & FreeBSD */
 #ifndef TRUE
 #define TRUE 1
 #endif
 #ifndef FALSE
 #define FALSE 0
 #endif
-#endif
 
-#if defined(__linux__) || defined(__FreeBSD__)   /* Linux & FreeBSD */
-#define MAX_SYS_COMPORTS 38
-#else
-#define MAX_SYS_COMPORTS 32
-#endif
-extern const char* portnames_h[MAX_SYS_COMPORTS];
+//!< Size of a stream (stdin, FIFO), known once it ends
+#define SBDOP_FILESIZE_UNKNOWN UINT64_MAX
 
-//!< Max file size to be dumped is 1GB
-#define SBDOP_MAX_FILESIZE 1073741824
+//!< Block size (in bytes) of files streamed, rather than mapped into memory, and of the ring's blocks
+#define SBDOP_STREAM_BLOCK_SIZE 65536
 
-#if defined(__linux__) || defined(__FreeBSD__)   /* Linux & FreeBSD */
-//!< Max delay (miliseconds) supported by this app (nanosleep limit)
-#define SBDOP_MAX_DELAYMS 999
-#else
 //!< Max delay (miliseconds) supported by this app
 #define SBDOP_MAX_DELAYMS 60000
-#endif
 
 #define SBDOP_DEFAULT_BAUDRATE "9600"
 #define SBDOP_DEFAULT_DATAMODE "8n1"
 #define SBDOP_DEFAULT_DELAY "0"
 #define SBDOP_DEFAULT_BURST "1"
+#define SBDOP_DEFAULT_CHUNK "4096"
+#define SBDOP_DEFAULT_RING_DEPTH "8"
+#define SBDOP_DEFAULT_ENGINE "rw"
+
+//!< Max chunk (bytes written to the port by a single write)
+#define SBDOP_MAX_CHUNK 1048576
+
+//!< Max depth (blocks) of the ring between the file reader and the port writer
+#define SBDOP_MAX_RING_DEPTH 1024
+
+//!< Interval (in miliseconds) of progress reports
+#define SBDOP_PROGRESS_INTERVAL_MS 500
+
+typedef enum
+{
+    SBDOP_ENGINE_RW = 0, //!< reader thread and ring, write() calls to the port (reactor driven where supported)
+    SBDOP_ENGINE_URING = 1, //!< io_uring: linked read -> write requests on registered buffers (Linux 5.17+)
+
+    SBDOP_ENGINE_INVALID = 0xFF
+}sbdop_engine_t;
+
+typedef enum
+{
+    SBDOP_PROGRESS_TEXT = 0, //!< single, rewritten line for humans
+    SBDOP_PROGRESS_LINE = 1, //!< a "progress key=value ..." line per report, for scripts and line controllers
+    SBDOP_PROGRESS_NONE = 2,
+
+    SBDOP_PROGRESS_INVALID = 0xFF
+}sbdop_progress_t;
 
 typedef enum
 {
     OP_DISP_HELP = 0,
     OP_LIST_COMPORTS = 1,
     OP_DUMP_BINARY = 2,
+    OP_DUMP_MANIFEST = 3,
 
     OP_INVALID = 0xFF
 }op_t;
 
 typedef struct
 {
-    const char* portname;
+    const char* portname; // port, or comma separated list of ports
     const char* baudrate;
     const char* datamode; // 8N1, 9N2, ...
     const char* filename;
     const char* delay;
     const char* burst;
+    const char* chunk;
+    const char* ring; // ring depth (blocks)
+    const char* engine; // I/O engine: rw, uring
+    const char* rate;
+    const char* gap;
+    const char* watch; // port pattern to watch for (see SBDOP_WatchAndDump())
+    const char* progress; // progress format: text, line, none
+    const char* manifest; // manifest of dump steps (see SBDOP_LoadManifest())
     uint8_t reserved[20];
 }op_args_db_t;
 
+/*
+ * A step of a manifest (see SBDOP_LoadManifest()).
+ */
+typedef struct
+{
+    std::string port;
+    std::string filename; //!< empty if the step only waits
+    uint64_t offset; //!< offset of the dumped part within the file
+    uint64_t length; //!< size of the dumped part
+    int baud;
+    std::string datamode;
+    int delay_ms;
+    int burst;
+    int chunk;
+    uint64_t rate;
+    uint32_t gap_us;
+    uint32_t wait_ms; //!< wait after the step
+    uint32_t line; //!< line of the manifest
+}sbdop_step_t;
+
 typedef union
 {
     uint8_t value_arr[32];
@@ -98,14 +149,6 @@ typedef struct
  */
 void SBDOP_DispHelpInfo(void);
 
-/*
- * @brief Gets com port number (int) from portname (const char*).
- * @param portname A pointer to the name of the port.
- * @retval 0-(MAX_SYS_COMPORTS-1) Valid com port number.
- * @retval -1 Cannot get port number from given name.
- */
-int SBDOP_GetComPortNumFromName(const char* portname);
-
 /*
  * @brief Gets baudrate (int) from baudrate (const char*).
  * @param baudrate A pointer to the baudrate.
@@ -126,7 +169,10 @@ uint8_t SBDOP_ValidDataMode(const char* datamode);
  * @brief Validates file with given filename.
  * @details
  * Validating a file means to check if it exists, if it is able to be opened andd
- * if it is smaller than SBDOP_MAX_FILESIZE.
+ * if it is a regular file. Its size is taken from the file system (fstat),
+ * so validation takes the same time for files of any size.
+ * Streams are valid too, their size is SBDOP_FILESIZE_UNKNOWN: "-" (stdin) and FIFOs (Linux),
+ * which are not opened (that would block until their writer opens them), just checked to be readable.
  * @param filename A name of the file to validate.
  * @param filesize A pointer where this function will save the size (in bytes) of the validated file.
  * Value under this parameter is valid only if function returns with success.
@@ -136,16 +182,26 @@ uint8_t SBDOP_ValidDataMode(const char* datamode);
  */
 uint8_t SBDOP_ValidFile(
         const char* filename,
-        uint32_t* filesize);
+        uint64_t* filesize);
 
 /*
  * @brief Validates com port with given portname (checks if it is possible to open such port).
- * @param portname A name of the port to be validated.
+ * @param portname A name of the port (i.e. ttyUSB0, COM3) or its device path to be validated.
  * @retval TRUE If such port is valid and usable.
  * @retval FALSE If such port is invalid (unusable).
  */
 uint8_t SBDOP_ValidComPort(const char* portname);
 
+/*
+ * @brief Splits comma separated list of ports (i.e. ttyUSB0,ttyUSB1) into port names.
+ * @param ports Where this function will save the port names.
+ * @retval TRUE If the list is valid.
+ * @retval FALSE If the list is invalid (empty name or a port given more than once).
+ */
+uint8_t SBDOP_GetPortNames(
+        const char* portnames,
+        std::vector<std::string>& ports);
+
 /*
  * @brief Returns delay (as int) from the given delay (const char*).
  * @param delay A delay as const char*
@@ -162,6 +218,55 @@ int SBDOP_GetDelayFromName(const char* delay);
  */
 int SBDOP_GetBurstFromName(const char* burst);
 
+/*
+ * @brief Returns chunk (as int) from the given chunk (const char*).
+ * @param chunk A chunk as const char*
+ * @retval -1 Failed to get int from given const char*
+ * @retval !-1 The chunk as int.
+ */
+int SBDOP_GetChunkFromName(const char* chunk);
+
+/*
+ * @brief Returns ring depth (as int) from the given ring depth (const char*).
+ * @retval -1 Failed to get int from given const char*
+ * @retval !-1 The ring depth as int.
+ */
+int SBDOP_GetRingDepthFromName(const char* ring);
+
+/*
+ * @brief Returns I/O engine from the given name: rw, uring.
+ * @retval SBDOP_ENGINE_INVALID Unknown name.
+ */
+sbdop_engine_t SBDOP_GetEngineFromName(const char* engine);
+
+/*
+ * @brief Returns rate (bytes/s) from the given rate (const char*), i.e. 40000, 40000B/s, 40kB/s, 1MB/s.
+ * @retval 0 Failed to get rate from given const char*
+ * @retval >0 The rate (bytes/s).
+ */
+uint64_t SBDOP_GetRateFromName(const char* rate);
+
+/*
+ * @brief Returns progress format from the given name: text, line, none.
+ * @retval SBDOP_PROGRESS_INVALID Unknown name.
+ */
+sbdop_progress_t SBDOP_GetProgressFromName(const char* progress);
+
+/*
+ * @brief Sets how progress of dumps is reported.
+ * @details
+ * Progress is reported every SBDOP_PROGRESS_INTERVAL_MS by a reporter thread of the dump
+ * (the send loop only updates counters), and once more when the dump finishes.
+ * Reports contain: bytes sent, percentage, rate (bytes/s, over the last interval),
+ * ETA and, for paced dumps, burst start jitter (mean over the last interval, max so far).
+ * SBDOP_PROGRESS_LINE format (one line per report, fields separated by spaces):
+ * progress port=<port> sent=<bytes> size=<bytes> percent=<0-100> rate=<bytes/s> eta_s=<s>
+ * [jitter_us=<mean> jitter_max_us=<max>] state=<running|done|failed>
+ * Streams (size SBDOP_FILESIZE_UNKNOWN) report bytes sent and rate only:
+ * progress port=<port> sent=<bytes> rate=<bytes/s> [jitter_us=<mean> jitter_max_us=<max>] state=<...>
+ */
+void SBDOP_SetProgressFormat(sbdop_progress_t format);
+
 /*
  * @brief Validates burst.
  *
@@ -173,7 +278,7 @@ int SBDOP_GetBurstFromName(const char* burst);
  */
 uint8_t SBDOP_ValidBurst(
         uint32_t burst,
-        uint32_t datasize);
+        uint64_t datasize);
 
 /*
  * @brief Lists system's available com ports names.
@@ -183,10 +288,30 @@ void SBDOP_ListComPorts(void);
 /*
  * @brief Dumps binary file to com port.
  *
- * @param portnum Number of serial port to which the binary file shall be dumped.
+ * @details
+ * Where supported (see SerialReactor::IsSupported()), the dump is driven by
+ * a SerialReactor: data is written when the port is writable and delays are
+ * reactor timeouts, so the thread sleeps in the OS in between.
+ * Otherwise data is written with blocking writes and SBDOP_Delay().
+ * The file is mapped into memory (Linux) and sent straight from the mapping,
+ * with sequential read-ahead hinted to the kernel. Files that cannot be mapped
+ * (and all the files on Windows) are streamed in SBDOP_STREAM_BLOCK_SIZE blocks.
+ * The file is read by a reader thread into a ring of ring_depth blocks, which the dump
+ * sends from, so slow file reads and a full port do not stall each other.
+ * Blocks of a mapped file are slices of the mapping (the reader faults their pages in),
+ * only streamed files are copied into the ring.
+ * Only about SBDOP_TXQ_MAX_US of wire time (see SerialPort::GetBitsPerByte()) is kept
+ * queued in the port's output buffer (TIOCOUTQ, or the wire time model where the OS
+ * does not tell), so progress and delays follow the physical line and the tail left
+ * to drain at the end is short. Delays start once the burst has left the wire.
+ *
+ * @param portname Name (or device path) of serial port to which the binary file shall be dumped.
  * @param baud Baudrate to use with serial port.
  * @param datamode Datamode to use with serial port.
- * @param filename A name of the binary file to be dumped.
+ * @param filename A name of the binary file to be dumped, "-" for stdin.
+ * @param filesize Size of the file, SBDOP_FILESIZE_UNKNOWN to stream it (stdin, FIFO): data is read
+ * as it comes (a pipe's read returns what is there, the ring passes partial blocks on) and sent
+ * until the stream ends. Streams are never mapped nor sent by the io_uring engine.
  * @param delay_ms A delay (in miliseconds) to be used between each binary character send.
  * @param burst A burst (in bytes) to be applied.
  * Burst > 1 means that:
@@ -194,18 +319,139 @@ void SBDOP_ListComPorts(void);
  * - there is no delay between bytes send in group
  * - delay_ms parameter is interpreted as a delay
  * between each group transmission.
+ * @param chunk Maximum number of bytes written to the port by a single write.
+ * Data is written in chunks regardless of burst, a chunk never spans a delay.
+ * @param ring_depth Depth (in SBDOP_STREAM_BLOCK_SIZE blocks) of the ring between the file reader and the dump
+ * (number of registered buffers with SBDOP_ENGINE_URING).
+ * @param engine I/O engine, SBDOP_ENGINE_URING falls back to SBDOP_ENGINE_RW if io_uring is not available.
+ * With io_uring the file is sent in chains of linked read -> write (-> timeout) requests,
+ * a chain of up to ring_depth blocks per system call, bounded by the port's output queue the same way.
+ * Jitter of burst starts is not measured then.
+ * @param rate Target rate (bytes/s) bursts are paced with, 0 if not paced by rate.
+ * @param gap_us Time (in microseconds) between starts of consecutive bursts, 0 if not paced by gap.
+ * Paced bursts start on absolute deadlines (clock_nanosleep(TIMER_ABSTIME) on Linux),
+ * achieved rate and jitter of burst starts are displayed at the end. Pacing replaces delay_ms.
  *
  * @retval -1 If failed to dump binary file to port.
  * @retval 0 If succeeded to dump binary file to port.
  */
 int SBDOP_DumpBinaryToPort(
-        int portnum,
+        const char* portname,
+        int baud,
+        int delay_ms,
+        int burst,
+        int chunk,
+        int ring_depth,
+        sbdop_engine_t engine,
+        uint64_t rate,
+        uint32_t gap_us,
+        const char* datamode,
+        const char* filename,
+        uint64_t filesize);
+
+/*
+ * @brief Dumps binary file to several ports at once.
+ *
+ * @details
+ * The file is mapped into memory (or read into memory, where it cannot be mapped) once,
+ * and shared read-only by the dumps: each port gets its own dump (see SBDOP_DumpBinaryToPort())
+ * with its own reader thread, ring and pacing, running in its own thread. With SBDOP_ENGINE_URING
+ * each dump reads the file by itself, from the page cache shared by all of them, and the chains
+ * of all the dumps are driven by a single thread on a single io_uring.
+ * Dumps are reported as they finish, a slow or failed port does not hold the others up.
+ * Text progress is not displayed (dumps run in parallel), line progress is.
+ *
+ * @param portnames Names (or device paths) of serial ports to which the binary file shall be dumped.
+ * Other parameters: see SBDOP_DumpBinaryToPort().
+ *
+ * @retval -1 If any of the dumps failed.
+ * @retval 0 If all the dumps succeeded.
+ */
+int SBDOP_DumpBinaryToPorts(
+        const std::vector<std::string>& portnames,
+        int baud,
+        int delay_ms,
+        int burst,
+        int chunk,
+        int ring_depth,
+        sbdop_engine_t engine,
+        uint64_t rate,
+        uint32_t gap_us,
+        const char* datamode,
+        const char* filename,
+        uint64_t filesize);
+
+/*
+ * @brief Loads and validates manifest: ordered dump steps, each for a port.
+ *
+ * @details
+ * A step per line, given by the same options as the command line (values must not contain spaces):
+ * -p <port> [-f <file> [-of <offset>] [-ln <length>]] [-b <baudrate>] [-dm <datamode>]
+ * [-dl <delay> | -rt <rate> | -gp <gap>] [-bst <burst>] [-ck <chunk>] [-wa <wait>]
+ * -of, -ln: offset and length (bytes, decimal or 0x hex) of the part of the file to dump,
+ * the whole file by default. -wa: wait (miliseconds) after the step, a step without a file only waits.
+ * Options not given take the defaults (SBDOP_DEFAULT_*), not values of the previous steps.
+ * Empty lines and text following '#' are ignored.
+ * Errors are displayed with the line they were found on. Each file is validated once.
+ *
+ * @param steps Where this function will save the steps.
+ * @retval TRUE If the manifest is valid.
+ * @retval FALSE If the manifest is invalid or cannot be read.
+ */
+uint8_t SBDOP_LoadManifest(
+        const char* manifest,
+        std::vector<sbdop_step_t>& steps);
+
+/*
+ * @brief Runs steps of a manifest (see SBDOP_LoadManifest()).
+ *
+ * @details
+ * All the files are opened (mapped and read ahead, see SBDOP_DumpBinaryToPort()) before the first step,
+ * and shared by the steps and the ports. Steps of each port run in order, in a thread of the port,
+ * ports run in parallel (see SBDOP_DumpBinaryToPorts()). The port is opened once: between the steps
+ * it stays open and its settings are changed in place (see SerialPort::Configure()).
+ * Each step drains the port before its wait starts. A failed step stops the steps of its port.
+ * With SBDOP_ENGINE_URING steps of all the ports share a single io_uring and its thread.
+ *
+ * @param ring_depth, engine See SBDOP_DumpBinaryToPort(), used by all the steps.
+ *
+ * @retval -1 If steps of any of the ports failed.
+ * @retval 0 If all the steps succeeded.
+ */
+int SBDOP_DumpManifest(
+        const std::vector<sbdop_step_t>& steps,
+        int ring_depth,
+        sbdop_engine_t engine);
+
+/*
+ * @brief Dumps binary file to each port matching pattern as soon as it is plugged in.
+ *
+ * @details
+ * Ports are watched for with SerialHotplug (Linux only). Each plugged in port gets
+ * its own dump (see SBDOP_DumpBinaryToPort()) running in its own thread,
+ * so several ports are dumped to in parallel. Dump to a port that gets unplugged
+ * fails on its next write. Watching runs until interrupted (Ctrl+C),
+ * then dumps in progress are finished.
+ *
+ * @param pattern Port pattern or device path pattern (see SerialHotplug).
+ * Other parameters: see SBDOP_DumpBinaryToPort().
+ *
+ * @retval -1 If failed to watch or any of the dumps failed.
+ * @retval 0 If all the dumps succeeded.
+ */
+int SBDOP_WatchAndDump(
+        const char* pattern,
         int baud,
         int delay_ms,
         int burst,
+        int chunk,
+        int ring_depth,
+        sbdop_engine_t engine,
+        uint64_t rate,
+        uint32_t gap_us,
         const char* datamode,
         const char* filename,
-        uint32_t filesize);
+        uint64_t filesize);
 
 /*
  * @brief Returns x*100 / y as uint16_t.
@@ -214,8 +460,8 @@ int SBDOP_DumpBinaryToPort(
  * @retval 0xFFFF Error: probably x is not <= y.
  */
 uint16_t SBDOP_PercentageCompletion(
-        uint32_t x,
-        uint32_t y);
+        uint64_t x,
+        uint64_t y);
 
 /*
  * @brief Performs delay.
@@ -29,7 +29,9 @@
 
 #include <devices/SensX.hpp>
 #include <iostream>
+#include <string>
 #include <vector>
+#include <mutex>
 
 #include "ec.h"
 #include "serial/Serial.hpp"
@@ -42,6 +44,9 @@ public:
     {
         APP_OPTION_PORT_SELECTION = 0x00,
         APP_OPTION_ENABLE_STRESS = 0x01,
+        APP_OPTION_PIPELINE_WINDOW = 0x02,
+        APP_OPTION_JOBS = 0x03,
+        APP_OPTION_WATCH = 0x04,
 
         APP_OPTION_RESERVED = 0xFF
     }app_option_type_t;
@@ -64,21 +69,72 @@ private:
     static constexpr const char* defaultDut = "sensx";
     const std::vector<const char*> opts_abbr = {
             static_cast<const char*>("-p"), // APP_OPTION_PORT_SELECTION,
-            static_cast<const char*>("-s") // APP_OPTION_ENABLE_STRESS
+            static_cast<const char*>("-s"), // APP_OPTION_ENABLE_STRESS
+            static_cast<const char*>("-w"), // APP_OPTION_PIPELINE_WINDOW
+            static_cast<const char*>("-j"), // APP_OPTION_JOBS
+            static_cast<const char*>("-wt") // APP_OPTION_WATCH
     };
 
+    static const uint32_t maxJobs = 64;
+
+    //!< Time (in milliseconds) given to a plugged in port to settle (i.e. udev to set its permissions).
+    static constexpr uint32_t watchSettleMs = 500;
+
+    //!< Maximum time (in milliseconds) of waiting for hotplug events, before finished DUTs are collected.
+    static constexpr uint32_t watchPollMs = 200;
+
+    typedef struct
+    {
+        std::string port;
+        bool passed;
+        bool unplugged; //!< DUT was unplugged while being tested (watch mode)
+        uint32_t wallTimeMs;
+    }dut_result_t;
+
     bool initOk;
 
     SerialDeviceTester* m_tester;
     std::vector<app_option_t> options;
     const char* dut;
     bool stressTestsEnable;
+    uint32_t pipelineWindow;
+    uint32_t jobs; //!< maximum number of DUTs tested concurrently, 0 - no limit
+    std::vector<std::string> ports; //!< ports of DUTs to test
+    std::mutex outputMutex;
 
     ec_t Init(void);
     ec_t ParseArgs(int argc, const char** argv);
     void DispHelp(void);
     const char* GetDut(void);
-    bool RunTests(void);
+
+    //!< Fills ports with DUT ports given by -p option (list and/or patterns).
+    ec_t SelectPorts(const char* portArg);
+
+    //!< Runs all the tests with given tester, test output goes to out.
+    bool RunTests(SerialDeviceTester* tester, FILE* out);
+
+    /*
+     * Runs all the tests on each of ports, each DUT in its own worker thread
+     * with its own tester (serial port and device instances), up to jobs workers at once.
+     * Prints per-DUT results and a summary.
+     * Returns true if all the DUTs passed.
+     */
+    bool RunParallel(void);
+
+    //!< Runs all the tests on a single DUT of a parallel run, with given tester.
+    void RunDut(dut_result_t& result, SerialDeviceTester& tester);
+
+    //!< Prints summary of a parallel (or watch mode) run.
+    static void PrintSummary(const std::vector<dut_result_t>& results, uint32_t totalMs);
+
+    /*
+     * Watches for ports matching pattern (see SerialHotplug) and runs all the tests
+     * on each DUT as soon as it is plugged in, DUTs in parallel (up to jobs at once).
+     * Tests of DUT unplugged while being tested are cancelled and the DUT is reported as such.
+     * Runs until interrupted (Ctrl+C), then waits for DUTs being tested and prints a summary.
+     * Returns true if all the DUTs tested passed.
+     */
+    bool RunWatch(const char* pattern);
 };
 
 
@@ -29,13 +29,17 @@
 
 #include <devices/SensX.hpp>
 #include <serial/Plis.hpp>
+#include <serial/Crc16Ccitt.hpp>
 #include <iostream>
+#include <stdio.h>
+#include <atomic>
 #include "serial/Serial.hpp"
+#include "serialport/SerialReactor.hpp"
 
 
 using namespace alf64::devices;
 
-class SerialDeviceTester
+class SerialDeviceTester : public SerialReactor::Handler
 {
 public:
     /*
@@ -60,6 +64,68 @@ public:
     void SetResponseTimeoutMs(uint32_t timeoutMs);
     uint32_t GetResponseTimeoutMs(void);
 
+    /*
+     * Enables/disables session mode.
+     * In session mode the com port is opened once, on the first transaction,
+     * and is reused by all subsequent ones. It is reopened only after an error.
+     * Disabling session mode closes the com port.
+     */
+    void SetSessionMode(bool enable);
+    bool GetSessionMode(void);
+
+    /*
+     * Sets the pipeline window - the number of requests kept in flight by ProcessAgpRequests().
+     * Window of 1 means stop-and-wait (one request, its response, next request).
+     * Returns EC_FAIL if window is 0 or greater than pipelineWindowMax.
+     */
+    ec_t SetPipelineWindow(uint32_t window);
+    uint32_t GetPipelineWindow(void);
+
+    /*
+     * Cancels the tests: the exchange in progress is aborted
+     * and all the following ones fail right away, without touching the port.
+     * May be called from any thread (i.e. when the DUT got unplugged).
+     */
+    void Cancel(void);
+    bool IsCancelled(void);
+
+    /*
+     * Sets the stream all the test output (displayed fields, statistics) goes to.
+     * Default is stdout. NULL restores stdout.
+     */
+    void SetOutput(FILE* out);
+    FILE* GetOutput(void);
+
+    //!< Maximum pipeline window. Device has to be able to buffer this many requests.
+    static const uint32_t pipelineWindowMax = 32;
+
+    /*
+     * @brief Starts processing of all queued agp requests on given reactor.
+     *
+     * @details Opens com port, sends the first pipeline window of requests
+     * and registers the port in the reactor. Responses, next requests and timeouts
+     * are then handled on reactor's events (see PipelineComm()),
+     * so a single thread running the reactor can drive many testers at once.
+     * When done (or upon failure), the port is unregistered and com port is closed
+     * (unless session mode is enabled). On failure request queue is cleared.
+     *
+     * @param reactor Reactor to run the exchange on.
+     *
+     * @returns ec_t
+     * @retval EC_OK If exchange is started (or there were no requests).
+     * @retval EC_FAIL If failed to start (i.e. reactor not supported on this OS).
+     */
+    ec_t StartAgpRequests(SerialReactor* reactor);
+
+    //!< Returns true if exchange started by StartAgpRequests() is done.
+    bool IsAgpRequestsDone(void);
+
+    //!< Returns result of the last exchange started by StartAgpRequests().
+    ec_t GetAgpRequestsResult(void);
+
+    //!< SerialReactor::Handler, drives the exchange started by StartAgpRequests().
+    void OnPortEvent(int fd, uint32_t events) override;
+
     /*
      * Tests implemented PLIS functionality by calling:
      *  - PlisTestDecodeByte()
@@ -69,6 +135,14 @@ public:
      */
     bool TestSelfPlis(void);
 
+    /*
+     * Tests implemented CRC functionality by calling:
+     *  - Crc16Ccitt::TestCrc16()
+     * Returns true if test passes.
+     * Returns false if test fails.
+     */
+    bool TestSelfCrc(void);
+
     //!< Performs FwVersionRead functionality test.
     bool TestFwVersionRead(void);
 
@@ -87,6 +161,15 @@ public:
     //!< Performs functionality tests in a stressful manner.
     bool TestFuncStress(void);
 
+    /*
+     * Performs on-device request queue (Rsw) test:
+     * keeps the device queue full using credits (free space) and drains results as they are ready.
+     */
+    bool TestRswQueue(void);
+
+    //!< Displays Rsw client counters gathered by the last TestRswQueue().
+    void DispRswStats(void);
+
     //!< Performs negative test: agp unknown function send.
     bool TestNegUnknownFunc(void);
 
@@ -127,6 +210,21 @@ private:
         int32_t maxLocalDeltaVal;
     }measstb_t;
 
+    //!< State of pipelined exchange, see PipelineStart().
+    typedef struct
+    {
+        size_t inFlight; //!< requests sent and waiting for response
+        size_t respSize; //!< decoded bytes of the response being collected
+        uint32_t busyRetries;
+        uint32_t parsed; //!< responses parsed so far
+        Plis::Decoder decoder;
+        SerialReactor* reactor; //!< NULL if exchange is driven by PipelineComm() loop
+        int fd;
+        bool endComm; //!< call EndComm() when done
+        bool done;
+        ec_t result;
+    }pipeline_t;
+
     typedef enum
     {
         WRONGDATA_FUNC_RTC_SET = 0,
@@ -138,6 +236,10 @@ private:
     static const uint32_t _sensxStressTimeoutsMs = 60;
     static const uint32_t _sensxTestFuncStressFrames = 1000;
     static const uint8_t _sensxTestFuncStressVariants = 4;
+    static const uint32_t _sensxBusyRetriesMax = 100;
+    static const uint32_t _sensxTestRswRequests = 200;
+    static const uint32_t _sensxTestRswIdleItersMax = 1000;
+    static const size_t _rxStreamSize = 4096;
     static const uint8_t _sensxUnknownFunction = 0x80;
     static const uint8_t _sensxErrorRespLen = 1;
     static const uint16_t _sensxWrongCrc = 0xEDAA;
@@ -162,25 +264,112 @@ private:
 
     dut_t _dut;
 
-    //!< The time (in milliseconds) of waiting for agp response.
+    //!< Maximum time (in milliseconds) of waiting for complete agp response.
     uint32_t _responseTimeoutMs;
 
+    //!< If true, com port is kept opened between transactions.
+    bool _sessionEnable;
+
+    //!< Stream the test output goes to.
+    FILE* _out;
+
+    //!< Duration (in milliseconds) of the last TestRswQueue().
+    uint32_t _rswTestTimeMs;
+
+    //!< Number of requests kept in flight by ProcessAgpRequests().
+    uint32_t _pipelineWindow;
+
+    //!< Agp request frame, reused by ProcessAgpRequest().
+    ByteVector _txFrame;
+
+    //!< Agp response frame, reused by ProcessAgpRequest().
+    ByteVector _rxFrame;
+
+    //!< Raw (PLIS encoded) received data, may hold several response frames.
+    ByteVector _rxStream;
+
+    pipeline_t _pipeline;
+    SerialReactor _reactor; //!< drives PipelineComm(), port stays registered for the whole session
+    int _reactorFd; //!< port registered in _reactor, -1 if none
+    std::atomic<bool> _cancelled; //!< see Cancel()
+
     ec_t Init(void);
 
     bool ProcessAgpRequest(void);
 
+    /*
+     * @brief Processes all queued agp requests.
+     *
+     * @details With pipeline window greater than 1, keeps up to window requests
+     * in flight and matches responses in FIFO order (see PipelineComm()),
+     * otherwise calls ProcessAgpRequest() for each request.
+     *
+     * @returns true if all the requests got OK responses.
+     */
+    bool ProcessAgpRequests(void);
+
+    /*
+     * @brief Sends queued requests and collects their responses in pipelined manner.
+     *
+     * @details Keeps up to _pipelineWindow requests on the wire.
+     * Each response is passed to ParseResponse() as soon as its PLIS_END arrives,
+     * and the freed window slot is filled with the next queued request.
+     * Request that got Busy response is moved to the end of the queue and sent again.
+     * Where supported, the exchange runs on tester's own SerialReactor, so the thread sleeps
+     * between responses instead of polling the port. The port is registered in it once
+     * and stays there until closed, so consecutive exchanges of a session reuse it.
+     *
+     * @attention
+     * This function opens com port (if it is not opened yet) but does not close it.
+     * User is obligated to call EndComm() after returning from this function.
+     *
+     * @returns ec_t
+     * @retval EC_OK If all the requests got OK responses.
+     * @retval EC_FAIL If failed.
+     */
+    ec_t PipelineComm(void);
+
+    /*
+     * @brief Starts pipelined exchange.
+     * @details Opens com port (if it is not opened yet), resets pipeline state
+     * and fills the window. With reactor given, registers the port in it.
+     * @param reactor Reactor driving the exchange, or NULL.
+     * @param endComm If true, EndComm() is called when the exchange is done.
+     */
+    ec_t PipelineStart(SerialReactor* reactor, bool endComm);
+
+    //!< Sends queued requests until the pipeline window is full.
+    ec_t PipelineFill(void);
+
+    /*
+     * @brief Feeds received (PLIS encoded) data to the pipeline.
+     * @details Each complete response is parsed and its window slot is refilled.
+     * Marks the exchange done when the request queue gets empty.
+     */
+    ec_t PipelineFeed(const uint8_t* data, size_t size);
+
+    //!< Ends pipelined exchange: stops watching the port in the reactor and stores the result.
+    void PipelineFinish(ec_t ec);
+
+    //!< Unregisters the port from own reactor and closes it.
+    void ClosePort(void);
+
+    //!< Queues request number index of given TestFuncStress() variant.
+    bool QueueStressRequest(uint32_t variant, uint32_t index);
+
     /*
      * @brief Triggers communication over serial port.
      *
      * @details Sends request and gets response.
      * This function handles PLIS
      * (performs PLIS encode on request and decode on response).
+     * Response is collected until the frame is complete (PLIS_END received,
+     * or expRespSize bytes when PLIS decoding is disabled) and is returned right away,
+     * without waiting for the whole response timeout.
      *
      * @attention
-     * This function opens and closes com port.
-     * However if it returns with error the port is not being closed.
-     * User is obligated to check if com port is still opened after returning
-     * from this function and close it if needed.
+     * This function opens com port (if it is not opened yet) but does not close it.
+     * User is obligated to call EndComm() after returning from this function.
      *
      * @param request A reference to prepared AGP request to send.
      * @param response A reference to a place where response will be created by this function.
@@ -199,6 +388,16 @@ private:
             unsigned int expRespSize,
             plis_en_t plisEnable = PLIS_ENCODE_DECODE);
 
+    /*
+     * @brief Ends communication triggered by TriggerComm().
+     *
+     * @details Closes com port, unless session mode is enabled
+     * and the communication succeeded.
+     *
+     * @param ec A result of TriggerComm().
+     */
+    void EndComm(ec_t ec);
+
     //!< Displays info about Dut (its Info field)
     void DispDutInfo(void);
 
@@ -211,13 +410,14 @@ private:
      * @details
      * Displays integer data as data with 2 digit precision upon decimal point.
      *
+     * @param out Stream to display data on.
      * @param data Data to be displayed.
      * @param noneuline If true there will be no newline character put.
      *
      * @returns void
      * Function will not display anything if error condition occurs.
      */
-    static void DispPreciseData2Pts(int data, bool noneuline=true);
+    static void DispPreciseData2Pts(FILE* out, int data, bool noneuline=true);
 };
 
 
@@ -29,7 +29,6 @@
 
 #include <iostream>
 #include <vector>
-#include <list>
 
 #include "ec.h"
 
@@ -37,6 +36,10 @@
 #define DEVICE_STATUS_SIZE 1
 //!< Size (in bytes) of CRC field.
 #define DEVICE_CRC_SIZE 2
+//!< Maximum size (in bytes) of request function data (payload).
+#define DEVICE_REQ_PAYLOAD_SIZE 32
+//!< Default capacity (in requests) of the request queue.
+#define DEVICE_REQ_QUEUE_CAPACITY 256
 //!< Reverses order of bytes in u16 variable.
 #define REVERSE_U16_BYTE(u16) ((u16 >> 8) | (u16 << 8))
 //!< Reverses order of bytes in u32 variable.
@@ -63,7 +66,8 @@ public:
         InvalidArg,
         CrcError,
         NotInit,
-        DecodeError
+        DecodeError,
+        QueueFull //!< request queue is full, process some requests first (never sent by device)
     };
 
     enum DeviceStatus
@@ -109,34 +113,119 @@ public:
     Status ReadFwVersion(void);
     Status ReadDeviceStatus(void);
 
+    /*
+     * Returns next request as raw agp data (function, payload and crc, not PLIS encoded)
+     * and the expected response length.
+     * Meant for tests that need to alter the frame before sending it.
+     */
     int GetNextRequest(ByteVector &data);
+
+    /*
+     * Builds next request as a ready to send agp frame (PLIS encoded, PLIS_END terminated)
+     * and returns the expected response length.
+     * The frame vector is meant to be reused, it only grows when a bigger frame is built.
+     */
+    int GetNextRequestFrame(ByteVector &frame);
+
+    /*
+     * Same as GetNextRequestFrame(), but for the queued request at given position
+     * (0 - the oldest one). Meant for keeping several requests in flight.
+     * Returns -1 if there is no such request.
+     */
+    int GetRequestFrame(size_t index, ByteVector &frame);
+
+    //!< Returns expected response length of the queued request at given position, -1 if there is none.
+    int GetRequestResLength(size_t index);
+
+    /*
+     * Moves the oldest queued request to the end of the queue.
+     * Meant for retrying a request that got Busy response,
+     * when there are other requests in flight already.
+     */
+    Status RequeueRequest(void);
+
     Status ParseResponse(ByteVector &data);
     void ClearRequestQueue(void);
 
+    /*
+     * Sets the maximum number of queued requests.
+     * The queue storage is preallocated here, queuing a request does not allocate.
+     * Clears the request queue.
+     */
+    Status SetRequestQueueCapacity(size_t capacity);
+    size_t GetRequestQueueCapacity(void);
+
+    //!< Returns number of queued requests.
+    size_t GetRequestQueueSize(void);
+
     static uint16_t Crc16(const ByteVector &data);
 
+    //!< Returns maximum size (in bytes) of an agp frame built from a payload of given size.
+    static size_t RequestFrameMaxSize(size_t payloadSize);
+
+    /*
+     * @brief Builds agp frame in one pass.
+     *
+     * @details Writes the function byte, the payload and the crc, PLIS encoding
+     * them on the fly while the crc is being calculated, and terminates the frame with PLIS_END.
+     *
+     * @param function Agp function.
+     * @param payload Function data.
+     * @param payloadSize Size (in bytes) of function data.
+     * @param dst Output buffer, must be able to hold RequestFrameMaxSize(payloadSize) bytes.
+     *
+     * @returns Number of bytes written to dst.
+     */
+    static size_t BuildRequestFrame(
+            uint8_t function,
+            const uint8_t* payload,
+            size_t payloadSize,
+            uint8_t* dst);
+
 protected:
     bool initOk;
     typedef struct
     {
         int resLength;
-        ByteVector data;
+        uint8_t function;
+        uint8_t length; //!< size (in bytes) of data
+        uint8_t data[DEVICE_REQ_PAYLOAD_SIZE]; //!< function data (payload), without function byte and crc
     } Request;
     Info info;
 
-    std::list<Request> reqList;
+    /*
+     * Request queue - a ring of preallocated request slots.
+     * Requests are built in their slots and sent from there, they are never copied.
+     */
+    std::vector<Request> reqRing;
+    size_t reqHead; //!< index of the oldest request
+    size_t reqCount; //!< number of queued requests
 
     ec_t Init(void);
     Status AddQueueRequest(AgpMessage &msg);
     virtual int GetResLength(const uint8_t funct);
 
 private:
-    Status ValidateRequest(AgpMessage &msg);
+    Status ValidateRequest(const AgpMessage &msg);
+
+    //!< Returns the oldest queued request, or EmptyReqListMsg() if the queue is empty.
+    const Request* GetFrontRequest(void);
+
+    //!< Returns the queued request at given position (0 - the oldest one), NULL if there is none.
+    const Request* GetQueuedRequest(size_t index);
+
+    //!< Builds agp frame of given request into frame, returns its expected response length.
+    int BuildRequestFrame(const Request* req, ByteVector &frame);
 
     virtual Status ValidateSpecificRequest(const AgpMessage &msg) = 0;
     virtual Status ParseSpecificResponse(const uint8_t funct, const ByteVector &data) = 0;
     virtual int GetSpecificResLength(const uint8_t funct) = 0;
-    virtual int EmptyReqListMsg(ByteVector &data);
+    //!< Returns request to be sent when request queue is empty, NULL if there is none.
+    virtual const Request* EmptyReqListMsg(void);
+    //!< Called when given request leaves the queue, whatever its response was.
+    virtual void RequestDequeued(const Request &req);
+    //!< Called when the request queue is cleared, queued requests are dropped without a response.
+    virtual void RequestQueueCleared(void);
 
 };
 } // namespace devices
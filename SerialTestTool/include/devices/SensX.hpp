@@ -29,6 +29,7 @@
 
 #include <devices/General.hpp>
 #include <iostream>
+#include <deque>
 
 #include "ec.h"
 
@@ -116,6 +117,18 @@ public:
         uint32_t end;
     } __attribute__((packed));
 
+    //!< Counters of the Rsw (on-device request queue) client.
+    struct RswStats
+    {
+        uint32_t credits; //!< free slots reported by the last RswGetFreeSpace(), minus requests queued since
+        uint32_t submitted; //!< requests accepted by the device queue
+        uint32_t rejected; //!< requests refused by the device queue
+        uint32_t completed; //!< results read back
+        uint32_t notReady; //!< RswReadResult() responses with no result ready yet
+        uint32_t occupancy; //!< requests accepted but not read back yet
+        uint32_t peakOccupancy; //!< the highest occupancy seen
+    };
+
     SensX(void);
     ~SensX(void);
 
@@ -133,12 +146,45 @@ public:
 
     GeneralDevice::Status LogRead(LogRange &range);
 
+    /*
+     * Rsw - on-device request queue client.
+     *
+     * Requests (any SensX specific function that has a known response length, except Rsw ones)
+     * are submitted to the device queue with RswAddRequest() and executed by the device
+     * in the background. Their results are read back in submission order with RswReadResult().
+     * The client is flow-controlled with credits: RswGetFreeSpace() reads the number of free slots
+     * in the device queue and each RswAddRequest() consumes one of them, so the device queue
+     * can be kept full without ever being overflowed.
+     *
+     * Protocol assumptions (frames without the leading status byte and the trailing crc):
+     *  - RswGetQueueFreeSpace: request: - , response: free slots (1 byte).
+     *  - RswAddReq: request: function, function data. Response: - .
+     *    Busy status means the queue is full (treated as QueueFull, since credits should prevent it).
+     *  - RswReadRes: request: - , response: function, its response (status and data, no crc).
+     *    Busy status means no result is ready yet (counted in notReady, reported as OK).
+     *    Response length is variable, the expected length is its upper bound.
+     */
+    GeneralDevice::Status RswGetFreeSpace(void);
+    GeneralDevice::Status RswAddRequest(uint8_t function, const ByteVector &data);
+    //!< Submits MeasurementsRead() to the device queue.
+    GeneralDevice::Status RswAddMeasurementsRead(void);
+    GeneralDevice::Status RswReadResult(void);
+
+    //!< Clears the client state (pending requests, credits and counters).
+    void RswReset(void);
+    RswStats RswGetStats(void);
+
+    //!< Returns number of submitted requests whose results are not read back yet.
+    size_t RswGetPending(void);
+
 protected:
     GeneralDevice::Status ValidateSpecificRequest(const AgpMessage &msg) override;
     GeneralDevice::Status ParseSpecificResponse(
         const uint8_t funct, const ByteVector &data) override;
     int GetSpecificResLength(const uint8_t funct) override;
-    int EmptyReqListMsg(ByteVector &data) override;
+    const Request* EmptyReqListMsg(void) override;
+    void RequestDequeued(const Request &req) override;
+    void RequestQueueCleared(void) override;
 
 private:
     enum SensXCmd
@@ -175,6 +221,22 @@ private:
 
     Measurements measurements;
 
+    //!< Functions of queued RswAddReq requests, not answered yet.
+    std::deque<uint8_t> rswUnacked;
+    //!< Functions of requests accepted by the device queue, results not read back yet.
+    std::deque<uint8_t> rswPending;
+    RswStats rswStats;
+
+    //!< Returns true if function can be submitted to the device queue.
+    bool IsRswFunction(uint8_t funct);
+
+    /*
+     * Drops requests queued or submitted to the device queue and the credits, keeps the counters.
+     * Results of the dropped requests can not be matched anymore, so the credits
+     * must be refreshed with RswGetFreeSpace() before submitting again.
+     */
+    void RswDropInFlight(void);
+
     bool initOk;
     ec_t Init(void);
     static void PushU32ToByteVector(ByteVector &vector, uint32_t u32);
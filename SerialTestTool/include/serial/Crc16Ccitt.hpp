@@ -0,0 +1,114 @@
+/*
+***************************************************************************
+*
+* Author: alf64
+*
+* Copyright (C) 2019 alf64
+*
+* Email: alf64gordon@gmail.com
+*
+***************************************************************************
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* See <http://www.gnu.org/licenses/>.
+*
+***************************************************************************
+*/
+
+/*
+ * CRC-16/CCITT -
+ * polynomial 0x1021, initial value 0xFFFF, no reflection, no final xor.
+ * This is the CRC used by AGP frames.
+ *
+ * Final() returns the CRC with its bytes swapped, which is the form AGP expects
+ * (low byte of the returned value is sent first).
+ *
+ * Data can be processed at once (Compute()) or incrementally (Init(), Update(), Final()),
+ * i.e. while a frame is being encoded or decoded.
+ *
+ * Three engines are provided:
+ *  - table driven (one table lookup per byte), used for single bytes and short tails,
+ *  - slicing-by-8 (eight table lookups per 8 bytes), used for short and medium buffers,
+ *  - carry-less multiplication folding (PCLMULQDQ), used for long buffers
+ *    if the CPU supports it (checked at runtime).
+ */
+
+#ifndef SERIAL_CRC16CCITT_HPP_
+#define SERIAL_CRC16CCITT_HPP_
+
+#include <iostream>
+#include "ec.h"
+
+class Crc16Ccitt
+{
+public:
+    static const uint16_t initValue = 0xFFFF;
+    static const uint16_t polynomial = 0x1021;
+
+    Crc16Ccitt(void);
+    ~Crc16Ccitt(void);
+
+    //!< Starts new CRC calculation.
+    void Init(void);
+
+    //!< Updates CRC with given data.
+    void Update(const uint8_t* data, size_t size);
+
+    //!< Updates CRC with a single byte.
+    inline void Update(uint8_t byte)
+    {
+        crc = static_cast<uint16_t>((crc << 8) ^ tables.t[0][(crc >> 8) ^ byte]);
+    }
+
+    //!< Returns CRC of all the data passed to Update() since Init(), with bytes swapped.
+    uint16_t Final(void) const;
+
+    //!< Returns CRC of given data, with bytes swapped.
+    static uint16_t Compute(const uint8_t* data, size_t size);
+
+    /*
+     * Tests all CRC engines against bit by bit reference calculation.
+     * Returns true if test passes.
+     * Returns false if test fails.
+     */
+    static bool TestCrc16(void);
+
+private:
+    typedef uint16_t (*update_func_t)(uint16_t crc, const uint8_t* data, size_t size);
+
+    //!< Buffers shorter than this are not worth the folding setup.
+    static const size_t clmulMinSize = 64;
+
+    /*
+     * Lookup tables, generated at compile time.
+     * t[0] is the classic byte-wise table,
+     * t[k] is t[0] advanced by k zero bytes (used by slicing-by-8).
+     */
+    struct Tables
+    {
+        uint16_t t[8][256];
+        constexpr Tables(void);
+    };
+
+    static const Tables tables;
+
+    uint16_t crc;
+
+    static uint16_t UpdateBitwise(uint16_t crc, const uint8_t* data, size_t size);
+    static uint16_t UpdateTable(uint16_t crc, const uint8_t* data, size_t size);
+    static uint16_t UpdateSlicing8(uint16_t crc, const uint8_t* data, size_t size);
+    static uint16_t UpdateClmul(uint16_t crc, const uint8_t* data, size_t size);
+    static uint16_t UpdateBest(uint16_t crc, const uint8_t* data, size_t size);
+    static bool ClmulSupported(void);
+};
+
+#endif /* SERIAL_CRC16CCITT_HPP_ */
@@ -69,13 +69,95 @@ typedef std::vector<uint8_t> ByteVector;
 class Plis
 {
 public:
+    /*
+     * Streaming PLIS decoder.
+     *
+     * Encoded data can be fed in arbitrary chunks (i.e. exactly as they come from the serial port),
+     * the pending escape state is carried between them. Each chunk is decoded in one pass,
+     * either to a separate output buffer or in place (out == in).
+     * Decoding stops at each frame boundary (PLIS_END), so the caller can handle the frame
+     * and feed the rest of the chunk again.
+     */
+    class Decoder
+    {
+    public:
+        typedef enum
+        {
+            DECODER_STATUS_MORE_DATA, //!< whole input consumed, frame not complete yet
+            DECODER_STATUS_FRAME_END, //!< PLIS_END consumed, frame complete
+            DECODER_STATUS_ERROR, //!< invalid escape sequence consumed
+            DECODER_STATUS_OVERFLOW, //!< output buffer full, remaining input not consumed
+        } decoder_status_t;
+
+        Decoder(void);
+
+        //!< Drops pending escape state, so the next byte is treated as a start of data.
+        void Reset(void);
+
+        /*
+         * @brief Decodes a chunk of encoded data.
+         * @param in Encoded data.
+         * @param inSize Size (in bytes) of encoded data.
+         * @param out Output buffer for decoded data, may be equal to in (in place decoding).
+         * @param outSize Size (in bytes) of output buffer.
+         * @param consumed Number of bytes consumed from in (PLIS_END included).
+         * @param produced Number of decoded bytes written to out.
+         * @returns decoder_status_t
+         */
+        decoder_status_t Feed(
+                const uint8_t* in,
+                size_t inSize,
+                uint8_t* out,
+                size_t outSize,
+                size_t* consumed,
+                size_t* produced);
+
+    private:
+        bool escPending;
+    };
+
     Plis();
     ~Plis();
 
     static void encode(ByteVector &data);
+
+    /*
+     * @brief Encodes data into given output buffer.
+     * @details Encoded data is terminated with PLIS_END.
+     * Source and destination buffers must not overlap.
+     * @param src Data to encode.
+     * @param srcSize Size (in bytes) of data to encode.
+     * @param dst Output buffer, must be able to hold at least (2 * srcSize + 1) bytes.
+     * @param dstSize Size (in bytes) of output buffer.
+     * @returns Number of bytes written to dst, or error.
+     * @retval > 0 number of bytes written to dst.
+     * @retval -1 error (output buffer too small).
+     */
+    static int encode(const uint8_t* src, size_t srcSize, uint8_t* dst, size_t dstSize);
     static void decode(ByteVector &data);
     static int overhead(int buffLength);
 
+    /*
+     * @brief Writes a single byte to dst, escaped if it is reserved.
+     * @details Meant for building encoded frames on the fly, byte by byte.
+     * No PLIS_END is written.
+     * @param byte Byte to encode.
+     * @param dst Output buffer, must be able to hold at least 2 bytes.
+     * @returns Number of bytes written to dst (1 or 2).
+     */
+    static inline size_t encodeByte(uint8_t byte, uint8_t* dst)
+    {
+        if((byte == PLIS_END) || (byte == PLIS_ESC))
+        {
+            dst[0] = PLIS_ESC;
+            dst[1] = (byte == PLIS_END) ? PLIS_ESC_END : PLIS_ESC_ESC;
+            return 2;
+        }
+
+        dst[0] = byte;
+        return 1;
+    }
+
     /*
      * Tests Plis::decodeByte() functionality.
      * Returns true if test passes.
@@ -107,6 +189,21 @@ private:
     } plis_status_t;
 
     static plis_status_t decodeByte(uint8_t *byte, uint8_t lastByte);
+
+    /*
+     * Returns index of the first PLIS_END or PLIS_ESC byte in data,
+     * or size if there is no such byte.
+     */
+    static size_t findReserved(const uint8_t* data, size_t size);
+
+    //!< Returns number of PLIS_END and PLIS_ESC bytes in data.
+    static size_t countReserved(const uint8_t* data, size_t size);
+
+    /*
+     * Encodes srcSize bytes from src to dst, returns number of bytes written.
+     * dst may overlap src as long as dst + countReserved(src) + 1 <= src.
+     */
+    static size_t encodeRuns(const uint8_t* src, size_t srcSize, uint8_t* dst);
 };
 
 
@@ -28,9 +28,13 @@
 #define SERIAL_SERIAL_HPP_
 
 #include <iostream>
+#include <string>
+#include <vector>
 #include <string.h>
 
 #include "ec.h"
+#include "serialport/SerialPort.hpp"
+#include "serialport/SerialPortList.hpp"
 
 class Serial
 {
@@ -57,7 +61,22 @@ public:
     //!< Prints detected com ports.
     static void ListComPorts(void);
 
-    //!< Sets com port.
+    /*
+     * Appends names of detected com ports matching given pattern to ports.
+     * Pattern is matched against port name, device path, /dev/serial/by-id/ alias
+     * and USB "vid:pid" (see SerialPortList::Find()).
+     * Pattern may contain wildcards: '*' (any sequence of characters), '?' (any single character).
+     * Returns number of com ports appended.
+     */
+    static size_t FindComPorts(const char* pattern, std::vector<std::string>& ports);
+
+    //!< Returns true if pattern contains wildcards.
+    static inline bool IsPortPattern(const char* pattern)
+    {
+        return (pattern != NULL) && (strpbrk(pattern, "*?") != NULL);
+    }
+
+    //!< Sets com port (port name i.e. ttyUSB0, COM3, or device path).
     ec_t SetComPort(const char* portname);
 
     //!< Opens com port.
@@ -69,6 +88,13 @@ public:
     //!< Returns true if com port is opened, otherwise returns false.
     bool isComPortOpened(void);
 
+    /*
+     * Returns file descriptor of the opened com port,
+     * to be watched for events (i.e. by SerialReactor).
+     * Returns -1 if com port is not opened or the OS does not provide one (Windows).
+     */
+    int GetFd(void);
+
     /*
      * Dumps buffer to serial port.
      * Returns number of bytes written.
@@ -110,6 +136,20 @@ public:
      */
     int ReadDataFromPort(unsigned char* buff, unsigned int max);
 
+    /*
+     * @brief Waits for data from port and reads it.
+     * @details Returns as soon as any data is available,
+     * it does not wait for max bytes to be collected.
+     * @param buff - Pointer where the read data will be written.
+     * @param max - Maximum bytes to read.
+     * @param timeoutMs - Maximum time (in milliseconds) to wait for data.
+     * @returns Number of data bytes obtained, or error.
+     * @retval > 0 number of data bytes obtained.
+     * @retval 0 timeout expired with no data received.
+     * @retval < 0 error
+     */
+    int ReadDataFromPort(unsigned char* buff, unsigned int max, uint32_t timeoutMs);
+
     //< Example1 of how to use Serial functionality provided by this class.
     ec_t TestSerial1(void);
 
@@ -120,29 +160,20 @@ private:
     bool initOk;
 
     static const int rcvBuffSize = 4096;
-    static constexpr const char* defaultComPortName = "COM1";
+    static const uint32_t testRxTimeoutMs = 5000;
     static constexpr const char* defaultBaudRate = "115200";
     static constexpr const char* defaultDataMode = "8n1";
-    static const int maxSysComPorts = 32;
-    static constexpr const char* portnames_h[maxSysComPorts] =
-    {
-        "COM1",  "COM2",  "COM3",  "COM4",
-        "COM5",  "COM6",  "COM7",  "COM8",
-        "COM9",  "COM10", "COM11", "COM12",
-        "COM13", "COM14", "COM15", "COM16",
-        "COM17", "COM18", "COM19", "COM20",
-        "COM21", "COM22", "COM23", "COM24",
-        "COM25", "COM26", "COM27", "COM28",
-        "COM29", "COM30", "COM31", "COM32"
-    };
-
-    bool _isComPortOpened;
+#if defined(__linux__) || defined(__FreeBSD__)
+    static constexpr const char* defaultComPortName = "ttyUSB0";
+#else
+    static constexpr const char* defaultComPortName = "COM1";
+#endif
+
     const char* portComName;
-    int portComNum;
     const char* baudRate_str;
     int baudRate_val;
     const char* dataMode;
-    unsigned char rcvBuff[rcvBuffSize] = {0};
+    SerialPort port;
 
     ec_t Init(void);
 
@@ -152,11 +183,8 @@ private:
      */
     static int GetBaudRateFromName(const char* baudrate_str);
 
-    /*
-     * Returns com port representation in an integer form.
-     * Returns -1 if error occurred.
-     */
-    static int GetComPortNumFromName(const char* portname);
+    //!< Returns true if port with given name can be opened.
+    static bool IsPortUsable(const char* portname);
 };
 
 
@@ -24,10 +24,39 @@
 ***************************************************************************
 */
 
+#include <stdlib.h>
 #include <string.h>
 
+#include <signal.h>
+
+#include <atomic>
+#include <thread>
+#include <chrono>
+#include <deque>
+#include <list>
+
 #include "App.hpp"
+#include "serialport/SerialHotplug.hpp"
 using namespace std;
+using namespace std::chrono;
+
+//!< Watch mode state, shared with the signal handler.
+static SerialHotplug* watchHotplug = NULL;
+static volatile sig_atomic_t watchStopRequested = 0;
+
+static void WatchSignalHandler(int sig)
+{
+    UNUSED(sig);
+    watchStopRequested = 1;
+    if(watchHotplug != NULL)
+    {
+        watchHotplug->Interrupt();
+    }
+
+    // the next Ctrl+C terminates the app right away
+    signal(SIGINT, SIG_DFL);
+    signal(SIGTERM, SIG_DFL);
+}
 
 App::App(void):
         initOk(false)
@@ -60,6 +89,9 @@ ec_t App::Init(void)
         ec = EC_FAIL;
     }
     stressTestsEnable = false;
+    pipelineWindow = 1;
+    jobs = 0;
+    ports.clear();
 
     return ec;
 }
@@ -94,6 +126,24 @@ ec_t App::ParseArgs(int argc, const char** argv)
                 opt.option_arg = *(current_opt + 1);
                 args.push_back(opt);
             }
+            else if(strcmp(*current_opt, opts_abbr.at(APP_OPTION_PIPELINE_WINDOW)) == 0)
+            {
+                opt.option_type = static_cast<app_option_type_t>(APP_OPTION_PIPELINE_WINDOW);
+                opt.option_arg = *(current_opt + 1);
+                args.push_back(opt);
+            }
+            else if(strcmp(*current_opt, opts_abbr.at(APP_OPTION_JOBS)) == 0)
+            {
+                opt.option_type = static_cast<app_option_type_t>(APP_OPTION_JOBS);
+                opt.option_arg = *(current_opt + 1);
+                args.push_back(opt);
+            }
+            else if(strcmp(*current_opt, opts_abbr.at(APP_OPTION_WATCH)) == 0)
+            {
+                opt.option_type = static_cast<app_option_type_t>(APP_OPTION_WATCH);
+                opt.option_arg = *(current_opt + 1);
+                args.push_back(opt);
+            }
             current_opt += 2;
         }
     }
@@ -111,7 +161,8 @@ ec_t App::ParseArgs(int argc, const char** argv)
                 highest_value = neu_highest_value;
             }
         }
-        options.resize(static_cast<size_t>(highest_value+1));
+        // options that were not given are left with NULL option_arg
+        options.resize(static_cast<size_t>(highest_value+1), {APP_OPTION_RESERVED, NULL});
 
         // app_option_t
         for(uint8_t i = 0; i < static_cast<uint8_t>(args.size()); i++)
@@ -154,7 +205,29 @@ void App::DispHelp(void)
             GetDut());
     printf("%s -p <portname> -s 1 \n\t"
             "Enables additional stress tests execution if all standard AGP tests pass.\n\t"
-            "Stress test execution takes few minutes, that's why it's optional.\n\n", appName);
+            "Stress test execution takes few minutes, that's why it's optional.\n", appName);
+    printf("%s -p <portname> -w <window>\n\t"
+            "Keeps up to window (1 - %u) requests in flight during stress tests,\n\t"
+            "responses are matched in the order of requests. Default window is 1 (stop-and-wait).\n\t"
+            "DUT has to be able to buffer that many requests.\n\n",
+            appName,
+            SerialDeviceTester::pipelineWindowMax);
+    printf("%s -p <port1,port2,...> [-j <jobs>]\n%s -p <pattern> [-j <jobs>]\n\t"
+            "Runs the tests on several DUTs at once, each one through its own port.\n\t"
+            "Pattern may contain wildcards: '*' (any characters), '?' (any single character),\n\t"
+            "i.e. COM* selects all the detected COM ports, 0403:* all the FTDI ones.\n\t"
+            "It is matched against port name, device path, /dev/serial/by-id/ alias and USB vid:pid.\n\t"
+            "Up to jobs (1 - %u) DUTs are tested concurrently, default is all of them.\n\t"
+            "Output of each DUT is printed when its tests end, followed by a summary.\n\n",
+            appName,
+            appName,
+            maxJobs);
+    printf("%s -wt <pattern> [-j <jobs>]\n\t"
+            "Watch mode: runs the tests on each DUT as soon as its port is plugged in,\n\t"
+            "DUTs in parallel (up to jobs at once). Ctrl+C stops watching.\n\t"
+            "Pattern is a port pattern (i.e. ttyUSB*, 0403:*) or a device path pattern\n\t"
+            "(i.e. /dev/serial/by-id/*, /tmp/ttyV*, no wildcards in the directory part).\n\n",
+            appName);
 }
 
 ec_t App::Process(int argc, const char** argv)
@@ -165,12 +238,99 @@ ec_t App::Process(int argc, const char** argv)
     ec = ParseArgs(argc, argv);
     RETURN_EC_ON_ERROR(ec);
 
+    const char* watchArg = NULL;
+
     switch(options.size())
     {
         case 1:
         case 2:
+        case 3:
+        case 4:
+        case 5:
         {
-            const char* portname = options.at(APP_OPTION_PORT_SELECTION).option_arg;
+            const char* portArg = options.at(APP_OPTION_PORT_SELECTION).option_arg;
+            if(options.size() > APP_OPTION_WATCH)
+            {
+                watchArg = options.at(APP_OPTION_WATCH).option_arg;
+            }
+            if((portArg == NULL) && (watchArg == NULL))
+            {
+                DispHelp();
+                ec = EC_BUSY;
+                break;
+            }
+
+            if((options.size() > APP_OPTION_ENABLE_STRESS) &&
+               (options.at(APP_OPTION_ENABLE_STRESS).option_arg != NULL))
+            {
+                const char* stressArg = options.at(APP_OPTION_ENABLE_STRESS).option_arg;
+                if(strcmp(stressArg, "1") == 0)
+                {
+                    stressTestsEnable = true;
+                    printf("stress tests enabled\n");
+                }
+                else
+                {
+                    printf("stress tests opt given but arg invalid, ignoring\n");
+                }
+            }
+
+            if((options.size() > APP_OPTION_PIPELINE_WINDOW) &&
+               (options.at(APP_OPTION_PIPELINE_WINDOW).option_arg != NULL))
+            {
+                const char* windowArg = options.at(APP_OPTION_PIPELINE_WINDOW).option_arg;
+                char* windowEnd = NULL;
+                unsigned long window = strtoul(windowArg, &windowEnd, 10);
+                if((*windowEnd == '\0') &&
+                   (m_tester->SetPipelineWindow(static_cast<uint32_t>(window)) == EC_OK))
+                {
+                    pipelineWindow = static_cast<uint32_t>(window);
+                    printf("pipeline window set to: %lu\n", window);
+                }
+                else
+                {
+                    printf("pipeline window opt given but arg invalid, ignoring\n");
+                }
+            }
+
+            if((options.size() > APP_OPTION_JOBS) &&
+               (options.at(APP_OPTION_JOBS).option_arg != NULL))
+            {
+                const char* jobsArg = options.at(APP_OPTION_JOBS).option_arg;
+                char* jobsEnd = NULL;
+                unsigned long jobsVal = strtoul(jobsArg, &jobsEnd, 10);
+                if((*jobsEnd == '\0') && (jobsVal > 0) && (jobsVal <= maxJobs))
+                {
+                    jobs = static_cast<uint32_t>(jobsVal);
+                    printf("concurrent DUTs limited to: %lu\n", jobsVal);
+                }
+                else
+                {
+                    printf("jobs opt given but arg invalid, ignoring\n");
+                }
+            }
+
+            if(watchArg != NULL)
+            {
+                break;
+            }
+
+            ec = SelectPorts(portArg);
+            if(ec == EC_FAIL)
+            {
+                printf("No serial port found for: %s\n"
+                        "(make sure you typed portname with upper case)\n",
+                        portArg);
+                break;
+            }
+
+            if(ports.size() > 1)
+            {
+                printf("DUTs to test: %u\n", static_cast<unsigned int>(ports.size()));
+                break;
+            }
+
+            const char* portname = ports.at(0).c_str();
             ec = m_tester->m_serial->SetComPort(portname);
             if(ec == EC_FAIL)
             {
@@ -196,20 +356,6 @@ ec_t App::Process(int argc, const char** argv)
                 break;
             }
 
-            if(options.size() == 2)
-            {
-                const char* stressArg = options.at(APP_OPTION_ENABLE_STRESS).option_arg;
-                if(strcmp(stressArg, "1") == 0)
-                {
-                    stressTestsEnable = true;
-                    printf("stress tests enabled\n");
-                }
-                else
-                {
-                    printf("stress tests opt given but arg invalid, ignoring\n");
-                }
-            }
-
             break;
         }
 
@@ -227,11 +373,325 @@ ec_t App::Process(int argc, const char** argv)
     if(ec == EC_BUSY){return EC_OK;} // help was displayed, quit
     RETURN_VAL_ON_FAIL(ec == EC_OK, EC_FAIL); // error condition occurred
 
-    RETURN_VAL_ON_FAIL(RunTests(), EC_FAIL);
+    if(watchArg != NULL)
+    {
+        RETURN_VAL_ON_FAIL(RunWatch(watchArg), EC_FAIL);
+        return ec;
+    }
+
+    if(ports.size() > 1)
+    {
+        RETURN_VAL_ON_FAIL(RunParallel(), EC_FAIL);
+        return ec;
+    }
+
+    // keep the port opened for the whole test run
+    m_tester->SetSessionMode(true);
+    bool testsResult = RunTests(m_tester, stdout);
+    m_tester->SetSessionMode(false);
+    RETURN_VAL_ON_FAIL(testsResult, EC_FAIL);
 
     return ec;
 }
 
+ec_t App::SelectPorts(const char* portArg)
+{
+    RETURN_VAL_ON_FAIL(portArg != NULL, EC_FAIL);
+
+    ports.clear();
+
+    // comma separated list of portnames and/or portname patterns
+    std::string list(portArg);
+    size_t begin = 0;
+    while(begin <= list.size())
+    {
+        size_t end = list.find(',', begin);
+        if(end == std::string::npos)
+        {
+            end = list.size();
+        }
+
+        std::string entry = list.substr(begin, end - begin);
+        if(Serial::IsPortPattern(entry.c_str()))
+        {
+            Serial::FindComPorts(entry.c_str(), ports);
+        }
+        else if(!entry.empty())
+        {
+            ports.push_back(entry);
+        }
+
+        begin = end + 1;
+    }
+
+    RETURN_VAL_ON_FAIL(ports.size() > 0, EC_FAIL);
+
+    return EC_OK;
+}
+
+bool App::RunParallel(void)
+{
+    std::vector<dut_result_t> results(ports.size());
+    for(size_t i = 0; i < ports.size(); i++)
+    {
+        results.at(i).port = ports.at(i);
+        results.at(i).passed = false;
+        results.at(i).unplugged = false;
+        results.at(i).wallTimeMs = 0;
+    }
+
+    size_t workers = ports.size();
+    if((jobs > 0) && (jobs < workers))
+    {
+        workers = jobs;
+    }
+
+    // each worker takes the next untested DUT until there are none left
+    std::atomic<size_t> next(0);
+    const steady_clock::time_point start = steady_clock::now();
+    std::vector<std::thread> threads;
+    for(size_t w = 0; w < workers; w++)
+    {
+        threads.emplace_back([this, &results, &next]()
+        {
+            size_t i;
+            while((i = next++) < results.size())
+            {
+                SerialDeviceTester tester;
+                RunDut(results.at(i), tester);
+            }
+        });
+    }
+    for(size_t w = 0; w < threads.size(); w++)
+    {
+        threads.at(w).join();
+    }
+    uint32_t totalMs = static_cast<uint32_t>(
+            duration_cast<milliseconds>(steady_clock::now() - start).count());
+
+    PrintSummary(results, totalMs);
+
+    for(size_t i = 0; i < results.size(); i++)
+    {
+        RETURN_VAL_ON_FAIL(results.at(i).passed, false);
+    }
+
+    return true;
+}
+
+void App::PrintSummary(const std::vector<dut_result_t>& results, uint32_t totalMs)
+{
+    uint32_t passed = 0;
+    uint64_t sumMs = 0;
+    printf("################ Multi-DUT summary ####################\n");
+    for(size_t i = 0; i < results.size(); i++)
+    {
+        const dut_result_t& result = results.at(i);
+        printf("DUT %s:\t\t\t\t\t%s (%.1f s)\n",
+                result.port.c_str(),
+                result.passed ? "PASSED" : (result.unplugged ? "UNPLUGGED!" : "FAILED!"),
+                static_cast<float>(result.wallTimeMs) / 1000);
+        passed += result.passed ? 1 : 0;
+        sumMs += result.wallTimeMs;
+    }
+    printf("DUTs passed:\t\t\t\t\t%u / %u\n", passed, static_cast<unsigned int>(results.size()));
+    printf("Wall time (sum of DUT times):\t\t\t%.1f s (%.1f s)\n",
+            static_cast<float>(totalMs) / 1000,
+            static_cast<float>(sumMs) / 1000);
+    printf("#######################################################\n");
+}
+
+void App::RunDut(dut_result_t& result, SerialDeviceTester& tester)
+{
+    const steady_clock::time_point start = steady_clock::now();
+
+    // output is collected per DUT and printed at once, so outputs of DUTs do not interleave
+    FILE* log = tmpfile();
+    FILE* out = (log != NULL) ? log : stdout;
+
+    tester.SetOutput(out);
+
+    bool passed = false;
+    if((tester.SetDut(SerialDeviceTester::DUT_SENSX) == EC_OK) &&
+       (tester.m_serial->SetComPort(result.port.c_str()) == EC_OK) &&
+       (tester.m_serial->TestComPort() == EC_OK))
+    {
+        tester.SetPipelineWindow(pipelineWindow);
+        tester.SetSessionMode(true);
+        passed = RunTests(&tester, out);
+        tester.SetSessionMode(false);
+    }
+    else
+    {
+        fprintf(out, "Unable to open serial port: %s.\n", result.port.c_str());
+    }
+
+    result.passed = passed;
+    result.wallTimeMs = static_cast<uint32_t>(
+            duration_cast<milliseconds>(steady_clock::now() - start).count());
+
+    std::lock_guard<std::mutex> lock(outputMutex);
+    printf("==================== DUT %s ====================\n", result.port.c_str());
+    if(log != NULL)
+    {
+        char buff[512];
+        size_t n;
+        rewind(log);
+        while((n = fread(buff, 1, sizeof(buff), log)) > 0)
+        {
+            fwrite(buff, 1, n, stdout);
+        }
+        fclose(log);
+    }
+    printf("DUT %s:\t\t\t\t\t%s (%.1f s)\n",
+            result.port.c_str(),
+            passed ? "PASSED" : "FAILED!",
+            static_cast<float>(result.wallTimeMs) / 1000);
+    fflush(stdout);
+}
+
+bool App::RunWatch(const char* pattern)
+{
+    RETURN_VAL_ON_FAIL(pattern != NULL, false);
+
+    SerialHotplug hotplug;
+    if(!SerialHotplug::IsSupported() || (hotplug.Start(pattern) != EC_OK))
+    {
+        printf("Unable to watch for serial ports matching: %s\n", pattern);
+        return false;
+    }
+    printf("Watching (%s) for serial ports matching: %s\n"
+            "DUTs are tested as soon as they are plugged in. Press Ctrl+C to stop.\n",
+            hotplug.GetSource(),
+            pattern);
+    fflush(stdout);
+
+    typedef struct
+    {
+        dut_result_t result;
+        SerialDeviceTester tester; //!< cancelled when the DUT gets unplugged
+        std::thread thread;
+        std::atomic<bool> done;
+    }watch_dut_t;
+
+    std::list<watch_dut_t> running; // list, so results stay in place for their threads
+    std::deque<std::string> waiting; // plugged in, waiting for a free job
+    std::vector<dut_result_t> results;
+    bool watchOk = true;
+
+    watchStopRequested = 0;
+    watchHotplug = &hotplug;
+    signal(SIGINT, WatchSignalHandler);
+    signal(SIGTERM, WatchSignalHandler);
+
+    const steady_clock::time_point start = steady_clock::now();
+    while(!watchStopRequested)
+    {
+        std::vector<SerialHotplug::event_t> events;
+        if(hotplug.Wait(events, watchPollMs) != EC_OK)
+        {
+            printf("Error! Watching for serial ports failed.\n");
+            watchOk = false;
+            break;
+        }
+
+        for(size_t i = 0; i < events.size(); i++)
+        {
+            const SerialHotplug::event_t& event = events.at(i);
+            std::lock_guard<std::mutex> lock(outputMutex);
+            if(event.change == SerialHotplug::PORT_ADDED)
+            {
+                printf("DUT %s plugged in.\n", event.port.c_str());
+                waiting.push_back(event.port);
+            }
+            else
+            {
+                printf("DUT %s unplugged.\n", event.port.c_str());
+                for(std::deque<std::string>::iterator it = waiting.begin(); it != waiting.end(); )
+                {
+                    it = (*it == event.port) ? waiting.erase(it) : (it + 1);
+                }
+                for(std::list<watch_dut_t>::iterator it = running.begin(); it != running.end(); it++)
+                {
+                    if((it->result.port == event.port) && !it->done)
+                    {
+                        it->result.unplugged = true;
+                        it->tester.Cancel();
+                    }
+                }
+            }
+            fflush(stdout);
+        }
+
+        // collect finished DUTs
+        for(std::list<watch_dut_t>::iterator it = running.begin(); it != running.end(); )
+        {
+            if(it->done)
+            {
+                it->thread.join();
+                results.push_back(it->result);
+                it = running.erase(it);
+            }
+            else
+            {
+                it++;
+            }
+        }
+
+        // start plugged in DUTs, up to jobs at once
+        while(!waiting.empty() && ((jobs == 0) || (running.size() < jobs)))
+        {
+            running.emplace_back();
+            watch_dut_t& dut = running.back();
+            dut.result.port = waiting.front();
+            dut.result.passed = false;
+            dut.result.unplugged = false;
+            dut.result.wallTimeMs = 0;
+            dut.done = false;
+            waiting.pop_front();
+            dut.thread = std::thread([this, &dut]()
+            {
+                std::this_thread::sleep_for(milliseconds(watchSettleMs));
+                RunDut(dut.result, dut.tester);
+                dut.done = true;
+            });
+        }
+    }
+
+    signal(SIGINT, SIG_DFL);
+    signal(SIGTERM, SIG_DFL);
+    watchHotplug = NULL;
+    hotplug.Stop();
+
+    if(!running.empty())
+    {
+        std::lock_guard<std::mutex> lock(outputMutex);
+        printf("Waiting for %u DUT(s) being tested...\n", static_cast<unsigned int>(running.size()));
+        fflush(stdout);
+    }
+    for(std::list<watch_dut_t>::iterator it = running.begin(); it != running.end(); it++)
+    {
+        it->thread.join();
+        results.push_back(it->result);
+    }
+    uint32_t totalMs = static_cast<uint32_t>(
+            duration_cast<milliseconds>(steady_clock::now() - start).count());
+
+    if(results.empty())
+    {
+        printf("No DUTs tested.\n");
+        return watchOk;
+    }
+    PrintSummary(results, totalMs);
+
+    for(size_t i = 0; i < results.size(); i++)
+    {
+        RETURN_VAL_ON_FAIL(results.at(i).passed, false);
+    }
+
+    return watchOk;
+}
+
 const char* App::GetAppName(void)
 {
     return appName;
@@ -242,170 +702,198 @@ const char* App::GetDut(void)
     return dut;
 }
 
-bool App::RunTests(void)
+bool App::RunTests(SerialDeviceTester* tester, FILE* out)
 {
+    RETURN_VAL_ON_FAIL(tester != NULL, false);
+    RETURN_VAL_ON_FAIL(out != NULL, false);
+
     bool funcResult = true;
     bool negResult = true;
     bool stressResult = true;
 
     // ---------- Functionality tests ----------
-    printf("TestSelfPlis()...\t\t\t\t");
-    bool testResult = m_tester->TestSelfPlis();
+    fprintf(out, "TestSelfPlis()...\t\t\t\t");
+    bool testResult = tester->TestSelfPlis();
     if(testResult)
     {
-        printf("SUCCESS\n");
+        fprintf(out, "SUCCESS\n");
     }
     else
     {
-        printf("FAILED!\n");
+        fprintf(out, "FAILED!\n");
         funcResult = false;
     }
 
-    printf("TestFwVersionRead()...\t\t\t\t");
-    testResult = m_tester->TestFwVersionRead();
+    fprintf(out, "TestSelfCrc()...\t\t\t\t");
+    testResult = tester->TestSelfCrc();
     if(testResult)
     {
-        printf("SUCCESS\n");
+        fprintf(out, "SUCCESS\n");
     }
     else
     {
-        printf("FAILED!\n");
+        fprintf(out, "FAILED!\n");
         funcResult = false;
     }
 
-    printf("TestDeviceStatusRead()...\t\t\t");
-    testResult = m_tester->TestDeviceStatusRead();
+    fprintf(out, "TestFwVersionRead()...\t\t\t\t");
+    testResult = tester->TestFwVersionRead();
     if(testResult)
     {
-        printf("SUCCESS\n");
+        fprintf(out, "SUCCESS\n");
     }
     else
     {
-        printf("FAILED!\n");
+        fprintf(out, "FAILED!\n");
         funcResult = false;
     }
 
-    printf("TestMeasurementRead()...\t\t\t");
-    testResult = m_tester->TestMeasurementRead();
+    fprintf(out, "TestDeviceStatusRead()...\t\t\t");
+    testResult = tester->TestDeviceStatusRead();
     if(testResult)
     {
-        printf("SUCCESS\n");
+        fprintf(out, "SUCCESS\n");
     }
     else
     {
-        printf("FAILED!\n");
+        fprintf(out, "FAILED!\n");
         funcResult = false;
     }
 
-    printf("TestRtcSet()...\t\t\t\t\t");
-    testResult = m_tester->TestRtcSet();
+    fprintf(out, "TestMeasurementRead()...\t\t\t");
+    testResult = tester->TestMeasurementRead();
     if(testResult)
     {
-        printf("SUCCESS\n");
+        fprintf(out, "SUCCESS\n");
     }
     else
     {
-        printf("FAILED!\n");
+        fprintf(out, "FAILED!\n");
         funcResult = false;
     }
 
-    printf("TestHostWakeUpTimeSet()...\t\t\t");
-    testResult = m_tester->TestHostWakeUpTimeSet();
+    fprintf(out, "TestRtcSet()...\t\t\t\t\t");
+    testResult = tester->TestRtcSet();
     if(testResult)
     {
-        printf("SUCCESS\n");
+        fprintf(out, "SUCCESS\n");
     }
     else
     {
-        printf("FAILED!\n");
+        fprintf(out, "FAILED!\n");
+        funcResult = false;
+    }
+
+    fprintf(out, "TestHostWakeUpTimeSet()...\t\t\t");
+    testResult = tester->TestHostWakeUpTimeSet();
+    if(testResult)
+    {
+        fprintf(out, "SUCCESS\n");
+    }
+    else
+    {
+        fprintf(out, "FAILED!\n");
         funcResult = false;
     }
 
     RETURN_VAL_ON_FAIL(funcResult, false);
-    m_tester->DispDutFields();
+    tester->DispDutFields();
     // ------- END OF: Functionality tests -------
 
     // ---------- Negative tests ----------
-    printf("TestFuncUnknownFunc()...\t\t\t");
-    testResult = m_tester->TestNegUnknownFunc();
+    fprintf(out, "TestFuncUnknownFunc()...\t\t\t");
+    testResult = tester->TestNegUnknownFunc();
     if(testResult)
     {
-        printf("SUCCESS\n");
+        fprintf(out, "SUCCESS\n");
     }
     else
     {
-        printf("FAILED!\n");
+        fprintf(out, "FAILED!\n");
         negResult = false;
     }
 
-    printf("TestNegWrongCrc()...\t\t\t\t");
-    testResult = m_tester->TestNegWrongCrc();
+    fprintf(out, "TestNegWrongCrc()...\t\t\t\t");
+    testResult = tester->TestNegWrongCrc();
     if(testResult)
     {
-        printf("SUCCESS\n");
+        fprintf(out, "SUCCESS\n");
     }
     else
     {
-        printf("FAILED!\n");
+        fprintf(out, "FAILED!\n");
         negResult = false;
     }
 
-    printf("TestNegWrongPlis()...\t\t\t\t");
-    testResult = m_tester->TestNegWrongPlis();
+    fprintf(out, "TestNegWrongPlis()...\t\t\t\t");
+    testResult = tester->TestNegWrongPlis();
     if(testResult)
     {
-        printf("SUCCESS\n");
+        fprintf(out, "SUCCESS\n");
     }
     else
     {
-        printf("FAILED!\n");
+        fprintf(out, "FAILED!\n");
         negResult = false;
     }
 
-    printf("TestNegWrongDataSize()...\t\t\t");
-    testResult = m_tester->TestNegWrongDataSize();
+    fprintf(out, "TestNegWrongDataSize()...\t\t\t");
+    testResult = tester->TestNegWrongDataSize();
     if(testResult)
     {
-        printf("SUCCESS\n");
+        fprintf(out, "SUCCESS\n");
     }
     else
     {
-        printf("FAILED!\n");
+        fprintf(out, "FAILED!\n");
         negResult = false;
     }
 
-    printf("TestNegIntFrame()...\t\t\t\t");
-    testResult = m_tester->TestNegIntFrame();
+    fprintf(out, "TestNegIntFrame()...\t\t\t\t");
+    testResult = tester->TestNegIntFrame();
     if(testResult)
     {
-        printf("SUCCESS\n");
+        fprintf(out, "SUCCESS\n");
     }
     else
     {
-        printf("FAILED!\n");
+        fprintf(out, "FAILED!\n");
         negResult = false;
     }
     RETURN_VAL_ON_FAIL(negResult, false);
     // ------- END OF: Negative tests -------
 
-    printf("TestMeasStability()...\t\t\t\tSTART\n");
-    m_tester->TestMeasStability();
-    printf("TestMeasStability()...\t\t\t\tEND\n");
+    fprintf(out, "TestMeasStability()...\t\t\t\tSTART\n");
+    tester->TestMeasStability();
+    fprintf(out, "TestMeasStability()...\t\t\t\tEND\n");
 
     // ---------- Stress tests ----------
     if(stressTestsEnable)
     {
-        printf("TestFuncStress()...\t\t\t\t");
-        testResult = m_tester->TestFuncStress();
+        fprintf(out, "TestFuncStress()...\t\t\t\t");
+        testResult = tester->TestFuncStress();
+        if(testResult)
+        {
+            fprintf(out, "SUCCESS\n");
+        }
+        else
+        {
+            fprintf(out, "FAILED!\n");
+            stressResult = false;
+        }
+
+        fprintf(out, "TestRswQueue()...\t\t\t\t");
+        testResult = tester->TestRswQueue();
         if(testResult)
         {
-            printf("SUCCESS\n");
+            fprintf(out, "SUCCESS\n");
         }
         else
         {
-            printf("FAILED!\n");
+            fprintf(out, "FAILED!\n");
             stressResult = false;
         }
+        tester->DispRswStats();
     }
     RETURN_VAL_ON_FAIL(stressResult, false);
     // ------- END OF: Stress tests -------
@@ -26,13 +26,13 @@
 
 #include <stdlib.h>
 #include <stdio.h>
-#ifdef _WIN32
-#include <windows.h>
-#endif
+#include <string.h>
+#include <chrono>
 
 #include "SerialDeviceTester.hpp"
 
 using namespace std;
+using namespace std::chrono;
 
 constexpr const uint8_t SerialDeviceTester::_sensxWrongPlisAgpFrame1[];
 constexpr const uint8_t SerialDeviceTester::_sensxWrongPlisAgpFrame2[];
@@ -64,6 +64,16 @@ ec_t SerialDeviceTester::Init(void)
     m_sensx = new alf64::devices::SensX();
     _dut = DUT_SENSX;
     _responseTimeoutMs = _sensxTimeoutMs;
+    _sessionEnable = false;
+    _pipelineWindow = 1;
+    _rswTestTimeMs = 0;
+    _out = stdout;
+    _pipeline.reactor = NULL;
+    _pipeline.fd = -1;
+    _pipeline.done = true;
+    _pipeline.result = EC_OK;
+    _reactorFd = -1;
+    _cancelled = false;
 
     return EC_OK;
 }
@@ -79,6 +89,15 @@ bool SerialDeviceTester::TestSelfPlis(void)
     return true;
 }
 
+bool SerialDeviceTester::TestSelfCrc(void)
+{
+    RETURN_VAL_ON_FAIL(_initOk, false);
+
+    RETURN_VAL_ON_FAIL((Crc16Ccitt::TestCrc16()), false);
+
+    return true;
+}
+
 ec_t SerialDeviceTester::SetDut(dut_t dut)
 {
     RETURN_VAL_ON_FAIL(_initOk, EC_FAIL);
@@ -119,6 +138,58 @@ uint32_t SerialDeviceTester::GetResponseTimeoutMs(void)
     return _responseTimeoutMs;
 }
 
+void SerialDeviceTester::SetSessionMode(bool enable)
+{
+    RETURN_VOID_ON_FAIL(_initOk);
+
+    _sessionEnable = enable;
+    if(!_sessionEnable && m_serial->isComPortOpened())
+    {
+        ClosePort();
+    }
+}
+
+bool SerialDeviceTester::GetSessionMode(void)
+{
+    return _sessionEnable;
+}
+
+void SerialDeviceTester::SetOutput(FILE* out)
+{
+    _out = (out != NULL) ? out : stdout;
+}
+
+FILE* SerialDeviceTester::GetOutput(void)
+{
+    return _out;
+}
+
+ec_t SerialDeviceTester::SetPipelineWindow(uint32_t window)
+{
+    RETURN_VAL_ON_FAIL(((window > 0) && (window <= pipelineWindowMax)), EC_FAIL);
+
+    _pipelineWindow = window;
+
+    return EC_OK;
+}
+
+uint32_t SerialDeviceTester::GetPipelineWindow(void)
+{
+    return _pipelineWindow;
+}
+
+void SerialDeviceTester::Cancel(void)
+{
+    _cancelled = true;
+    // wakes PipelineComm() up, if it is waiting for a response
+    _reactor.Stop();
+}
+
+bool SerialDeviceTester::IsCancelled(void)
+{
+    return _cancelled;
+}
+
 bool SerialDeviceTester::TestFwVersionRead(void)
 {
     RETURN_VAL_ON_FAIL(_initOk, false);
@@ -219,7 +290,6 @@ bool SerialDeviceTester::TestFuncStress(void)
     bool retval = true;
     m_sensx->ClearRequestQueue();
 
-    GeneralDevice::Status status = GeneralDevice::HwFault;
     uint32_t framesPerVariant = _sensxTestFuncStressFrames / _sensxTestFuncStressVariants;
     uint32_t framesLastVariant =
             framesPerVariant + (_sensxTestFuncStressFrames % _sensxTestFuncStressVariants);
@@ -233,114 +303,171 @@ bool SerialDeviceTester::TestFuncStress(void)
     SetResponseTimeoutMs(_sensxStressTimeoutsMs);
 
     uint32_t framesCnt = 0;
-    for(uint32_t variant = 1, loopBr = 0, frameLimit = 0;
-            (variant <= _sensxTestFuncStressVariants) && (loopBr == 0);
-            variant++)
+    const uint32_t queueCapacity = static_cast<uint32_t>(m_sensx->GetRequestQueueCapacity());
+    for(uint32_t variant = 1; variant <= _sensxTestFuncStressVariants; variant++)
     {
-        switch(variant)
+        uint32_t frameLimit = framesCnt +
+                ((variant < _sensxTestFuncStressVariants) ? framesPerVariant : framesLastVariant);
+        while(framesCnt < frameLimit)
         {
-            case 1:
+            // queue as many requests as the queue holds, then process them (pipelined if enabled)
+            uint32_t chunk = frameLimit - framesCnt;
+            if(chunk > queueCapacity)
             {
-                frameLimit += framesPerVariant;
-                while(framesCnt < frameLimit)
-                {
-                    status = m_sensx->ReadFwVersion();
-                    BREAK_ON_FAIL(status == GeneralDevice::OK);
-                    BREAK_ON_FAIL(ProcessAgpRequest());
-                    framesCnt++;
-                }
-                if(framesCnt != frameLimit)
-                {
-                    loopBr = 1;
-                }
-
-                break;
+                chunk = queueCapacity;
             }
-            case 2:
-            {
-                frameLimit += framesPerVariant;
-                while(framesCnt < frameLimit)
-                {
-                    status = m_sensx->ReadDeviceStatus();
-                    BREAK_ON_FAIL(status == GeneralDevice::OK);
-                    BREAK_ON_FAIL(ProcessAgpRequest());
-                    framesCnt++;
-                }
-                if(framesCnt != frameLimit)
-                {
-                    loopBr = 1;
-                }
 
-                break;
-            }
-            case 3:
+            uint32_t queued = 0;
+            while((queued < chunk) && QueueStressRequest(variant, queued))
             {
-                frameLimit += framesPerVariant;
-                while(framesCnt < frameLimit)
-                {
-                    status = m_sensx->MeasurementsRead();
-                    BREAK_ON_FAIL(status == GeneralDevice::OK);
-                    BREAK_ON_FAIL(ProcessAgpRequest());
-                    framesCnt++;
-                }
-                if(framesCnt != frameLimit)
-                {
-                    loopBr = 1;
-                }
-
-                break;
+                queued++;
             }
-            case 4:
-            {
-                uint32_t queueCnt = framesLastVariant;
-                while(queueCnt)
-                {
-                    GeneralDevice::Status status = m_sensx->ReadFwVersion();
-                    BREAK_ON_FAIL(status == GeneralDevice::OK);
-                    BREAK_ON_FAIL((--queueCnt));
-                    status = m_sensx->ReadDeviceStatus();
-                    BREAK_ON_FAIL(status == GeneralDevice::OK);
-                    BREAK_ON_FAIL((--queueCnt));
-                    status = m_sensx->MeasurementsRead();
-                    BREAK_ON_FAIL(status == GeneralDevice::OK);
-                    queueCnt--;
-                }
-                if(queueCnt > 0)
-                {
-                    loopBr = 1;
-                    break;
-                }
+            BREAK_ON_FAIL(queued == chunk);
+            BREAK_ON_FAIL(ProcessAgpRequests());
+            framesCnt += chunk;
+        }
+        BREAK_ON_FAIL(framesCnt == frameLimit);
+    }
+    if(framesCnt != totalFrames)
+    {
+        fprintf(_out, "Processed frames: %d / %d \n", framesCnt, totalFrames);
+        retval = false;
+    }
 
-                frameLimit += framesLastVariant;
-                while(framesCnt < frameLimit)
-                {
-                    BREAK_ON_FAIL(ProcessAgpRequest());
-                    framesCnt++;
-                }
-                if(framesCnt != frameLimit)
-                {
-                    loopBr = 1;
-                }
+    m_sensx->ClearRequestQueue();
+    SetResponseTimeoutMs(timeout);
+
+    return retval;
+}
 
+bool SerialDeviceTester::TestRswQueue(void)
+{
+    RETURN_VAL_ON_FAIL(_initOk, false);
+    RETURN_VAL_ON_FAIL(_dut == DUT_SENSX, false);
+
+    m_sensx->ClearRequestQueue();
+    m_sensx->RswReset();
+
+    uint32_t timeout = GetResponseTimeoutMs();
+    SetResponseTimeoutMs(_sensxStressTimeoutsMs);
+
+    const size_t queueCapacity = m_sensx->GetRequestQueueCapacity();
+    const steady_clock::time_point start = steady_clock::now();
+    uint32_t queued = 0;
+    uint32_t idleIters = 0;
+    ec_t ec = EC_OK;
+
+    /*
+     * Each round trip refreshes the credits, submits as many requests as they allow
+     * and reads back as many results as there are pending.
+     * Results that are not ready yet are simply read again in the next round trip.
+     * Round trips go through PipelineComm(), because RswReadRes response length is variable.
+     */
+    SensX::RswStats stats = m_sensx->RswGetStats();
+    while(stats.completed < _sensxTestRswRequests)
+    {
+        if(m_sensx->RswGetFreeSpace() != GeneralDevice::OK)
+        {
+            ec = EC_FAIL;
+            break;
+        }
+        ec = PipelineComm();
+        BREAK_ON_FAIL(ec == EC_OK);
+
+        stats = m_sensx->RswGetStats();
+        uint32_t completedBefore = stats.completed;
+        uint32_t credits = stats.credits;
+        while((credits > 0) && (queued < _sensxTestRswRequests) &&
+              (m_sensx->GetRequestQueueSize() < queueCapacity))
+        {
+            if(m_sensx->RswAddMeasurementsRead() != GeneralDevice::OK)
+            {
+                ec = EC_FAIL;
                 break;
             }
-            default:
+            queued++;
+            credits--;
+        }
+        for(size_t i = m_sensx->RswGetPending();
+            (ec == EC_OK) && (i > 0) && (m_sensx->GetRequestQueueSize() < queueCapacity);
+            i--)
+        {
+            if(m_sensx->RswReadResult() != GeneralDevice::OK)
             {
-                loopBr = 1;
-
-                break;
+                ec = EC_FAIL;
             }
         }
+        BREAK_ON_FAIL(ec == EC_OK);
+        ec = PipelineComm();
+        BREAK_ON_FAIL(ec == EC_OK);
+
+        stats = m_sensx->RswGetStats();
+        BREAK_ON_FAIL(stats.rejected == 0);
+        idleIters = (stats.completed == completedBefore) ? (idleIters + 1) : 0;
+        BREAK_ON_FAIL(idleIters < _sensxTestRswIdleItersMax);
     }
-    if(framesCnt != totalFrames)
+    EndComm(ec);
+
+    _rswTestTimeMs = static_cast<uint32_t>(
+            duration_cast<milliseconds>(steady_clock::now() - start).count());
+    m_sensx->ClearRequestQueue();
+    SetResponseTimeoutMs(timeout);
+
+    return ((ec == EC_OK) && (stats.completed == _sensxTestRswRequests) && (stats.rejected == 0));
+}
+
+void SerialDeviceTester::DispRswStats(void)
+{
+    RETURN_VOID_ON_FAIL(_initOk);
+    RETURN_VOID_ON_FAIL(_dut == DUT_SENSX);
+
+    SensX::RswStats stats = m_sensx->RswGetStats();
+    float seconds = static_cast<float>(_rswTestTimeMs) / 1000;
+
+    fprintf(_out, "Rsw requests submitted / rejected:\t\t%u / %u\n", stats.submitted, stats.rejected);
+    fprintf(_out, "Rsw results read / not ready yet:\t\t%u / %u\n", stats.completed, stats.notReady);
+    fprintf(_out, "Rsw queue peak occupancy:\t\t\t%u\n", stats.peakOccupancy);
+    if(_rswTestTimeMs > 0)
     {
-        printf("Processed frames: %d / %d \n", framesCnt, totalFrames);
-        retval = false;
+        fprintf(_out, "Rsw throughput:\t\t\t\t\t%.1f results/s\n",
+                static_cast<float>(stats.completed) / seconds);
     }
+}
 
-    SetResponseTimeoutMs(timeout);
+bool SerialDeviceTester::QueueStressRequest(uint32_t variant, uint32_t index)
+{
+    // each variant repeats a single function, except the last one, which interleaves all of them
+    uint32_t function = variant;
+    if(variant == _sensxTestFuncStressVariants)
+    {
+        function = (index % (_sensxTestFuncStressVariants - 1)) + 1;
+    }
 
-    return retval;
+    GeneralDevice::Status status = GeneralDevice::HwFault;
+    switch(function)
+    {
+        case 1:
+        {
+            status = m_sensx->ReadFwVersion();
+            break;
+        }
+        case 2:
+        {
+            status = m_sensx->ReadDeviceStatus();
+            break;
+        }
+        case 3:
+        {
+            status = m_sensx->MeasurementsRead();
+            break;
+        }
+        default:
+        {
+            break;
+        }
+    }
+
+    return (status == GeneralDevice::OK);
 }
 
 bool SerialDeviceTester::TestNegUnknownFunc(void)
@@ -371,10 +498,7 @@ bool SerialDeviceTester::TestNegUnknownFunc(void)
     agpRequest.push_back(static_cast<uint8_t>(((crc >> 8) & 0xFF)));
 
     ec_t ec = TriggerComm(agpRequest, agpResponse, static_cast<unsigned int>(expRespSize));
-    if(m_serial->isComPortOpened())
-    {
-        m_serial->CloseComPort();
-    }
+    EndComm(ec);
     RETURN_VAL_ON_FAIL(ec == EC_OK, false);
 
     /*
@@ -416,10 +540,7 @@ bool SerialDeviceTester::TestNegWrongCrc(void)
             static_cast<uint8_t>(_sensxWrongCrc & 0xFF);
 
     ec_t ec = TriggerComm(agpRequest, agpResponse, static_cast<unsigned int>(expRespSize));
-    if(m_serial->isComPortOpened())
-    {
-        m_serial->CloseComPort();
-    }
+    EndComm(ec);
     RETURN_VAL_ON_FAIL(ec == EC_OK, false);
 
     status = m_sensx->ParseResponse(agpResponse);
@@ -477,10 +598,7 @@ bool SerialDeviceTester::TestNegWrongPlis(void)
         }
 
         ec_t ec = TriggerComm(agpRequest, agpResponse, expRespSize, PLIS_DECODE);
-        if(m_serial->isComPortOpened())
-        {
-            m_serial->CloseComPort();
-        }
+        EndComm(ec);
         RETURN_VAL_ON_FAIL(ec == EC_OK, false);
 
         GeneralDevice::Status status = static_cast<GeneralDevice::Status>(agpResponse.at(0));
@@ -538,10 +656,7 @@ bool SerialDeviceTester::TestNegWrongDataSize(void)
         agpRequest.push_back(static_cast<uint8_t>(((crc >> 8) & 0xFF)));
 
         ec_t ec = TriggerComm(agpRequest, agpResponse, static_cast<unsigned int>(expRespSize));
-        if(m_serial->isComPortOpened())
-        {
-            m_serial->CloseComPort();
-        }
+        EndComm(ec);
         RETURN_VAL_ON_FAIL(ec == EC_OK, false);
 
         //Additional manual check of the status
@@ -653,10 +768,7 @@ bool SerialDeviceTester::TestNegIntFrame(void)
 
         expRespSize = _sensxErrorRespLen + DEVICE_CRC_SIZE;
         ec_t ec = TriggerComm(agpRequest, agpResponse, static_cast<unsigned int>(expRespSize));
-        if(m_serial->isComPortOpened())
-        {
-            m_serial->CloseComPort();
-        }
+        EndComm(ec);
         RETURN_VAL_ON_FAIL(ec == EC_OK, false);
 
         switch(variant)
@@ -668,7 +780,7 @@ bool SerialDeviceTester::TestNegIntFrame(void)
                 /*
                  * Manual status check, since these agp frames were not created
                  * via m_sensx methods, which means they do not exists in the
-                 * m_sensx->reqList and ParseResponse() would fail.
+                 * m_sensx request queue and ParseResponse() would fail.
                  */
                 status = static_cast<GeneralDevice::Status>(agpResponse.at(0));
                 RETURN_VAL_ON_FAIL(status == GeneralDevice::WrongCmdLength, false);
@@ -693,15 +805,15 @@ void SerialDeviceTester::TestMeasStability(void)
     RETURN_VOID_ON_FAIL(_initOk);
     RETURN_VOID_ON_FAIL(_dut == DUT_SENSX);
 
-    printf("##### Displaying measurement stability statistics #####\n");
+    fprintf(_out, "##### Displaying measurement stability statistics #####\n");
 
     uint32_t timeout = GetResponseTimeoutMs();
     SetResponseTimeoutMs(_sensxStressTimeoutsMs);
 
     const uint16_t channels = sizeof(SensX::Measurements) / sizeof(SensX::Measurement);
-    printf("Detected RTD temperature channels:\t\t%d\n", channels);
-    printf("Number of measurements readings to perform:\t%d\n", _sensxTestMeasStabilityIters);
-    printf("Please wait, performing measurement stability test...\n");
+    fprintf(_out, "Detected RTD temperature channels:\t\t%d\n", channels);
+    fprintf(_out, "Number of measurements readings to perform:\t%d\n", _sensxTestMeasStabilityIters);
+    fprintf(_out, "Please wait, performing measurement stability test...\n");
 
     TestMeasurementRead();
     SensX::Measurements measures = m_sensx->MeasurementsGet();
@@ -763,26 +875,26 @@ void SerialDeviceTester::TestMeasStability(void)
 
     for(uint16_t i = 0; i < channels; i++)
     {
-        printf("RTD[%d] temperature value changed:\t\t%d / %d\n",
+        fprintf(_out, "RTD[%d] temperature value changed:\t\t%d / %d\n",
                 i+1, stbStats.at(i).changeCnt, _sensxTestMeasStabilityIters);
 
         float stbRatio =
                  1.00f -
                  (static_cast<float>(stbStats.at(i).changeCnt) / _sensxTestMeasStabilityIters);
 
-        printf("RTD[%d] stability ratio:\t\t\t\t%.2f%%\n", i+1, stbRatio * 100);
+        fprintf(_out, "RTD[%d] stability ratio:\t\t\t\t%.2f%%\n", i+1, stbRatio * 100);
 
-        printf("RTD[%d] max temperature local deviation:\t\t%.2f%cC\n",
+        fprintf(_out, "RTD[%d] max temperature local deviation:\t\t%.2f%cC\n",
                 i+1,
                 static_cast<float>(stbStats.at(i).maxLocalDeltaVal) / 100,
                 eAsciiDegree);
-        printf("RTD[%d] temperature deviation range:\t\t%.2f%cC\n",
+        fprintf(_out, "RTD[%d] temperature deviation range:\t\t%.2f%cC\n",
                 i+1,
                 static_cast<float>(stbStats.at(i).maxVal - stbStats.at(i).minVal) / 100,
                 eAsciiDegree);
     }
 
-    printf("#######################################################\n");
+    fprintf(_out, "#######################################################\n");
 
     SetResponseTimeoutMs(timeout);
 }
@@ -792,28 +904,350 @@ bool SerialDeviceTester::ProcessAgpRequest(void)
     RETURN_VAL_ON_FAIL(_initOk, false);
     RETURN_VAL_ON_FAIL(_dut == DUT_SENSX, false); // only sensx supported at the moment
 
-    ByteVector agpRequest;
-    ByteVector agpResponse;
-    agpRequest.clear();
-    agpResponse.clear();
-
-    int expRespSize = m_sensx->GetNextRequest(agpRequest);
+    // frame is built PLIS encoded already, into buffers reused from frame to frame
+    _rxFrame.clear();
+    int expRespSize = m_sensx->GetNextRequestFrame(_txFrame);
     RETURN_VAL_ON_FAIL(expRespSize > 0, false);
-    RETURN_VAL_ON_FAIL(agpRequest.size() > 0, false);
+    RETURN_VAL_ON_FAIL(_txFrame.size() > 0, false);
 
-    ec_t ec = TriggerComm(agpRequest, agpResponse, static_cast<unsigned int>(expRespSize));
-    if(m_serial->isComPortOpened())
-    {
-        m_serial->CloseComPort();
-    }
+    ec_t ec = TriggerComm(_txFrame, _rxFrame, static_cast<unsigned int>(expRespSize), PLIS_DECODE);
+    EndComm(ec);
     RETURN_VAL_ON_FAIL(ec == EC_OK, false);
 
-    GeneralDevice::Status status = m_sensx->ParseResponse(agpResponse);
+    GeneralDevice::Status status = m_sensx->ParseResponse(_rxFrame);
     RETURN_VAL_ON_FAIL(status == GeneralDevice::OK, false);
 
     return true;
 }
 
+bool SerialDeviceTester::ProcessAgpRequests(void)
+{
+    RETURN_VAL_ON_FAIL(_initOk, false);
+    RETURN_VAL_ON_FAIL(_dut == DUT_SENSX, false); // only sensx supported at the moment
+
+    if(_pipelineWindow <= 1)
+    {
+        while(m_sensx->GetRequestQueueSize() > 0)
+        {
+            RETURN_VAL_ON_FAIL(ProcessAgpRequest(), false);
+        }
+
+        return true;
+    }
+
+    ec_t ec = PipelineComm();
+    EndComm(ec);
+    if(ec != EC_OK)
+    {
+        // responses of requests still in flight are lost along with the port
+        m_sensx->ClearRequestQueue();
+    }
+
+    return (ec == EC_OK);
+}
+
+ec_t SerialDeviceTester::PipelineComm(void)
+{
+    RETURN_VAL_ON_FAIL(_initOk, EC_FAIL);
+
+    ec_t ec = EC_OK;
+    if(SerialReactor::IsSupported())
+    {
+        // Stop() of the previous exchange is forgotten before the cancel check in PipelineStart(),
+        // so Cancel() either fails PipelineStart() or stops Run()
+        _reactor.ResetStop();
+        ec = PipelineStart(&_reactor, false);
+        if((ec == EC_OK) && !_pipeline.done)
+        {
+            ec = _reactor.Run();
+        }
+        if((ec == EC_OK) && !_pipeline.done)
+        {
+            // stopped by Cancel()
+            ec = EC_FAIL;
+        }
+        if(ec != EC_OK)
+        {
+            PipelineFinish(ec);
+        }
+
+        return _pipeline.result;
+    }
+
+    ec = PipelineStart(NULL, false);
+    RETURN_EC_ON_ERROR(ec);
+
+    steady_clock::time_point deadline =
+            steady_clock::now() + milliseconds(_responseTimeoutMs);
+    while(!_pipeline.done)
+    {
+        RETURN_VAL_ON_FAIL(!_cancelled, EC_FAIL);
+        steady_clock::time_point now = steady_clock::now();
+        RETURN_VAL_ON_FAIL(now < deadline, EC_FAIL);
+        milliseconds remaining = duration_cast<milliseconds>(deadline - now) + milliseconds(1);
+
+        int n = m_serial->ReadDataFromPort(
+                _rxStream.data(),
+                static_cast<unsigned int>(_rxStream.size()),
+                static_cast<uint32_t>(remaining.count()));
+        RETURN_VAL_ON_FAIL(n >= 0, EC_FAIL);
+
+        uint32_t parsed = _pipeline.parsed;
+        ec = PipelineFeed(_rxStream.data(), static_cast<size_t>(n));
+        RETURN_EC_ON_ERROR(ec);
+        if(_pipeline.parsed != parsed)
+        {
+            // each response gets its own timeout
+            deadline = steady_clock::now() + milliseconds(_responseTimeoutMs);
+        }
+    }
+
+    return EC_OK;
+}
+
+ec_t SerialDeviceTester::StartAgpRequests(SerialReactor* reactor)
+{
+    RETURN_VAL_ON_FAIL(_initOk, EC_FAIL);
+    RETURN_VAL_ON_FAIL(_dut == DUT_SENSX, EC_FAIL); // only sensx supported at the moment
+    RETURN_VAL_ON_FAIL(reactor != NULL, EC_FAIL);
+
+    ec_t ec = PipelineStart(reactor, true);
+    if(ec != EC_OK)
+    {
+        PipelineFinish(ec);
+    }
+
+    return ec;
+}
+
+bool SerialDeviceTester::IsAgpRequestsDone(void)
+{
+    return _pipeline.done;
+}
+
+ec_t SerialDeviceTester::GetAgpRequestsResult(void)
+{
+    return _pipeline.result;
+}
+
+void SerialDeviceTester::OnPortEvent(int fd, uint32_t events)
+{
+    RETURN_VOID_ON_FAIL((fd == _pipeline.fd) && !_pipeline.done);
+
+    ec_t ec = EC_FAIL;
+    if(events & (SerialReactor::EVENT_ERROR | SerialReactor::EVENT_TIMEOUT))
+    {
+        PipelineFinish(ec);
+        return;
+    }
+
+    // port is non-blocking, so this returns whatever is there
+    int n = m_serial->ReadDataFromPort(
+            _rxStream.data(),
+            static_cast<unsigned int>(_rxStream.size()));
+    if(n >= 0)
+    {
+        uint32_t parsed = _pipeline.parsed;
+        ec = PipelineFeed(_rxStream.data(), static_cast<size_t>(n));
+        if((ec == EC_OK) && !_pipeline.done && (_pipeline.parsed != parsed))
+        {
+            ec = _pipeline.reactor->SetTimeout(fd, _responseTimeoutMs);
+        }
+    }
+
+    if((ec != EC_OK) || _pipeline.done)
+    {
+        PipelineFinish(ec);
+    }
+}
+
+ec_t SerialDeviceTester::PipelineStart(SerialReactor* reactor, bool endComm)
+{
+    RETURN_VAL_ON_FAIL(_initOk, EC_FAIL);
+    RETURN_VAL_ON_FAIL(!_cancelled, EC_FAIL);
+
+    /*
+     * Requests in flight are always the oldest ones in the queue,
+     * so the response being collected always belongs to the first one (FIFO order).
+     * Received bytes may hold several response frames,
+     * they are split at PLIS_END by the decoder.
+     */
+    _rxStream.resize(_rxStreamSize);
+    _pipeline.inFlight = 0;
+    _pipeline.respSize = 0;
+    _pipeline.busyRetries = 0;
+    _pipeline.parsed = 0;
+    _pipeline.decoder.Reset();
+    _pipeline.reactor = NULL;
+    _pipeline.fd = -1;
+    _pipeline.endComm = endComm;
+    _pipeline.done = false;
+    _pipeline.result = EC_OK;
+
+    ec_t ec = EC_OK;
+    if(!m_serial->isComPortOpened())
+    {
+        ec = m_serial->OpenComPort();
+        RETURN_EC_ON_ERROR(ec);
+        ec = m_serial->FlushRX();
+        RETURN_EC_ON_ERROR(ec);
+    }
+
+    ec = PipelineFill();
+    RETURN_EC_ON_ERROR(ec);
+    if(_pipeline.done || (reactor == NULL))
+    {
+        return EC_OK;
+    }
+
+    int fd = m_serial->GetFd();
+    RETURN_VAL_ON_FAIL(fd >= 0, EC_FAIL);
+    if(reactor != &_reactor)
+    {
+        ec = reactor->Add(fd, this, SerialReactor::EVENT_READABLE);
+        RETURN_EC_ON_ERROR(ec);
+    }
+    else
+    {
+        ec = EC_FAIL;
+        if(_reactorFd == fd)
+        {
+            ec = reactor->Modify(fd, SerialReactor::EVENT_READABLE);
+        }
+        if(ec != EC_OK)
+        {
+            // port was reopened elsewhere, its old registration is stale
+            if(_reactorFd != -1)
+            {
+                reactor->Remove(_reactorFd);
+                _reactorFd = -1;
+            }
+            ec = reactor->Add(fd, this, SerialReactor::EVENT_READABLE);
+            RETURN_EC_ON_ERROR(ec);
+            _reactorFd = fd;
+        }
+    }
+    _pipeline.reactor = reactor;
+    _pipeline.fd = fd;
+
+    return reactor->SetTimeout(fd, _responseTimeoutMs);
+}
+
+ec_t SerialDeviceTester::PipelineFill(void)
+{
+    if(m_sensx->GetRequestQueueSize() == 0)
+    {
+        _pipeline.done = true;
+        return EC_OK;
+    }
+
+    // keep the window full
+    while((_pipeline.inFlight < _pipelineWindow) &&
+          (_pipeline.inFlight < m_sensx->GetRequestQueueSize()))
+    {
+        int expRespSize = m_sensx->GetRequestFrame(_pipeline.inFlight, _txFrame);
+        RETURN_VAL_ON_FAIL(expRespSize > 0, EC_FAIL);
+        int bts_sent =
+                m_serial->DumpBuffToPort(_txFrame.data(), static_cast<unsigned int>(_txFrame.size()));
+        RETURN_VAL_ON_FAIL(
+                static_cast<unsigned int>(bts_sent) == static_cast<unsigned int>(_txFrame.size()),
+                EC_FAIL);
+        _pipeline.inFlight++;
+    }
+
+    if(_pipeline.respSize == 0)
+    {
+        int expRespSize = m_sensx->GetRequestResLength(0);
+        RETURN_VAL_ON_FAIL(expRespSize > 0, EC_FAIL);
+        _rxFrame.resize(static_cast<size_t>(expRespSize));
+    }
+
+    return EC_OK;
+}
+
+ec_t SerialDeviceTester::PipelineFeed(const uint8_t* data, size_t size)
+{
+    RETURN_VAL_ON_FAIL(!_pipeline.done, EC_FAIL); // response without request
+
+    size_t rxStart = 0;
+    while(rxStart < size)
+    {
+        size_t consumed = 0;
+        size_t produced = 0;
+        Plis::Decoder::decoder_status_t status = _pipeline.decoder.Feed(
+                data + rxStart, size - rxStart,
+                _rxFrame.data() + _pipeline.respSize, _rxFrame.size() - _pipeline.respSize,
+                &consumed, &produced);
+        RETURN_VAL_ON_FAIL(
+                (status == Plis::Decoder::DECODER_STATUS_MORE_DATA) ||
+                (status == Plis::Decoder::DECODER_STATUS_FRAME_END),
+                EC_FAIL);
+        rxStart += consumed;
+        _pipeline.respSize += produced;
+        if(status != Plis::Decoder::DECODER_STATUS_FRAME_END)
+        {
+            continue;
+        }
+
+        _rxFrame.resize(_pipeline.respSize);
+        _pipeline.respSize = 0;
+        _pipeline.parsed++;
+
+        GeneralDevice::Status devStatus = m_sensx->ParseResponse(_rxFrame);
+        _pipeline.inFlight--;
+        if(devStatus == GeneralDevice::Busy)
+        {
+            // requests behind it are on the wire already, so retry it after them
+            RETURN_VAL_ON_FAIL(++_pipeline.busyRetries <= _sensxBusyRetriesMax, EC_FAIL);
+            m_sensx->RequeueRequest();
+        }
+        else
+        {
+            RETURN_VAL_ON_FAIL(devStatus == GeneralDevice::OK, EC_FAIL);
+        }
+
+        ec_t ec = PipelineFill();
+        RETURN_EC_ON_ERROR(ec);
+        // anything after the last response is dropped
+        BREAK_ON_FAIL(!_pipeline.done);
+    }
+
+    return EC_OK;
+}
+
+void SerialDeviceTester::PipelineFinish(ec_t ec)
+{
+    if(_pipeline.reactor == &_reactor)
+    {
+        // port stays registered for the next exchange of the session, just stop watching it
+        _reactor.SetTimeout(_pipeline.fd, 0);
+        if(_reactor.Modify(_pipeline.fd, 0) != EC_OK)
+        {
+            _reactor.Remove(_pipeline.fd);
+            _reactorFd = -1;
+        }
+        _reactor.Stop();
+    }
+    else if(_pipeline.reactor != NULL)
+    {
+        _pipeline.reactor->Remove(_pipeline.fd);
+    }
+    _pipeline.reactor = NULL;
+    _pipeline.fd = -1;
+    _pipeline.done = true;
+    _pipeline.result = ec;
+
+    if(_pipeline.endComm)
+    {
+        EndComm(ec);
+        if(ec != EC_OK)
+        {
+            // responses of requests still in flight are lost along with the port
+            m_sensx->ClearRequestQueue();
+        }
+    }
+}
+
 ec_t SerialDeviceTester::TriggerComm(
         ByteVector& request,
         ByteVector& response,
@@ -822,14 +1256,19 @@ ec_t SerialDeviceTester::TriggerComm(
 {
     RETURN_VAL_ON_FAIL(_initOk, EC_FAIL);
     RETURN_VAL_ON_FAIL(((request.size() > 0) && (response.size() == 0)), EC_FAIL);
+    RETURN_VAL_ON_FAIL(!_cancelled, EC_FAIL);
 
     bool plisEncode = static_cast<bool>(plisEnable & PLIS_ENCODE);
     bool plisDecode = static_cast<bool>(plisEnable & PLIS_DECODE);
 
-    ec_t ec = m_serial->OpenComPort();
-    RETURN_EC_ON_ERROR(ec);
-    ec = m_serial->FlushRX();
-    RETURN_EC_ON_ERROR(ec);
+    ec_t ec = EC_OK;
+    if(!m_serial->isComPortOpened())
+    {
+        ec = m_serial->OpenComPort();
+        RETURN_EC_ON_ERROR(ec);
+        ec = m_serial->FlushRX();
+        RETURN_EC_ON_ERROR(ec);
+    }
 
     if(plisEncode)
     {
@@ -849,42 +1288,96 @@ ec_t SerialDeviceTester::TriggerComm(
     }
     response.assign(static_cast<size_t>(maxRespSize), 0);
 
-    Sleep(_responseTimeoutMs);
+    /*
+     * Collect the response until the frame is complete
+     * (PLIS_END received or expected size reached) or the deadline expires.
+     * Each chunk is PLIS decoded in place as soon as it arrives,
+     * so the decoded response is always kept at the beginning of the buffer.
+     */
+    const steady_clock::time_point deadline =
+            steady_clock::now() + milliseconds(_responseTimeoutMs);
+    Plis::Decoder decoder;
+    int bts_read = 0;
+    size_t respSize = 0;
+    bool frameComplete = false;
+    while(!frameComplete && (respSize < static_cast<size_t>(maxRespSize)))
+    {
+        RETURN_VAL_ON_FAIL(!_cancelled, EC_FAIL);
+        steady_clock::time_point now = steady_clock::now();
+        BREAK_ON_FAIL(now < deadline);
+        milliseconds remaining = duration_cast<milliseconds>(deadline - now) + milliseconds(1);
+
+        unsigned char* chunk = response.data() + respSize;
+        int n = m_serial->ReadDataFromPort(
+                chunk,
+                static_cast<unsigned int>(static_cast<size_t>(maxRespSize) - respSize),
+                static_cast<uint32_t>(remaining.count()));
+        RETURN_VAL_ON_FAIL(n >= 0, EC_FAIL);
+        bts_read += n;
+
+        if(plisDecode)
+        {
+            size_t consumed = 0;
+            size_t produced = 0;
+            Plis::Decoder::decoder_status_t status = decoder.Feed(
+                    chunk, static_cast<size_t>(n),
+                    chunk, static_cast<size_t>(n),
+                    &consumed, &produced);
+            RETURN_VAL_ON_FAIL(status != Plis::Decoder::DECODER_STATUS_ERROR, EC_FAIL);
+            respSize += produced;
+            frameComplete = (status == Plis::Decoder::DECODER_STATUS_FRAME_END);
+        }
+        else
+        {
+            respSize += static_cast<size_t>(n);
+            frameComplete = (respSize >= expRespSize);
+        }
+    }
 
-    int bts_read =
-            m_serial->ReadDataFromPort(
-                    response.data(),
-                    static_cast<unsigned int>(maxRespSize));
     if(expRespSize > 0)
     {
         RETURN_VAL_ON_FAIL(bts_read > 0, EC_FAIL);
     }
-    RETURN_VAL_ON_FAIL(bts_read <= maxRespSize, EC_FAIL);
 
-    response.resize(static_cast<size_t>(bts_read));
-    response.shrink_to_fit();
-    if(plisDecode)
+    response.resize(respSize);
+    RETURN_VAL_ON_FAIL(response.size() == expRespSize, EC_FAIL);
+
+    return EC_OK;
+}
+
+void SerialDeviceTester::EndComm(ec_t ec)
+{
+    RETURN_VOID_ON_FAIL(m_serial->isComPortOpened());
+
+    /*
+     * In session mode the port stays opened for the next transaction.
+     * It is only reopened after an error, which also gets rid of
+     * any stale data left in the RX buffer.
+     */
+    if(!_sessionEnable || (ec != EC_OK))
     {
-        Plis::decode(response);
+        ClosePort();
     }
-    if(expRespSize > 0)
+}
+
+void SerialDeviceTester::ClosePort(void)
+{
+    if(_reactorFd != -1)
     {
-        RETURN_VAL_ON_FAIL(response.size() > 0, EC_FAIL);
+        _reactor.Remove(_reactorFd);
+        _reactorFd = -1;
     }
-    RETURN_VAL_ON_FAIL(response.size() == expRespSize, EC_FAIL);
-
     m_serial->CloseComPort();
-    return EC_OK;
 }
 
 void SerialDeviceTester::DispDutFields(void)
 {
     RETURN_VOID_ON_FAIL(_initOk);
 
-    printf("############## Displaying DUT summary #################\n");
+    fprintf(_out, "############## Displaying DUT summary #################\n");
     DispDutInfo();
     DispDutMeasurements();
-    printf("#######################################################\n");
+    fprintf(_out, "#######################################################\n");
 }
 
 void SerialDeviceTester::DispDutInfo(void)
@@ -894,42 +1387,42 @@ void SerialDeviceTester::DispDutInfo(void)
 
     GeneralDevice::Info info = m_sensx->GetInfo();
 
-    printf("DeviceStatus is: \t\t\t\t");
+    fprintf(_out, "DeviceStatus is: \t\t\t\t");
     switch(info.status)
     {
         case GeneralDevice::App:
         {
-            printf("App\n");
+            fprintf(_out, "App\n");
             break;
         }
         case GeneralDevice::Bootloader:
         {
-            printf("BootLoader\n");
+            fprintf(_out, "BootLoader\n");
             break;
         }
         case GeneralDevice::NoFirmware:
         {
-            printf("NoFirmware\n");
+            fprintf(_out, "NoFirmware\n");
             break;
         }
         case GeneralDevice::Unknown:
         {
-            printf("Unknown\n");
+            fprintf(_out, "Unknown\n");
             break;
         }
         case GeneralDevice::Error:
         {
-            printf("Error\n");
+            fprintf(_out, "Error\n");
             break;
         }
         default:
         {
-            printf("<N/A>\n");
+            fprintf(_out, "<N/A>\n");
             break;
         }
     }
 
-    printf("fwVersion is:\t\t\t\t\t%d.%d.%d\n",
+    fprintf(_out, "fwVersion is:\t\t\t\t\t%d.%d.%d\n",
             info.fwVersion.major, info.fwVersion.minor, info.fwVersion.patch);
 }
 
@@ -941,30 +1434,30 @@ void SerialDeviceTester::DispDutMeasurements(void)
     SensX::Measurements measures = m_sensx->MeasurementsGet();
     SensX::Measurement* measPtr = &(measures.t1);
     const uint16_t channels = sizeof(SensX::Measurements) / sizeof(SensX::Measurement);
-    printf("Detected RTD temperature channels:\t\t%d\n", channels);
+    fprintf(_out, "Detected RTD temperature channels:\t\t%d\n", channels);
     for(uint16_t i = 0; i < channels; i++, measPtr++)
     {
-        printf("RTD[%d] status is: \t\t\t\t", (i+1));
+        fprintf(_out, "RTD[%d] status is: \t\t\t\t", (i+1));
         switch(measPtr->status)
         {
             case SensX::RTD_OK:
             {
-                printf("RTD_OK\n");
+                fprintf(_out, "RTD_OK\n");
                 break;
             }
             case SensX::RTD_SHORTED:
             {
-                printf("RTD_SHORTED\n");
+                fprintf(_out, "RTD_SHORTED\n");
                 break;
             }
             case SensX::RTD_DISCON:
             {
-                printf("RTD_DISCON\n");
+                fprintf(_out, "RTD_DISCON\n");
                 break;
             }
             default:
             {
-                printf("<N/A>\n");
+                fprintf(_out, "<N/A>\n");
                 break;
             }
         }
@@ -974,14 +1467,14 @@ void SerialDeviceTester::DispDutMeasurements(void)
          * that's because float mantissa is 24-bit. Above this value
          * float makes rounds up/down of the total part.
          */
-        printf("RTD[%d] temperature is:\t\t\t\t%.2f%cC\n",
+        fprintf(_out, "RTD[%d] temperature is:\t\t\t\t%.2f%cC\n",
                 (i+1),
                 static_cast<float>(measPtr->value) / 100,
                 eAsciiDegree);
     }
 }
 
-void SerialDeviceTester::DispPreciseData2Pts(int data, bool noneuline)
+void SerialDeviceTester::DispPreciseData2Pts(FILE* out, int data, bool noneuline)
 {
     bool isNegative = data < 0 ? true : false;
     uint32_t adata = static_cast<uint32_t>(abs(data));
@@ -989,16 +1482,16 @@ void SerialDeviceTester::DispPreciseData2Pts(int data, bool noneuline)
     uint32_t lVal = adata % 100;
     if(isNegative)
     {
-        printf("-");
+        fprintf(out, "-");
     }
-    printf("%d,", hVal);
+    fprintf(out, "%d,", hVal);
     if(lVal < 10)
     {
-        printf("0");
+        fprintf(out, "0");
     }
-    printf("%d", lVal);
+    fprintf(out, "%d", lVal);
     if(!noneuline)
     {
-        printf("\n");
+        fprintf(out, "\n");
     }
 }
@@ -25,6 +25,8 @@
 */
 
 #include <devices/General.hpp>
+#include <serial/Crc16Ccitt.hpp>
+#include <serial/Plis.hpp>
 #include <string.h>
 
 using namespace std;
@@ -39,7 +41,9 @@ namespace alf64
 namespace devices
 {
 GeneralDevice::GeneralDevice(void):
-        initOk(false)
+        initOk(false),
+        reqHead(0),
+        reqCount(0)
 {
     if(Init() == EC_OK)
     {
@@ -58,7 +62,9 @@ ec_t GeneralDevice::Init(void)
     info.fwVersion.major = 0;
     info.fwVersion.minor = 0;
     info.fwVersion.patch = 0;
-    reqList.clear();
+    reqRing.assign(DEVICE_REQ_QUEUE_CAPACITY, Request());
+    reqHead = 0;
+    reqCount = 0;
 
     return EC_OK;
 }
@@ -123,14 +129,23 @@ GeneralDevice::Status GeneralDevice::AddQueueRequest(AgpMessage &msg)
 {
     RETURN_VAL_ON_FAIL(initOk, NotInit);
 
+    RETURN_VAL_ON_FAIL(msg.data.size() <= DEVICE_REQ_PAYLOAD_SIZE, InvalidArg);
+
     Status status = ValidateRequest(msg);
 
     if (status == OK)
     {
-        Request req;
-        req.data = msg.data;
-        req.resLength = GetResLength(msg.data[0]);
-        reqList.push_back(req);
+        RETURN_VAL_ON_FAIL(reqCount < reqRing.size(), QueueFull);
+
+        Request &req = reqRing[(reqHead + reqCount) % reqRing.size()];
+        req.function = msg.function;
+        req.length = static_cast<uint8_t>(msg.data.size());
+        if (req.length > 0)
+        {
+            memcpy(req.data, msg.data.data(), req.length);
+        }
+        req.resLength = GetResLength(msg.function);
+        reqCount++;
     }
 
     return status;
@@ -138,7 +153,41 @@ GeneralDevice::Status GeneralDevice::AddQueueRequest(AgpMessage &msg)
 
 void GeneralDevice::ClearRequestQueue(void)
 {
-    reqList.clear();
+    reqHead = 0;
+    reqCount = 0;
+    RequestQueueCleared();
+}
+
+GeneralDevice::Status GeneralDevice::SetRequestQueueCapacity(size_t capacity)
+{
+    RETURN_VAL_ON_FAIL(initOk, NotInit);
+    RETURN_VAL_ON_FAIL(capacity > 0, InvalidArg);
+
+    ClearRequestQueue();
+    reqRing.assign(capacity, Request());
+    reqRing.shrink_to_fit();
+
+    return OK;
+}
+
+size_t GeneralDevice::GetRequestQueueCapacity(void)
+{
+    return reqRing.size();
+}
+
+size_t GeneralDevice::GetRequestQueueSize(void)
+{
+    return reqCount;
+}
+
+const GeneralDevice::Request* GeneralDevice::GetFrontRequest(void)
+{
+    return (reqCount == 0) ? EmptyReqListMsg() : &reqRing[reqHead];
+}
+
+const GeneralDevice::Request* GeneralDevice::GetQueuedRequest(size_t index)
+{
+    return (index < reqCount) ? &reqRing[(reqHead + index) % reqRing.size()] : NULL;
 }
 
 int GeneralDevice::GetResLength(const uint8_t funct)
@@ -182,22 +231,116 @@ int GeneralDevice::GetNextRequest(ByteVector &data)
 {
     RETURN_VAL_ON_FAIL(initOk, -1);
 
-    int resLength = 0;
+    const Request* req = GetFrontRequest();
+    data.clear();
+    if (req == NULL)
+    {
+        return 0;
+    }
+
+    data.reserve(sizeof(req->function) + req->length + DEVICE_CRC_SIZE);
+    data.push_back(req->function);
+    data.insert(data.end(), req->data, req->data + req->length);
+    uint16_t crc = Crc16(data);
+    data.push_back(static_cast<uint8_t>((crc & 0xFF)));
+    data.push_back(static_cast<uint8_t>(((crc >> 8) & 0xFF)));
 
-    if (reqList.empty())
+    return req->resLength;
+}
+
+int GeneralDevice::GetNextRequestFrame(ByteVector &frame)
+{
+    RETURN_VAL_ON_FAIL(initOk, -1);
+
+    const Request* req = GetFrontRequest();
+    if (req == NULL)
     {
-        resLength = EmptyReqListMsg(data);
+        frame.clear();
+        return 0;
     }
-    else
+
+    return BuildRequestFrame(req, frame);
+}
+
+int GeneralDevice::GetRequestFrame(size_t index, ByteVector &frame)
+{
+    RETURN_VAL_ON_FAIL(initOk, -1);
+
+    const Request* req = GetQueuedRequest(index);
+    RETURN_VAL_ON_FAIL(req != NULL, -1);
+
+    return BuildRequestFrame(req, frame);
+}
+
+int GeneralDevice::GetRequestResLength(size_t index)
+{
+    RETURN_VAL_ON_FAIL(initOk, -1);
+
+    const Request* req = GetQueuedRequest(index);
+    RETURN_VAL_ON_FAIL(req != NULL, -1);
+
+    return req->resLength;
+}
+
+GeneralDevice::Status GeneralDevice::RequeueRequest(void)
+{
+    RETURN_VAL_ON_FAIL(initOk, NotInit);
+    RETURN_VAL_ON_FAIL(reqCount > 0, InvalidArg);
+
+    // with a full ring the tail slot is the head slot itself, so nothing is copied then
+    size_t tail = (reqHead + reqCount) % reqRing.size();
+    if (tail != reqHead)
     {
-        data = reqList.front().data;
-        resLength = reqList.front().resLength;
+        reqRing[tail] = reqRing[reqHead];
     }
+    reqHead = (reqHead + 1) % reqRing.size();
 
-    return resLength;
+    return OK;
+}
+
+int GeneralDevice::BuildRequestFrame(const Request* req, ByteVector &frame)
+{
+    // resizing down keeps the capacity, so a reused vector is not reallocated
+    frame.resize(RequestFrameMaxSize(req->length));
+    size_t frameSize = BuildRequestFrame(req->function, req->data, req->length, frame.data());
+    frame.resize(frameSize);
+
+    return req->resLength;
+}
+
+size_t GeneralDevice::RequestFrameMaxSize(size_t payloadSize)
+{
+    // each byte may be escaped, plus PLIS_END
+    return ((sizeof(uint8_t) + payloadSize + DEVICE_CRC_SIZE) * 2) + 1;
 }
 
-GeneralDevice::Status GeneralDevice::ValidateRequest(AgpMessage &msg)
+size_t GeneralDevice::BuildRequestFrame(
+        uint8_t function,
+        const uint8_t* payload,
+        size_t payloadSize,
+        uint8_t* dst)
+{
+    Crc16Ccitt crc;
+    uint8_t* out = dst;
+
+    crc.Update(function);
+    out += Plis::encodeByte(function, out);
+
+    for (size_t i = 0; i < payloadSize; i++)
+    {
+        crc.Update(payload[i]);
+        out += Plis::encodeByte(payload[i], out);
+    }
+
+    uint16_t crcVal = crc.Final();
+    out += Plis::encodeByte(static_cast<uint8_t>((crcVal & 0xFF)), out);
+    out += Plis::encodeByte(static_cast<uint8_t>(((crcVal >> 8) & 0xFF)), out);
+    *out++ = PLIS_END;
+
+    return static_cast<size_t>(out - dst);
+}
+
+GeneralDevice::Status GeneralDevice::ValidateRequest(const AgpMessage &msg)
 {
     RETURN_VAL_ON_FAIL(initOk, NotInit);
 
@@ -224,28 +367,19 @@ GeneralDevice::Status GeneralDevice::ValidateRequest(AgpMessage &msg)
         }
     }
 
-    if (status == OK)
-    {
-        msg.data.emplace(msg.data.begin(), msg.function);
-        uint16_t crc = Crc16(msg.data);
-        msg.data.push_back(static_cast<uint8_t>((crc & 0xFF)));
-        msg.data.push_back(static_cast<uint8_t>(((crc >> 8) & 0xFF)));
-    }
-
     return status;
 }
 
 GeneralDevice::Status GeneralDevice::ParseResponse(ByteVector &data)
 {
     RETURN_VAL_ON_FAIL(initOk, NotInit);
-    RETURN_VAL_ON_FAIL(reqList.size() > 0, InvalidArg);
+    RETURN_VAL_ON_FAIL(reqCount > 0, InvalidArg);
     RETURN_VAL_ON_FAIL((data.size() >= (DEVICE_STATUS_SIZE + DEVICE_CRC_SIZE)), InvalidArg);
 
     uint16_t crc_hi = static_cast<uint16_t>(data.at(data.size() - 1) << 8);
     uint16_t crc_lo = static_cast<uint16_t>(data.at(data.size() - 2)) & 0xFF;
     uint16_t crc = crc_hi | crc_lo;
     data.resize(data.size() - DEVICE_CRC_SIZE);
-    data.shrink_to_fit();
 
     if (crc != Crc16(data))
     {
@@ -253,7 +387,7 @@ GeneralDevice::Status GeneralDevice::ParseResponse(ByteVector &data)
     }
 
     Status status = static_cast<Status>(data.at(0));
-    CommonFunctions funct = static_cast<CommonFunctions>(reqList.front().data.at(0));
+    CommonFunctions funct = static_cast<CommonFunctions>(reqRing[reqHead].function);
 
     switch (funct)
     {
@@ -322,37 +456,32 @@ GeneralDevice::Status GeneralDevice::ParseResponse(ByteVector &data)
 
     if (status != Busy)
     {
-        reqList.erase(reqList.begin());
+        RequestDequeued(reqRing[reqHead]);
+        reqHead = (reqHead + 1) % reqRing.size();
+        reqCount--;
     }
 
     return status;
 }
 
-int GeneralDevice::EmptyReqListMsg(ByteVector &data)
+const GeneralDevice::Request* GeneralDevice::EmptyReqListMsg(void)
 {
-    RETURN_VAL_ON_FAIL(initOk, -1);
-    data.clear();
-    return 0;
+    return NULL;
 }
 
-uint16_t GeneralDevice::Crc16(const ByteVector &data)
+void GeneralDevice::RequestDequeued(const Request &req)
 {
-    unsigned int length = static_cast<unsigned int>(data.size());
-
-    uint16_t crc = 0xffff;
-    const unsigned char *pData = data.data();
-
-    while (length--)
-    {
-        crc = static_cast<uint16_t>(crc ^ (*pData++ << 8));
+    (void)req;
+}
 
-        for (uint8_t i = 0; i < 8; i++)
-        {
-            crc = static_cast<uint16_t>(crc & 0x8000 ? (crc << 1) ^ 0x1021 : crc << 1);
-        }
-    }
+void GeneralDevice::RequestQueueCleared(void)
+{
+    return;
+}
 
-    return static_cast<uint16_t>(REVERSE_U16_BYTE(crc));
+uint16_t GeneralDevice::Crc16(const ByteVector &data)
+{
+    return Crc16Ccitt::Compute(data.data(), data.size());
 }
 
 } // namespace devices
@@ -25,12 +25,17 @@
 */
 
 #include <devices/SensX.hpp>
+#include <string.h>
 using namespace std;
 
 #define RES_MEASUREMENT_READ_LENGTH \
     (DEVICE_STATUS_SIZE + sizeof(MeasurementData) + DEVICE_CRC_SIZE)
 #define RES_RTC_SET_LENGTH (DEVICE_STATUS_SIZE + DEVICE_CRC_SIZE)
 #define RES_HOST_WAKE_UP_TIME_SET_LENGTH (DEVICE_STATUS_SIZE + DEVICE_CRC_SIZE)
+#define RES_RSW_GET_FREE_SPACE_LENGTH (DEVICE_STATUS_SIZE + 1 + DEVICE_CRC_SIZE)
+#define RES_RSW_ADD_REQ_LENGTH (DEVICE_STATUS_SIZE + DEVICE_CRC_SIZE)
+// function byte and the longest response of a function that can be queued
+#define RES_RSW_READ_RES_LENGTH (DEVICE_STATUS_SIZE + 1 + RES_MEASUREMENT_READ_LENGTH)
 
 namespace alf64
 {
@@ -53,12 +58,10 @@ SensX::~SensX(void)
 
 ec_t SensX::Init(void)
 {
-    emptyReq.data.clear();
-    emptyReq.data.emplace(emptyReq.data.begin(), MeasurementRead);
-    uint16_t crc = Crc16(emptyReq.data);
-    emptyReq.data.push_back(static_cast<uint8_t>((crc & 0xFF)));
-    emptyReq.data.push_back(static_cast<uint8_t>(((crc >> 8) & 0xFF)));
+    emptyReq.function = MeasurementRead;
+    emptyReq.length = 0;
     emptyReq.resLength = GetResLength(MeasurementRead);
+    RswReset();
 
     return EC_OK;
 }
@@ -109,8 +112,8 @@ GeneralDevice::Status SensX::MeasurementsSetInterval(uint16_t interval)
 
     msg.function = MeasurementSetInterval;
     msg.data.clear();
-    emptyReq.data.push_back(static_cast<uint8_t>((interval & 0xFF)));
-    emptyReq.data.push_back(static_cast<uint8_t>(((interval >> 8) & 0xFF)));
+    msg.data.push_back(static_cast<uint8_t>((interval & 0xFF)));
+    msg.data.push_back(static_cast<uint8_t>(((interval >> 8) & 0xFF)));
 
     return AddQueueRequest(msg);
 }
@@ -231,6 +234,103 @@ GeneralDevice::Status SensX::LogRead(LogRange &range)
     return AddQueueRequest(msg);
 }
 
+GeneralDevice::Status SensX::RswGetFreeSpace(void)
+{
+    RETURN_VAL_ON_FAIL(initOk, NotInit);
+
+    AgpMessage msg;
+
+    msg.function = RswGetQueueFreeSpace;
+    msg.data.clear();
+
+    return AddQueueRequest(msg);
+}
+
+GeneralDevice::Status SensX::RswAddRequest(uint8_t function, const ByteVector &data)
+{
+    RETURN_VAL_ON_FAIL(initOk, NotInit);
+    RETURN_VAL_ON_FAIL(rswStats.credits > 0, QueueFull);
+
+    AgpMessage msg;
+
+    msg.function = RswAddReq;
+    msg.data.clear();
+    msg.data.push_back(function);
+    msg.data.insert(msg.data.end(), data.begin(), data.end());
+
+    Status status = AddQueueRequest(msg);
+
+    if (status == OK)
+    {
+        rswStats.credits--;
+        rswUnacked.push_back(function);
+    }
+
+    return status;
+}
+
+GeneralDevice::Status SensX::RswAddMeasurementsRead(void)
+{
+    const ByteVector noData;
+
+    return RswAddRequest(MeasurementRead, noData);
+}
+
+GeneralDevice::Status SensX::RswReadResult(void)
+{
+    RETURN_VAL_ON_FAIL(initOk, NotInit);
+
+    AgpMessage msg;
+
+    msg.function = RswReadRes;
+    msg.data.clear();
+
+    return AddQueueRequest(msg);
+}
+
+void SensX::RswReset(void)
+{
+    rswUnacked.clear();
+    rswPending.clear();
+    memset(&rswStats, 0, sizeof(rswStats));
+}
+
+void SensX::RswDropInFlight(void)
+{
+    rswUnacked.clear();
+    rswPending.clear();
+    rswStats.credits = 0;
+    rswStats.occupancy = 0;
+}
+
+SensX::RswStats SensX::RswGetStats(void)
+{
+    return rswStats;
+}
+
+size_t SensX::RswGetPending(void)
+{
+    return rswPending.size();
+}
+
+bool SensX::IsRswFunction(uint8_t funct)
+{
+    switch (static_cast<SensXCmd>(funct))
+    {
+        case RswGetQueueFreeSpace:
+        case RswAddReq:
+        case RswReadRes:
+        {
+            return false;
+        }
+
+        default:
+        {
+            return (GetSpecificResLength(funct) > 0);
+        }
+    }
+}
+
 GeneralDevice::Status SensX::ValidateSpecificRequest(const AgpMessage &msg)
 {
     RETURN_VAL_ON_FAIL(initOk, NotInit);
@@ -336,6 +436,17 @@ GeneralDevice::Status SensX::ValidateSpecificRequest(const AgpMessage &msg)
 
         case RswAddReq:
         {
+            if ((msg.data.size() < 1) || !IsRswFunction(msg.data.at(0)))
+            {
+                status = InvalidArg;
+            }
+            else
+            {
+                AgpMessage nested;
+                nested.function = msg.data.at(0);
+                nested.data.assign(msg.data.begin() + 1, msg.data.end());
+                status = ValidateSpecificRequest(nested);
+            }
             break;
         }
 
@@ -422,6 +533,91 @@ GeneralDevice::Status SensX::ParseSpecificResponse(const uint8_t funct, const By
             break;
         }
 
+        case RswGetQueueFreeSpace:
+        {
+            if (status == OK)
+            {
+                if (length != 1)
+                {
+                    status = WrongCmdLength;
+                }
+                else
+                {
+                    // requests queued after this one were not accounted by the device yet
+                    uint32_t freeSpace = data.at(1);
+                    uint32_t unacked = static_cast<uint32_t>(rswUnacked.size());
+                    rswStats.credits = (freeSpace > unacked) ? (freeSpace - unacked) : 0;
+                }
+            }
+            break;
+        }
+
+        case RswAddReq:
+        {
+            // the request leaves rswUnacked in RequestDequeued(), whatever the response was
+            RETURN_VAL_ON_FAIL(!rswUnacked.empty(), WrongCmd);
+            uint8_t nested = rswUnacked.front();
+
+            if (status == Busy)
+            {
+                // credits should have prevented it, do not retry
+                status = QueueFull;
+                rswStats.credits = 0;
+            }
+
+            if ((status == OK) && (length != 0))
+            {
+                status = WrongCmdLength;
+            }
+
+            if (status == OK)
+            {
+                rswPending.push_back(nested);
+                rswStats.submitted++;
+                rswStats.occupancy = static_cast<uint32_t>(rswPending.size());
+                if (rswStats.occupancy > rswStats.peakOccupancy)
+                {
+                    rswStats.peakOccupancy = rswStats.occupancy;
+                }
+            }
+            else
+            {
+                rswStats.rejected++;
+            }
+            break;
+        }
+
+        case RswReadRes:
+        {
+            if (status == Busy)
+            {
+                rswStats.notReady++;
+                status = OK;
+            }
+            else if (status == OK)
+            {
+                // function byte and at least the status of its response
+                if ((length < 2) || rswPending.empty())
+                {
+                    status = WrongCmdLength;
+                }
+                else if (data.at(1) != rswPending.front())
+                {
+                    status = WrongCmd;
+                }
+                else
+                {
+                    rswPending.pop_front();
+                    rswStats.completed++;
+                    rswStats.occupancy = static_cast<uint32_t>(rswPending.size());
+
+                    ByteVector nestedData(data.begin() + 2, data.end());
+                    status = ParseSpecificResponse(data.at(1), nestedData);
+                }
+            }
+            break;
+        }
+
         default:
         {
             status = UnsupportedCmd;
@@ -457,6 +653,24 @@ int SensX::GetSpecificResLength(const uint8_t funct)
             break;
         }
 
+        case RswGetQueueFreeSpace:
+        {
+            resLength = RES_RSW_GET_FREE_SPACE_LENGTH;
+            break;
+        }
+
+        case RswAddReq:
+        {
+            resLength = RES_RSW_ADD_REQ_LENGTH;
+            break;
+        }
+
+        case RswReadRes:
+        {
+            resLength = RES_RSW_READ_RES_LENGTH;
+            break;
+        }
+
         default:
         {
             break;
@@ -466,10 +680,22 @@ int SensX::GetSpecificResLength(const uint8_t funct)
     return resLength;
 }
 
-int SensX::EmptyReqListMsg(ByteVector &data)
+const GeneralDevice::Request* SensX::EmptyReqListMsg(void)
+{
+    return &emptyReq;
+}
+
+void SensX::RequestDequeued(const Request &req)
+{
+    if ((req.function == RswAddReq) && !rswUnacked.empty())
+    {
+        rswUnacked.pop_front();
+    }
+}
+
+void SensX::RequestQueueCleared(void)
 {
-    data = emptyReq.data;
-    return emptyReq.resLength;
+    RswDropInFlight();
 }
 
 SensX::MeasurementStatus SensX::ParseMeasurementStatus(int16_t value)
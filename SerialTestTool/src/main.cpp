@@ -33,13 +33,6 @@
 
 using namespace std;
 
-/*
- * Currently only build for Windows OS is possible.
- */
-#ifndef _WIN32
-#error "This app is meant to be build for Windows."
-#endif
-
 int main(int argc, const char** argv) {
     int retval = EXIT_FAILURE;
 
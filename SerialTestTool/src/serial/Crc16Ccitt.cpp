@@ -0,0 +1,269 @@
+/*
+***************************************************************************
+*
+* Author: alf64
+*
+* Copyright (C) 2019 alf64
+*
+* Email: alf64gordon@gmail.com
+*
+***************************************************************************
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* See <http://www.gnu.org/licenses/>.
+*
+***************************************************************************
+*/
+
+#include <serial/Crc16Ccitt.hpp>
+#include <string.h>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define CRC16CCITT_CLMUL
+#include <immintrin.h>
+#endif
+
+//!< Returns x^n mod P (P = x^16 + polynomial).
+static constexpr uint16_t xPowMod(unsigned int n)
+{
+    uint32_t r = 1;
+    while(n--)
+    {
+        r <<= 1;
+        if(r & 0x10000ul)
+        {
+            r ^= 0x10000ul | Crc16Ccitt::polynomial;
+        }
+    }
+    return static_cast<uint16_t>(r);
+}
+
+//!< Folding constants: a 128-bit block is moved 128 bits forward as H*x^192 + L*x^128 (H, L - its 64-bit halves).
+static constexpr uint64_t clmulKHi = xPowMod(192);
+static constexpr uint64_t clmulKLo = xPowMod(128);
+
+constexpr Crc16Ccitt::Tables::Tables(void):
+        t()
+{
+    for(unsigned int b = 0; b < 256; b++)
+    {
+        uint16_t crc = static_cast<uint16_t>(b << 8);
+        for(uint8_t i = 0; i < 8; i++)
+        {
+            crc = static_cast<uint16_t>((crc & 0x8000) ? ((crc << 1) ^ polynomial) : (crc << 1));
+        }
+        t[0][b] = crc;
+    }
+
+    for(unsigned int k = 1; k < 8; k++)
+    {
+        for(unsigned int b = 0; b < 256; b++)
+        {
+            uint16_t prev = t[k - 1][b];
+            t[k][b] = static_cast<uint16_t>((prev << 8) ^ t[0][prev >> 8]);
+        }
+    }
+}
+
+const Crc16Ccitt::Tables Crc16Ccitt::tables;
+
+Crc16Ccitt::Crc16Ccitt(void)
+{
+    Init();
+}
+
+Crc16Ccitt::~Crc16Ccitt(void)
+{
+
+}
+
+void Crc16Ccitt::Init(void)
+{
+    crc = initValue;
+}
+
+void Crc16Ccitt::Update(const uint8_t* data, size_t size)
+{
+    crc = UpdateBest(crc, data, size);
+}
+
+uint16_t Crc16Ccitt::Final(void) const
+{
+    return static_cast<uint16_t>((crc >> 8) | (crc << 8));
+}
+
+uint16_t Crc16Ccitt::Compute(const uint8_t* data, size_t size)
+{
+    uint16_t crc = UpdateBest(initValue, data, size);
+    return static_cast<uint16_t>((crc >> 8) | (crc << 8));
+}
+
+uint16_t Crc16Ccitt::UpdateBitwise(uint16_t crc, const uint8_t* data, size_t size)
+{
+    while(size--)
+    {
+        crc = static_cast<uint16_t>(crc ^ (*data++ << 8));
+
+        for(uint8_t i = 0; i < 8; i++)
+        {
+            crc = static_cast<uint16_t>((crc & 0x8000) ? ((crc << 1) ^ polynomial) : (crc << 1));
+        }
+    }
+
+    return crc;
+}
+
+uint16_t Crc16Ccitt::UpdateTable(uint16_t crc, const uint8_t* data, size_t size)
+{
+    while(size--)
+    {
+        crc = static_cast<uint16_t>((crc << 8) ^ tables.t[0][(crc >> 8) ^ *data++]);
+    }
+
+    return crc;
+}
+
+uint16_t Crc16Ccitt::UpdateSlicing8(uint16_t crc, const uint8_t* data, size_t size)
+{
+    while(size >= 8)
+    {
+        // crc state is merged into the first two bytes, each byte is then advanced
+        // by the number of bytes that follow it within the block
+        uint8_t b0 = static_cast<uint8_t>(data[0] ^ (crc >> 8));
+        uint8_t b1 = static_cast<uint8_t>(data[1] ^ (crc & 0xFF));
+        crc = static_cast<uint16_t>(
+                tables.t[7][b0] ^ tables.t[6][b1] ^
+                tables.t[5][data[2]] ^ tables.t[4][data[3]] ^
+                tables.t[3][data[4]] ^ tables.t[2][data[5]] ^
+                tables.t[1][data[6]] ^ tables.t[0][data[7]]);
+        data += 8;
+        size -= 8;
+    }
+
+    return UpdateTable(crc, data, size);
+}
+
+#if defined(CRC16CCITT_CLMUL)
+__attribute__((target("pclmul,ssse3")))
+uint16_t Crc16Ccitt::UpdateClmul(uint16_t crc, const uint8_t* data, size_t size)
+{
+    if(size < (2 * sizeof(__m128i)))
+    {
+        return UpdateSlicing8(crc, data, size);
+    }
+
+    // blocks are handled as 128-bit polynomials, first byte being the most significant one
+    const __m128i bswap = _mm_setr_epi8(15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0);
+    const __m128i k = _mm_set_epi64x(static_cast<long long>(clmulKHi), static_cast<long long>(clmulKLo));
+
+    __m128i acc = _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(data)), bswap);
+    acc = _mm_xor_si128(acc, _mm_set_epi64x(static_cast<long long>(static_cast<uint64_t>(crc) << 48), 0));
+    data += sizeof(__m128i);
+    size -= sizeof(__m128i);
+
+    while(size >= sizeof(__m128i))
+    {
+        __m128i next = _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(data)), bswap);
+        __m128i hi = _mm_clmulepi64_si128(acc, k, 0x11);
+        __m128i lo = _mm_clmulepi64_si128(acc, k, 0x00);
+        acc = _mm_xor_si128(_mm_xor_si128(hi, lo), next);
+        data += sizeof(__m128i);
+        size -= sizeof(__m128i);
+    }
+
+    // the remaining 128 bits are congruent to the data folded so far, reduce them with the table
+    uint8_t folded[sizeof(__m128i)];
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(folded), _mm_shuffle_epi8(acc, bswap));
+    crc = UpdateTable(0, folded, sizeof(folded));
+
+    return UpdateSlicing8(crc, data, size);
+}
+
+bool Crc16Ccitt::ClmulSupported(void)
+{
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("pclmul") && __builtin_cpu_supports("ssse3");
+}
+#else
+uint16_t Crc16Ccitt::UpdateClmul(uint16_t crc, const uint8_t* data, size_t size)
+{
+    return UpdateSlicing8(crc, data, size);
+}
+
+bool Crc16Ccitt::ClmulSupported(void)
+{
+    return false;
+}
+#endif
+
+uint16_t Crc16Ccitt::UpdateBest(uint16_t crc, const uint8_t* data, size_t size)
+{
+    static const bool clmul = ClmulSupported();
+
+    if(clmul && (size >= clmulMinSize))
+    {
+        return UpdateClmul(crc, data, size);
+    }
+
+    return UpdateSlicing8(crc, data, size);
+}
+
+bool Crc16Ccitt::TestCrc16(void)
+{
+    bool result = true;
+
+    // check value of CRC-16/CCITT-FALSE
+    const uint8_t check[] = {'1', '2', '3', '4', '5', '6', '7', '8', '9'};
+    if(Compute(check, sizeof(check)) != 0xB129)
+    {
+        result = false;
+    }
+
+    uint8_t data[300];
+    uint32_t seed = 0x1234567ul;
+    for(size_t i = 0; i < sizeof(data); i++)
+    {
+        seed = seed * 1103515245ul + 12345ul;
+        data[i] = static_cast<uint8_t>(seed >> 16);
+    }
+
+    for(size_t size = 0; (size <= sizeof(data)) && result; size++)
+    {
+        uint16_t init = static_cast<uint16_t>(initValue ^ (size * 0x9E37u));
+        uint16_t ref = UpdateBitwise(init, data, size);
+
+        if((UpdateTable(init, data, size) != ref) ||
+            (UpdateSlicing8(init, data, size) != ref) ||
+            (UpdateClmul(init, data, size) != ref) ||
+            (UpdateBest(init, data, size) != ref))
+        {
+            result = false;
+            break;
+        }
+
+        // incremental calculation: a block, a single byte, the rest
+        Crc16Ccitt inc;
+        if(size > 0)
+        {
+            size_t split = size / 3;
+            inc.Update(data, split);
+            inc.Update(data[split]);
+            inc.Update(data + split + 1, size - split - 1);
+        }
+        if(inc.Final() != Compute(data, size))
+        {
+            result = false;
+        }
+    }
+
+    return result;
+}
@@ -27,15 +27,15 @@
 #include <math.h>
 #include <serial/Plis.hpp>
 #include <string.h>
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
 
 
 using namespace std;
 
-static const unsigned char encodeTable[2][3] = {
-        {PLIS_END, PLIS_ESC, PLIS_ESC_END},
-        {PLIS_ESC, PLIS_ESC, PLIS_ESC_ESC}
-};
-
 Plis::Plis()
 {
 }
@@ -46,73 +46,219 @@ Plis::~Plis()
 
 void Plis::encode(ByteVector &data)
 {
-    ByteVector::iterator it = data.begin();
-    while(it != data.end())
+    const size_t size = data.size();
+    const size_t reserved = countReserved(data.data(), size);
+
+    if(reserved == 0)
+    {
+        data.push_back(PLIS_END);
+        return;
+    }
+
+    /*
+     * Grow the vector once to the final size and move the raw data to its tail,
+     * then encode it forward into the same storage.
+     * Write position never overtakes the read position,
+     * because the gap between them is (reserved + 1) and each escape consumes one.
+     */
+    const size_t gap = reserved + 1;
+    data.resize(size + gap);
+    uint8_t* dt = data.data();
+    memmove(dt + gap, dt, size);
+    encodeRuns(dt + gap, size, dt);
+}
+
+int Plis::encode(const uint8_t* src, size_t srcSize, uint8_t* dst, size_t dstSize)
+{
+    RETURN_VAL_ON_FAIL((src != NULL) || (srcSize == 0), -1);
+    RETURN_VAL_ON_FAIL(dst != NULL, -1);
+    RETURN_VAL_ON_FAIL(dstSize >= ((srcSize * 2) + 1), -1);
+
+    return static_cast<int>(encodeRuns(src, srcSize, dst));
+}
+
+size_t Plis::encodeRuns(const uint8_t* src, size_t srcSize, uint8_t* dst)
+{
+    uint8_t* out = dst;
+    size_t i = 0;
+
+    while(i < srcSize)
     {
-        for(int j = 0; j < 2; j++)
+        // copy the run of bytes that need no escaping at once
+        size_t run = findReserved(src + i, srcSize - i);
+        memmove(out, src + i, run);
+        out += run;
+        i += run;
+
+        if(i < srcSize)
         {
-            if(*it == encodeTable[j][0])
-            {
-                it = data.erase(it);
-                it = data.emplace(it, encodeTable[j][2]);
-                it = data.emplace(it, encodeTable[j][1]);
-                break;
-            }
+            const uint8_t reserved = src[i++];
+            *out++ = PLIS_ESC;
+            *out++ = (reserved == PLIS_END) ? PLIS_ESC_END : PLIS_ESC_ESC;
+        }
+    }
+
+    *out++ = PLIS_END;
+
+    return static_cast<size_t>(out - dst);
+}
+
+size_t Plis::findReserved(const uint8_t* data, size_t size)
+{
+    size_t i = 0;
+
+#if defined(__AVX2__)
+    const __m256i end32 = _mm256_set1_epi8(static_cast<char>(PLIS_END));
+    const __m256i esc32 = _mm256_set1_epi8(static_cast<char>(PLIS_ESC));
+    for(; (i + 32) <= size; i += 32)
+    {
+        __m256i chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i));
+        __m256i hits = _mm256_or_si256(
+                _mm256_cmpeq_epi8(chunk, end32),
+                _mm256_cmpeq_epi8(chunk, esc32));
+        uint32_t mask = static_cast<uint32_t>(_mm256_movemask_epi8(hits));
+        if(mask != 0)
+        {
+            return i + static_cast<size_t>(__builtin_ctz(mask));
+        }
+    }
+#endif
+
+#if defined(__SSE2__)
+    const __m128i end16 = _mm_set1_epi8(static_cast<char>(PLIS_END));
+    const __m128i esc16 = _mm_set1_epi8(static_cast<char>(PLIS_ESC));
+    for(; (i + 16) <= size; i += 16)
+    {
+        __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+        __m128i hits = _mm_or_si128(
+                _mm_cmpeq_epi8(chunk, end16),
+                _mm_cmpeq_epi8(chunk, esc16));
+        uint32_t mask = static_cast<uint32_t>(_mm_movemask_epi8(hits));
+        if(mask != 0)
+        {
+            return i + static_cast<size_t>(__builtin_ctz(mask));
         }
-        it++;
+    }
+#endif
+
+    for(; i < size; i++)
+    {
+        if((data[i] == PLIS_END) || (data[i] == PLIS_ESC))
+        {
+            break;
+        }
+    }
+
+    return i;
+}
+
+size_t Plis::countReserved(const uint8_t* data, size_t size)
+{
+    size_t cnt = 0;
+    size_t i = findReserved(data, size);
+
+    while(i < size)
+    {
+        cnt++;
+        i++;
+        i += findReserved(data + i, size - i);
     }
 
-    data.push_back(PLIS_END);
+    return cnt;
 }
 
 void Plis::decode(ByteVector &data)
 {
-    const auto dt_start = data.begin();
+    Decoder decoder;
+    size_t consumed = 0;
+    size_t produced = 0;
+
+    Decoder::decoder_status_t status = decoder.Feed(
+            data.data(), data.size(),
+            data.data(), data.size(),
+            &consumed, &produced);
+    if(status == Decoder::DECODER_STATUS_ERROR)
+    {
+        data.clear();
+    }
+    else
+    {
+        data.resize(produced);
+    }
+}
+
+Plis::Decoder::Decoder(void):
+        escPending(false)
+{
+}
 
-    uint8_t lastByte = 0;
+void Plis::Decoder::Reset(void)
+{
+    escPending = false;
+}
 
+Plis::Decoder::decoder_status_t Plis::Decoder::Feed(
+        const uint8_t* in,
+        size_t inSize,
+        uint8_t* out,
+        size_t outSize,
+        size_t* consumed,
+        size_t* produced)
+{
+    decoder_status_t status = DECODER_STATUS_MORE_DATA;
     size_t i = 0;
-    while(i < data.size())
+    size_t o = 0;
+
+    while(i < inSize)
     {
-        plis_status_t status = Plis::decodeByte(&(data.at(i)), lastByte);
-        switch (status)
+        if(escPending)
         {
-            case PLIS_STATUS_ERROR:
+            uint8_t byte = in[i];
+            if(decodeByte(&byte, PLIS_ESC) == PLIS_STATUS_ERROR)
             {
-                data.clear();
+                escPending = false;
+                i++;
+                status = DECODER_STATUS_ERROR;
                 break;
             }
-
-            case PLIS_STATUS_ESC:
+            if(o == outSize)
             {
-                lastByte = data.at(i);
-                data.erase(dt_start + static_cast<long long int>(i));
+                status = DECODER_STATUS_OVERFLOW;
                 break;
             }
+            out[o++] = byte;
+            escPending = false;
+            i++;
+            continue;
+        }
 
-            case PLIS_STATUS_END:
-            {
-                data.erase(dt_start + static_cast<long long int>(i));
-                return;
-            }
+        // copy the run of plain bytes at once
+        size_t run = findReserved(in + i, inSize - i);
+        if(run > (outSize - o))
+        {
+            run = outSize - o;
+            status = DECODER_STATUS_OVERFLOW;
+        }
+        memmove(out + o, in + i, run);
+        o += run;
+        i += run;
+        BREAK_ON_FAIL(status == DECODER_STATUS_MORE_DATA);
 
-            default:
+        if(i < inSize)
+        {
+            if(in[i++] == PLIS_END)
             {
-                if(data.at(i) == PLIS_ESC)
-                {
-                    lastByte = 0;
-                }
-                else
-                {
-                    lastByte = data.at(i);
-                }
-
-                i++;
-
+                status = DECODER_STATUS_FRAME_END;
                 break;
             }
+            escPending = true;
         }
     }
+
+    *consumed = i;
+    *produced = o;
+
+    return status;
 }
 
 int Plis::overhead(int buffLength)
@@ -261,6 +407,51 @@ bool Plis::TestEncode(void)
 
     RETURN_VAL_ON_FAIL((i == testDataSize), false);
 
+    // output buffer variant
+    uint8_t encBuffer[(testBuffSize * 2) + 1];
+    int encSize = encode(testBuffer, testBuffSize, encBuffer, sizeof(encBuffer));
+    RETURN_VAL_ON_FAIL((encSize == refBuffSize), false);
+    RETURN_VAL_ON_FAIL((memcmp(encBuffer, refBuffer, refBuffSize) == 0), false);
+    RETURN_VAL_ON_FAIL((encode(testBuffer, testBuffSize, encBuffer, refBuffSize) == -1), false);
+
+    // byte by byte variant
+    size_t byteEncSize = 0;
+    for(i = 0; i < testBuffSize; i++)
+    {
+        byteEncSize += encodeByte(testBuffer[i], encBuffer + byteEncSize);
+    }
+    encBuffer[byteEncSize++] = PLIS_END;
+    RETURN_VAL_ON_FAIL((byteEncSize == refBuffSize), false);
+    RETURN_VAL_ON_FAIL((memcmp(encBuffer, refBuffer, refBuffSize) == 0), false);
+
+    /*
+     * Long data with reserved bytes scattered over vectorized scan boundaries,
+     * checked by decoding it back.
+     */
+    static const size_t longSize = 200;
+    ByteVector longData;
+    size_t longReserved = 0;
+    for(size_t k = 0; k < longSize; k++)
+    {
+        uint8_t val = static_cast<uint8_t>(k);
+        if((k % 7 == 0) || (k % 31 == 0) || (k >= 150))
+        {
+            val = (k % 2) ? PLIS_END : PLIS_ESC;
+            longReserved++;
+        }
+        longData.push_back(val);
+    }
+    ByteVector longEncoded = longData;
+    encode(longEncoded);
+    RETURN_VAL_ON_FAIL((longEncoded.size() == (longSize + longReserved + 1)), false);
+    RETURN_VAL_ON_FAIL((countReserved(longEncoded.data(), longEncoded.size()) == (longReserved + 1)), false);
+    ByteVector longBuffer((longSize * 2) + 1);
+    encSize = encode(longData.data(), longData.size(), longBuffer.data(), longBuffer.size());
+    RETURN_VAL_ON_FAIL((encSize == static_cast<int>(longEncoded.size())), false);
+    RETURN_VAL_ON_FAIL((memcmp(longBuffer.data(), longEncoded.data(), longEncoded.size()) == 0), false);
+    decode(longEncoded);
+    RETURN_VAL_ON_FAIL((longEncoded == longData), false);
+
     return true;
 }
 
@@ -315,5 +506,57 @@ bool Plis::TestDecode(void)
 
     RETURN_VAL_ON_FAIL((i == testDataSize), false);
 
+    // streaming decoder fed in two chunks, split at every position (escape pairs included)
+    for(uint8_t split = 0; split <= testBuffSize; split++)
+    {
+        Decoder decoder;
+        uint8_t outBuffer[testBuffSize];
+        size_t consumed = 0;
+        size_t produced = 0;
+        size_t outSize = 0;
+
+        Decoder::decoder_status_t status = decoder.Feed(
+                testBuffer, split, outBuffer, sizeof(outBuffer), &consumed, &produced);
+        outSize += produced;
+        if(split < testBuffSize)
+        {
+            RETURN_VAL_ON_FAIL((status == Decoder::DECODER_STATUS_MORE_DATA), false);
+            RETURN_VAL_ON_FAIL((consumed == split), false);
+            status = decoder.Feed(
+                    testBuffer + split, testBuffSize - split,
+                    outBuffer + outSize, sizeof(outBuffer) - outSize,
+                    &consumed, &produced);
+            outSize += produced;
+        }
+        RETURN_VAL_ON_FAIL((status == Decoder::DECODER_STATUS_FRAME_END), false);
+        RETURN_VAL_ON_FAIL((outSize == refBuffSize), false);
+        RETURN_VAL_ON_FAIL((memcmp(outBuffer, refBuffer, refBuffSize) == 0), false);
+    }
+
+    // two frames in one chunk, decoded in place, then an invalid escape sequence
+    uint8_t streamBuffer[] = {
+            1, PLIS_ESC, PLIS_ESC_END, PLIS_END, PLIS_ESC, PLIS_ESC_ESC, 2, PLIS_END, PLIS_ESC, 0xAA, 3
+    };
+    Decoder decoder;
+    size_t consumed = 0;
+    size_t produced = 0;
+    Decoder::decoder_status_t status = decoder.Feed(
+            streamBuffer, sizeof(streamBuffer), streamBuffer, sizeof(streamBuffer),
+            &consumed, &produced);
+    RETURN_VAL_ON_FAIL((status == Decoder::DECODER_STATUS_FRAME_END), false);
+    RETURN_VAL_ON_FAIL((consumed == 4) && (produced == 2), false);
+    RETURN_VAL_ON_FAIL((streamBuffer[0] == 1) && (streamBuffer[1] == PLIS_END), false);
+    status = decoder.Feed(
+            streamBuffer + 4, sizeof(streamBuffer) - 4, streamBuffer + 4, sizeof(streamBuffer) - 4,
+            &consumed, &produced);
+    RETURN_VAL_ON_FAIL((status == Decoder::DECODER_STATUS_FRAME_END), false);
+    RETURN_VAL_ON_FAIL((consumed == 4) && (produced == 2), false);
+    RETURN_VAL_ON_FAIL((streamBuffer[4] == PLIS_ESC) && (streamBuffer[5] == 2), false);
+    status = decoder.Feed(
+            streamBuffer + 8, sizeof(streamBuffer) - 8, streamBuffer + 8, sizeof(streamBuffer) - 8,
+            &consumed, &produced);
+    RETURN_VAL_ON_FAIL((status == Decoder::DECODER_STATUS_ERROR), false);
+    RETURN_VAL_ON_FAIL((consumed == 2) && (produced == 0), false);
+
     return true;
 }
@@ -26,14 +26,10 @@
 
 #include <string.h>
 
-#include "rs232/rs232.h"
-
 #include "serial/Serial.hpp"
 
 using namespace std;
 
-constexpr const char* Serial::portnames_h[maxSysComPorts];
-
 Serial::Serial(void):
         initOk(false)
 {
@@ -50,10 +46,7 @@ Serial::~Serial(void)
 
 ec_t Serial::Init(void)
 {
-    _isComPortOpened = false;
     portComName = defaultComPortName;
-    portComNum = GetComPortNumFromName(portComName);
-    RETURN_VAL_ON_FAIL(portComNum != -1, EC_FAIL);
     baudRate_str = defaultBaudRate;
     baudRate_val = GetBaudRateFromName(baudRate_str);
     RETURN_VAL_ON_FAIL(baudRate_val != -1, EC_FAIL);
@@ -101,63 +94,81 @@ const char* Serial::GetComPort(void)
     return portComName;
 }
 
-int Serial::GetComPortNumFromName(const char* portname)
-{
-    RETURN_VAL_ON_FAIL(portname != NULL, -1);
-    return RS232_GetPortnr(portname);
-}
-
 ec_t Serial::TestComPort(void)
 {
     RETURN_VAL_ON_FAIL(initOk, EC_FAIL);
-    ec_t ec = EC_FAIL;
-    if(RS232_OpenComport(portComNum, 115200, "8n1", 0) == 0)
-    {
-        RS232_CloseComport(portComNum);
-        ec = EC_OK;
-    }
+    return IsPortUsable(portComName) ? EC_OK : EC_FAIL;
+}
 
-    return ec;
+bool Serial::IsPortUsable(const char* portname)
+{
+    SerialPort testPort;
+    return (testPort.Open(portname, 115200, "8n1") == EC_OK);
 }
 
 void Serial::ListComPorts(void)
 {
-    uint8_t cp_found = 0;
+    vector<SerialPortList::port_info_t> ports = SerialPortList::Get();
 
     printf("Listing serial ports detected on this machine:\n");
 
-    for(uint8_t i = 0; i < maxSysComPorts; i++)
+    for(size_t i = 0; i < ports.size(); i++)
     {
-        int port_num = GetComPortNumFromName(portnames_h[i]);
-        if(port_num == -1)
+        const SerialPortList::port_info_t& port = ports[i];
+        printf("* %s", port.name.c_str());
+        if(!port.driver.empty())
         {
-            printf("Error! Failed to list serial portnames. \n");
-            break;
+            printf(" [%s]", port.driver.c_str());
         }
-        if(RS232_OpenComport(port_num, 115200, "8n1", 0) == 0)
+        if(port.vid != 0)
         {
-            printf("* %s\n",portnames_h[i]);
-            RS232_CloseComport(port_num);
-            cp_found++;
+            printf(" %s", SerialPortList::GetUsbId(port).c_str());
+        }
+        if(!port.product.empty())
+        {
+            printf(" %s", port.product.c_str());
+        }
+        if(!port.serial.empty())
+        {
+            printf(" SN:%s", port.serial.c_str());
+        }
+        printf("\n");
+        if(!port.byIdPath.empty())
+        {
+            printf("  %s\n", port.byIdPath.c_str());
         }
     }
-    printf("Total serial ports found: %d. \n\n", cp_found);
+    printf("Total serial ports found: %d. \n\n", static_cast<int>(ports.size()));
 
     return;
 }
 
+size_t Serial::FindComPorts(const char* pattern, std::vector<std::string>& ports)
+{
+    RETURN_VAL_ON_FAIL(pattern != NULL, 0);
+
+    vector<SerialPortList::port_info_t> found;
+    SerialPortList::Find(pattern, found);
+    for(size_t i = 0; i < found.size(); i++)
+    {
+        ports.push_back(found[i].name);
+    }
+
+    return found.size();
+}
+
 ec_t Serial::SetComPort(const char* portname)
 {
     RETURN_VAL_ON_FAIL(initOk, EC_FAIL);
     RETURN_VAL_ON_FAIL(portComName != NULL, EC_FAIL);
 
+    RETURN_VAL_ON_FAIL(!port.IsOpened(), EC_FAIL);
+
     ec_t ec = EC_OK;
 
-    int portnum = GetComPortNumFromName(portname);
-    if(portnum != -1)
+    if(!SerialPort::GetDevicePath(portname).empty())
     {
         portComName = portname;
-        portComNum = portnum;
     }
     else
     {
@@ -170,29 +181,26 @@ ec_t Serial::SetComPort(const char* portname)
 ec_t Serial::OpenComPort(void)
 {
     RETURN_VAL_ON_FAIL(initOk, EC_FAIL);
-    RETURN_VAL_ON_FAIL(!_isComPortOpened, EC_OK);
+    RETURN_VAL_ON_FAIL(!port.IsOpened(), EC_OK);
 
-    if(RS232_OpenComport(portComNum, baudRate_val, dataMode, 0) != 0)
-    {
-        return EC_FAIL;
-    }
-    else
-    {
-        _isComPortOpened = true;
-        return EC_OK;
-    }
+    return port.Open(portComName, baudRate_val, dataMode);
 }
 
 void Serial::CloseComPort(void)
 {
     RETURN_VOID_ON_FAIL(initOk);
-    RS232_CloseComport(portComNum);
-    _isComPortOpened = false;
+    port.Close();
 }
 
 bool Serial::isComPortOpened(void)
 {
-    return _isComPortOpened;
+    return port.IsOpened();
+}
+
+int Serial::GetFd(void)
+{
+    RETURN_VAL_ON_FAIL(initOk, -1);
+    return port.GetFd();
 }
 
 int Serial::DumpBuffToPort(unsigned char* buff, unsigned int buff_size)
@@ -200,27 +208,27 @@ int Serial::DumpBuffToPort(unsigned char* buff, unsigned int buff_size)
     RETURN_VAL_ON_FAIL(initOk, -1);
     RETURN_VAL_ON_FAIL(buff != NULL, -1);
     RETURN_VAL_ON_FAIL(buff_size > 0, -1);
-    RETURN_VAL_ON_FAIL(_isComPortOpened, -1);
-
-    int n = RS232_SendBuf(portComNum, buff, buff_size);
-    RS232_flushTX(portComNum);
-
-    return n;
+    RETURN_VAL_ON_FAIL(port.IsOpened(), -1);
+
+    /*
+     * Data is left in the OS output buffer to be transmitted.
+     * SerialPort::FlushTX() would discard whatever is not on the wire yet,
+     * which truncates requests sent back-to-back (pipelined).
+     */
+    return port.Write(buff, buff_size);
 }
 
 int Serial::DumpStrToPort(const unsigned char* txt)
 {
     RETURN_VAL_ON_FAIL(initOk, -1);
     RETURN_VAL_ON_FAIL(txt != NULL, -1);
-    RETURN_VAL_ON_FAIL(_isComPortOpened, -1);
+    RETURN_VAL_ON_FAIL(port.IsOpened(), -1);
 
     int bt_cnt = 0;
 
     while(*txt != '\0')
     {
-        int n = RS232_SendByte(
-                portComNum,
-                static_cast<unsigned char>(*(txt++)));
+        int n = port.WriteByte(static_cast<uint8_t>(*(txt++)));
         if((n < 0) && (bt_cnt == 0))
         {
             bt_cnt = -1;
@@ -236,17 +244,15 @@ int Serial::DumpStrToPort(const unsigned char* txt)
         }
     }
 
-    RS232_flushTX(portComNum);
-
     return bt_cnt;
 }
 
 ec_t Serial::FlushRX(void)
 {
     RETURN_VAL_ON_FAIL(initOk, EC_FAIL);
-    RETURN_VAL_ON_FAIL(_isComPortOpened, EC_FAIL);
+    RETURN_VAL_ON_FAIL(port.IsOpened(), EC_FAIL);
 
-    RS232_flushRX(portComNum);
+    port.FlushRX();
 
     return EC_OK;
 }
@@ -255,29 +261,28 @@ int Serial::ReadDataFromPort(unsigned char* buff)
 {
     RETURN_VAL_ON_FAIL(initOk, -1);
     RETURN_VAL_ON_FAIL((buff != NULL), -1);
-    RETURN_VAL_ON_FAIL(_isComPortOpened, -1);
-
-    int n = RS232_PollComport(portComNum, rcvBuff, rcvBuffSize);
-    RETURN_VAL_ON_FAIL(n > 0, n);
-
-    memcpy(buff, rcvBuff, static_cast<size_t>(n));
+    RETURN_VAL_ON_FAIL(port.IsOpened(), -1);
 
-    return n;
+    return port.Read(buff, rcvBuffSize);
 }
 
 int Serial::ReadDataFromPort(unsigned char* buff, unsigned int max)
 {
     RETURN_VAL_ON_FAIL(initOk, -1);
     RETURN_VAL_ON_FAIL((buff != NULL), -1);
-    RETURN_VAL_ON_FAIL(_isComPortOpened, -1);
+    RETURN_VAL_ON_FAIL(port.IsOpened(), -1);
     RETURN_VAL_ON_FAIL(max <= rcvBuffSize, -1);
 
-    int n = RS232_PollComport(portComNum, rcvBuff, max);
-    RETURN_VAL_ON_FAIL(n > 0, n);
+    return port.Read(buff, max);
+}
 
-    memcpy(buff, rcvBuff, static_cast<size_t>(n));
+int Serial::ReadDataFromPort(unsigned char* buff, unsigned int max, uint32_t timeoutMs)
+{
+    RETURN_VAL_ON_FAIL(initOk, -1);
+    RETURN_VAL_ON_FAIL((buff != NULL), -1);
+    RETURN_VAL_ON_FAIL(port.IsOpened(), -1);
 
-    return n;
+    return port.Read(buff, max, timeoutMs);
 }
 
 ec_t Serial::TestSerial1(void)
@@ -289,13 +294,14 @@ ec_t Serial::TestSerial1(void)
     unsigned char test_msg[] = "This is the SerialTestTool here! :)\n";
     int data_sent = DumpStrToPort(test_msg);
 
-    printf("Polling for RX...\n");
-    int data_rcv = 0;
+    printf("Waiting for RX...\n");
     unsigned char rcv_buff[4096] = {0};
-    do
+    // sleeps in the OS until data arrives, instead of spinning on the port
+    int data_rcv = ReadDataFromPort(rcv_buff, (sizeof(rcv_buff) - 1), testRxTimeoutMs);
+    if(data_rcv == 0)
     {
-        data_rcv = ReadDataFromPort(rcv_buff);
-    }while(data_rcv == 0);
+        printf("No RX within %u ms.\n", testRxTimeoutMs);
+    }
 
     printf("Data sent: %d\n", data_sent);
     printf("Data rcv: %d\n", data_rcv);
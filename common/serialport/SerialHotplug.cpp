@@ -0,0 +1,478 @@
+/*
+***************************************************************************
+*
+* Author: alf64
+*
+* Copyright (C) 2019 alf64
+*
+* Email: alf64gordon@gmail.com
+*
+***************************************************************************
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* See <http://www.gnu.org/licenses/>.
+*
+***************************************************************************
+*/
+
+#include <errno.h>
+#include <string.h>
+
+#if defined(__linux__)
+#include <dirent.h>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/eventfd.h>
+#include <sys/inotify.h>
+#include <sys/socket.h>
+#include <linux/netlink.h>
+#endif
+
+#include "serialport/SerialHotplug.hpp"
+#include "serialport/SerialPortList.hpp"
+
+using namespace std;
+
+#if defined(__linux__)
+
+static const uint32_t inotifyAddMask = IN_CREATE | IN_MOVED_TO;
+static const uint32_t inotifyRemoveMask = IN_DELETE | IN_MOVED_FROM;
+static const uint32_t inotifyAncestorMask = IN_CREATE | IN_MOVED_TO | IN_ONLYDIR;
+
+static string DirName(const string& path)
+{
+    size_t slash = path.find_last_of('/');
+    return ((slash == string::npos) || (slash == 0)) ? string("/") : path.substr(0, slash);
+}
+
+SerialHotplug::SerialHotplug(void):
+        fd(-1),
+        dirWd(-1),
+        ancestorWd(-1),
+        wakeFd(-1),
+        netlink(false)
+{
+    wakeFd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+}
+
+SerialHotplug::~SerialHotplug(void)
+{
+    Stop();
+    if(wakeFd != -1)
+    {
+        close(wakeFd);
+    }
+}
+
+bool SerialHotplug::IsSupported(void)
+{
+    return true;
+}
+
+ec_t SerialHotplug::Start(const char* pattern)
+{
+    RETURN_VAL_ON_FAIL(pattern != NULL, EC_FAIL);
+    RETURN_VAL_ON_FAIL(wakeFd != -1, EC_FAIL);
+
+    Stop();
+    this->pattern = pattern;
+
+    const char* slash = strrchr(pattern, '/');
+    if(slash != NULL)
+    {
+        // device path pattern, wildcards are allowed in the file name only
+        dir = (slash == pattern) ? string("/") : string(pattern, slash - pattern);
+        RETURN_VAL_ON_FAIL(dir.find_first_of("*?") == string::npos, EC_FAIL);
+    }
+    else
+    {
+        fd = socket(AF_NETLINK, SOCK_DGRAM | SOCK_CLOEXEC | SOCK_NONBLOCK, NETLINK_KOBJECT_UEVENT);
+        if(fd != -1)
+        {
+            struct sockaddr_nl addr = {};
+            addr.nl_family = AF_NETLINK;
+            addr.nl_groups = 1; // kernel uevents
+            if(bind(fd, reinterpret_cast<struct sockaddr*>(&addr), sizeof(addr)) == 0)
+            {
+                netlink = true;
+            }
+            else
+            {
+                close(fd);
+                fd = -1;
+            }
+        }
+    }
+
+    if(!netlink)
+    {
+        fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+        RETURN_VAL_ON_FAIL(fd != -1, EC_FAIL);
+        if(WatchDir() != EC_OK)
+        {
+            Stop();
+            return EC_FAIL;
+        }
+    }
+
+    Scan(pending);
+
+    return EC_OK;
+}
+
+void SerialHotplug::Stop(void)
+{
+    if(fd != -1)
+    {
+        close(fd);
+        fd = -1;
+    }
+    dirWd = -1;
+    ancestorWd = -1;
+    netlink = false;
+    dir.clear();
+    present.clear();
+    pending.clear();
+}
+
+const char* SerialHotplug::GetSource(void)
+{
+    RETURN_VAL_ON_FAIL(fd != -1, "none");
+    return netlink ? "netlink" : "inotify";
+}
+
+ec_t SerialHotplug::Wait(std::vector<event_t>& events, uint32_t timeoutMs)
+{
+    RETURN_VAL_ON_FAIL(fd != -1, EC_FAIL);
+
+    if(!pending.empty())
+    {
+        events.insert(events.end(), pending.begin(), pending.end());
+        pending.clear();
+        return EC_OK;
+    }
+
+    struct pollfd fds[2];
+    fds[0].fd = fd;
+    fds[0].events = POLLIN;
+    fds[1].fd = wakeFd;
+    fds[1].events = POLLIN;
+    int n = poll(fds, 2, static_cast<int>(timeoutMs));
+    if(n < 0)
+    {
+        return (errno == EINTR) ? EC_OK : EC_FAIL;
+    }
+
+    if(fds[1].revents & POLLIN)
+    {
+        uint64_t count;
+        ssize_t r = read(wakeFd, &count, sizeof(count));
+        UNUSED(r);
+    }
+    if(fds[0].revents & POLLIN)
+    {
+        if(netlink)
+        {
+            ReadNetlink(events);
+        }
+        else
+        {
+            ReadInotify(events);
+        }
+    }
+
+    return EC_OK;
+}
+
+void SerialHotplug::Interrupt(void)
+{
+    uint64_t one = 1;
+    ssize_t r = write(wakeFd, &one, sizeof(one));
+    UNUSED(r);
+}
+
+bool SerialHotplug::Matches(const std::string& port)
+{
+    if(!dir.empty())
+    {
+        return SerialPortList::MatchPattern(pattern.c_str(), port.c_str());
+    }
+
+    if(SerialPortList::MatchPattern(pattern.c_str(), port.c_str()) ||
+       SerialPortList::MatchPattern(pattern.c_str(), (string("/dev/") + port).c_str()))
+    {
+        return true;
+    }
+
+    // by-id alias or USB vid:pid
+    vector<SerialPortList::port_info_t> found;
+    SerialPortList::Find(pattern.c_str(), found);
+    for(size_t i = 0; i < found.size(); i++)
+    {
+        if(found[i].name == port)
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void SerialHotplug::Update(change_t change, const std::string& port, std::vector<event_t>& events)
+{
+    bool changed = (change == PORT_ADDED) ? present.insert(port).second : (present.erase(port) > 0);
+    if(changed)
+    {
+        event_t event;
+        event.change = change;
+        event.port = port;
+        events.push_back(event);
+    }
+}
+
+void SerialHotplug::Scan(std::vector<event_t>& events)
+{
+    if(dir.empty())
+    {
+        SerialPortList::Refresh();
+        vector<SerialPortList::port_info_t> found;
+        SerialPortList::Find(pattern.c_str(), found);
+        for(size_t i = 0; i < found.size(); i++)
+        {
+            Update(PORT_ADDED, found[i].name, events);
+        }
+        return;
+    }
+
+    DIR* d = opendir(dir.c_str());
+    RETURN_VOID_ON_FAIL(d != NULL);
+    struct dirent* entry;
+    while((entry = readdir(d)) != NULL)
+    {
+        if(entry->d_name[0] == '.')
+        {
+            continue;
+        }
+        string path = ((dir == "/") ? string() : dir) + "/" + entry->d_name;
+        if(Matches(path))
+        {
+            Update(PORT_ADDED, path, events);
+        }
+    }
+    closedir(d);
+}
+
+ec_t SerialHotplug::WatchDir(void)
+{
+    RETURN_VAL_ON_FAIL(dirWd == -1, EC_OK);
+
+    const string watched = dir.empty() ? string("/dev") : dir;
+    while(true)
+    {
+        string path = watched;
+        string child;
+        int wd;
+        while((wd = inotify_add_watch(fd, path.c_str(),
+                (path == watched) ? (inotifyAddMask | inotifyRemoveMask) : inotifyAncestorMask)) == -1)
+        {
+            RETURN_VAL_ON_FAIL(((errno == ENOENT) || (errno == ENOTDIR)) && (path != "/"), EC_FAIL);
+            child = path;
+            path = DirName(path);
+        }
+
+        if((ancestorWd != -1) && (ancestorWd != wd))
+        {
+            inotify_rm_watch(fd, ancestorWd);
+            ancestorWd = -1;
+        }
+        if(path == watched)
+        {
+            dirWd = wd;
+            return EC_OK;
+        }
+        ancestorWd = wd;
+
+        // the next directory on the way could appear before its ancestor got watched
+        RETURN_VAL_ON_FAIL(access(child.c_str(), F_OK) == 0, EC_OK);
+    }
+}
+
+void SerialHotplug::ReadNetlink(std::vector<event_t>& events)
+{
+    char buff[recvBuffSize];
+
+    while(true)
+    {
+        struct sockaddr_nl sender = {};
+        struct iovec iov = {buff, sizeof(buff) - 1};
+        struct msghdr msg = {};
+        msg.msg_name = &sender;
+        msg.msg_namelen = sizeof(sender);
+        msg.msg_iov = &iov;
+        msg.msg_iovlen = 1;
+        ssize_t n = recvmsg(fd, &msg, 0);
+        if(n < 0)
+        {
+            // ENOBUFS: uevents were dropped, ports already reported stay as they are
+            BREAK_ON_FAIL(errno == ENOBUFS);
+            continue;
+        }
+        if((n == 0) || (sender.nl_pid != 0)) // kernel messages only
+        {
+            continue;
+        }
+        buff[n] = '\0';
+
+        // "action@devpath\0" followed by "KEY=value\0" pairs
+        const char* action = "";
+        const char* subsystem = "";
+        const char* devname = "";
+        for(const char* field = buff; field < (buff + n); field += strlen(field) + 1)
+        {
+            if(strncmp(field, "ACTION=", 7) == 0)
+            {
+                action = field + 7;
+            }
+            else if(strncmp(field, "SUBSYSTEM=", 10) == 0)
+            {
+                subsystem = field + 10;
+            }
+            else if(strncmp(field, "DEVNAME=", 8) == 0)
+            {
+                devname = field + 8;
+            }
+        }
+        if((strcmp(subsystem, "tty") != 0) || (devname[0] == '\0'))
+        {
+            continue;
+        }
+
+        SerialPortList::Refresh();
+        if((strcmp(action, "add") == 0) && Matches(devname))
+        {
+            Update(PORT_ADDED, devname, events);
+        }
+        else if(strcmp(action, "remove") == 0)
+        {
+            Update(PORT_REMOVED, devname, events);
+        }
+    }
+}
+
+void SerialHotplug::ReadInotify(std::vector<event_t>& events)
+{
+    char buff[recvBuffSize] __attribute__((aligned(__alignof__(struct inotify_event))));
+
+    ssize_t n;
+    while((n = read(fd, buff, sizeof(buff))) > 0)
+    {
+        const struct inotify_event* ev;
+        for(char* p = buff; p < (buff + n); p += sizeof(struct inotify_event) + ev->len)
+        {
+            ev = reinterpret_cast<const struct inotify_event*>(p);
+            if(ev->wd != dirWd)
+            {
+                // ancestor of missing directory, something appeared on the way or the ancestor is gone
+                if((ev->wd == ancestorWd) && (ev->mask & IN_IGNORED))
+                {
+                    ancestorWd = -1;
+                }
+                if((dirWd == -1) && (WatchDir() == EC_OK) && (dirWd != -1))
+                {
+                    Scan(events);
+                }
+                continue;
+            }
+            if(ev->mask & IN_IGNORED)
+            {
+                // directory is gone, its ports with it, watch for it to appear again
+                dirWd = -1;
+                set<string> gone = present;
+                for(set<string>::iterator it = gone.begin(); it != gone.end(); it++)
+                {
+                    Update(PORT_REMOVED, *it, events);
+                }
+                if((WatchDir() == EC_OK) && (dirWd != -1))
+                {
+                    Scan(events);
+                }
+                continue;
+            }
+            if(ev->len == 0)
+            {
+                continue;
+            }
+
+            string port = dir.empty() ? string(ev->name) : (((dir == "/") ? string() : dir) + "/" + ev->name);
+            if(dir.empty())
+            {
+                SerialPortList::Refresh();
+            }
+            if((ev->mask & inotifyAddMask) && Matches(port))
+            {
+                Update(PORT_ADDED, port, events);
+            }
+            else if(ev->mask & inotifyRemoveMask)
+            {
+                Update(PORT_REMOVED, port, events);
+            }
+        }
+    }
+}
+
+#else
+
+SerialHotplug::SerialHotplug(void):
+        fd(-1),
+        dirWd(-1),
+        ancestorWd(-1),
+        wakeFd(-1),
+        netlink(false)
+{
+}
+
+SerialHotplug::~SerialHotplug(void)
+{
+}
+
+bool SerialHotplug::IsSupported(void)
+{
+    return false;
+}
+
+ec_t SerialHotplug::Start(const char* pattern)
+{
+    UNUSED(pattern);
+    return EC_FAIL;
+}
+
+void SerialHotplug::Stop(void)
+{
+}
+
+const char* SerialHotplug::GetSource(void)
+{
+    return "none";
+}
+
+ec_t SerialHotplug::Wait(std::vector<event_t>& events, uint32_t timeoutMs)
+{
+    UNUSED(events);
+    UNUSED(timeoutMs);
+    return EC_FAIL;
+}
+
+void SerialHotplug::Interrupt(void)
+{
+}
+
+#endif
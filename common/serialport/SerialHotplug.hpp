@@ -0,0 +1,140 @@
+/*
+***************************************************************************
+*
+* Author: alf64
+*
+* Copyright (C) 2019 alf64
+*
+* Email: alf64gordon@gmail.com
+*
+***************************************************************************
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* See <http://www.gnu.org/licenses/>.
+*
+***************************************************************************
+*/
+
+#ifndef SERIALPORT_SERIALHOTPLUG_HPP_
+#define SERIALPORT_SERIALHOTPLUG_HPP_
+
+#include <stdint.h>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "ec.h"
+
+/*
+ * Watches for serial ports being plugged in and unplugged.
+ *
+ * Two kinds of patterns are supported (wildcards: '*', '?'):
+ * - port pattern (i.e. ttyUSB*, 0403:6001, see SerialPortList::Find()):
+ *   tty add/remove uevents are received from the kernel (netlink),
+ *   if netlink is not available /dev is watched with inotify instead,
+ * - device path pattern (i.e. /dev/serial/by-id/usb-FTDI*, /tmp/ttyV*):
+ *   directory of the pattern (which must not contain wildcards) is watched with inotify.
+ *   While the directory does not exist (i.e. /dev/serial/by-id with nothing plugged in),
+ *   its nearest existing ancestor is watched until it appears.
+ *   This also catches symlinks to pseudo terminals, i.e. made by socat.
+ *
+ * Supported on Linux only, see IsSupported().
+ */
+class SerialHotplug
+{
+public:
+    typedef enum
+    {
+        PORT_ADDED = 0,
+        PORT_REMOVED = 1
+    }change_t;
+
+    typedef struct
+    {
+        change_t change;
+        std::string port; //!< port name (ttyUSB0) or device path (for device path patterns)
+    }event_t;
+
+    SerialHotplug(void);
+    ~SerialHotplug(void);
+
+    //!< Returns true if hotplug watching is supported on this OS.
+    static bool IsSupported(void);
+
+    /*
+     * @brief Starts watching for ports matching pattern.
+     * @details Matching ports present already are reported as added by the first Wait().
+     * @returns ec_t
+     * @retval EC_OK If started.
+     * @retval EC_FAIL If failed (i.e. directory of device path pattern contains wildcards).
+     */
+    ec_t Start(const char* pattern);
+
+    //!< Stops watching.
+    void Stop(void);
+
+    //!< Returns how changes are watched for: "netlink", "inotify" (or "none" if not started).
+    const char* GetSource(void);
+
+    /*
+     * @brief Waits for changes of matching ports and appends them to events.
+     * @param timeoutMs Maximum time (in milliseconds) to wait.
+     * @returns ec_t
+     * @retval EC_OK If waited (events may be empty on timeout or Interrupt()).
+     * @retval EC_FAIL If failed (i.e. not started).
+     */
+    ec_t Wait(std::vector<event_t>& events, uint32_t timeoutMs);
+
+    //!< Makes Wait() return. May be called from any thread and from a signal handler.
+    void Interrupt(void);
+
+private:
+    static const size_t recvBuffSize = 8192;
+
+    std::string pattern;
+    std::string dir; //!< watched directory of device path pattern, empty for port pattern
+    int fd; //!< netlink or inotify socket, -1 if not started
+    int dirWd; //!< inotify watch of the watched directory, -1 if it does not exist
+    int ancestorWd; //!< inotify watch of nearest existing ancestor of missing directory, -1 if none
+    int wakeFd; //!< wakes Wait() up on Interrupt()
+    bool netlink;
+    std::set<std::string> present; //!< matching ports present now
+    std::vector<event_t> pending; //!< changes found by Start(), reported by the next Wait()
+
+    //!< Returns true if port (name or device path) matches the pattern.
+    bool Matches(const std::string& port);
+
+    //!< Records port change and appends it to events, unless the port is in that state already.
+    void Update(change_t change, const std::string& port, std::vector<event_t>& events);
+
+    //!< Appends matching ports present now to events.
+    void Scan(std::vector<event_t>& events);
+
+    /*
+     * @brief Watches the directory (/dev for port pattern) with inotify.
+     * @details If the directory does not exist, watches its nearest existing ancestor instead,
+     * to be called again when something appears there.
+     * @returns ec_t
+     * @retval EC_OK If the directory or its ancestor is watched.
+     * @retval EC_FAIL If failed.
+     */
+    ec_t WatchDir(void);
+
+    //!< Handles received uevents.
+    void ReadNetlink(std::vector<event_t>& events);
+
+    //!< Handles received inotify events.
+    void ReadInotify(std::vector<event_t>& events);
+};
+
+
+#endif /* SERIALPORT_SERIALHOTPLUG_HPP_ */
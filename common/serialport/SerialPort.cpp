@@ -0,0 +1,726 @@
+/*
+***************************************************************************
+*
+* Author: alf64
+*
+* Copyright (C) 2019 alf64
+*
+* Email: alf64gordon@gmail.com
+*
+***************************************************************************
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* See <http://www.gnu.org/licenses/>.
+*
+***************************************************************************
+*/
+
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+
+#if defined(__linux__) || defined(__FreeBSD__)   /* Linux & FreeBSD */
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/file.h>
+#include <sys/ioctl.h>
+#else
+#include <windows.h>
+#endif
+
+#include "serialport/SerialPort.hpp"
+
+using namespace std;
+
+SerialPort::~SerialPort(void)
+{
+    Close();
+}
+
+bool SerialPort::IsModeValid(const char* mode)
+{
+    RETURN_VAL_ON_FAIL(mode != NULL, false);
+    RETURN_VAL_ON_FAIL(strlen(mode) == 3, false);
+    RETURN_VAL_ON_FAIL(strchr("5678", mode[0]) != NULL, false);
+    RETURN_VAL_ON_FAIL(strchr("nNeEoO", mode[1]) != NULL, false);
+    RETURN_VAL_ON_FAIL(strchr("12", mode[2]) != NULL, false);
+
+    return true;
+}
+
+int SerialPort::GetBitsPerByte(const char* mode)
+{
+    RETURN_VAL_ON_FAIL(IsModeValid(mode), 0);
+
+    // start bit + data bits + parity bit + stop bits
+    int bits = 1 + (mode[0] - '0') + (mode[2] - '0');
+    if(strchr("nN", mode[1]) == NULL)
+    {
+        bits++;
+    }
+
+    return bits;
+}
+
+bool SerialPort::IsOpened(void)
+{
+    return !path.empty();
+}
+
+const std::string& SerialPort::GetPath(void)
+{
+    return path;
+}
+
+int SerialPort::WriteByte(uint8_t byte)
+{
+    return Write(&byte, 1);
+}
+
+#if defined(__linux__) || defined(__FreeBSD__)   /* Linux & FreeBSD */
+
+SerialPort::SerialPort(void):
+        fd(-1)
+{
+    memset(&oldSettings, 0, sizeof(oldSettings));
+}
+
+std::string SerialPort::GetDevicePath(const char* portname)
+{
+    RETURN_VAL_ON_FAIL((portname != NULL) && (portname[0] != '\0'), string());
+
+    if(strchr(portname, '/') != NULL)
+    {
+        return string(portname);
+    }
+
+    return string("/dev/") + portname;
+}
+
+speed_t SerialPort::GetSpeed(int baudrate)
+{
+    switch(baudrate)
+    {
+        case      50: return B50;
+        case      75: return B75;
+        case     110: return B110;
+        case     134: return B134;
+        case     150: return B150;
+        case     200: return B200;
+        case     300: return B300;
+        case     600: return B600;
+        case    1200: return B1200;
+        case    1800: return B1800;
+        case    2400: return B2400;
+        case    4800: return B4800;
+        case    9600: return B9600;
+        case   19200: return B19200;
+        case   38400: return B38400;
+        case   57600: return B57600;
+        case  115200: return B115200;
+        case  230400: return B230400;
+        case  460800: return B460800;
+#if defined(__linux__)
+        case  500000: return B500000;
+        case  576000: return B576000;
+        case  921600: return B921600;
+        case 1000000: return B1000000;
+        case 1152000: return B1152000;
+        case 1500000: return B1500000;
+        case 2000000: return B2000000;
+        case 2500000: return B2500000;
+        case 3000000: return B3000000;
+        case 3500000: return B3500000;
+        case 4000000: return B4000000;
+#endif
+        default: return B0;
+    }
+}
+
+bool SerialPort::IsBaudrateSupported(int baudrate)
+{
+    return (GetSpeed(baudrate) != B0);
+}
+
+bool SerialPort::MakeSettings(int baudrate, const char* mode, bool flowctrl, struct termios& settings)
+{
+    RETURN_VAL_ON_FAIL(IsModeValid(mode), false);
+    speed_t speed = GetSpeed(baudrate);
+    RETURN_VAL_ON_FAIL(speed != B0, false);
+
+    memset(&settings, 0, sizeof(settings));
+    settings.c_cflag = CLOCAL | CREAD;
+    settings.c_iflag = IGNPAR;
+    switch(mode[0])
+    {
+        case '8': settings.c_cflag |= CS8; break;
+        case '7': settings.c_cflag |= CS7; break;
+        case '6': settings.c_cflag |= CS6; break;
+        default: settings.c_cflag |= CS5; break;
+    }
+    if((mode[1] == 'e') || (mode[1] == 'E'))
+    {
+        settings.c_cflag |= PARENB;
+        settings.c_iflag = INPCK;
+    }
+    else if((mode[1] == 'o') || (mode[1] == 'O'))
+    {
+        settings.c_cflag |= (PARENB | PARODD);
+        settings.c_iflag = INPCK;
+    }
+    if(mode[2] == '2')
+    {
+        settings.c_cflag |= CSTOPB;
+    }
+    if(flowctrl)
+    {
+        settings.c_cflag |= CRTSCTS;
+    }
+    // raw mode, read() returns whatever is available right away
+    settings.c_oflag = 0;
+    settings.c_lflag = 0;
+    settings.c_cc[VMIN] = 0;
+    settings.c_cc[VTIME] = 0;
+    cfsetispeed(&settings, speed);
+    cfsetospeed(&settings, speed);
+
+    return true;
+}
+
+ec_t SerialPort::Open(const char* portname, int baudrate, const char* mode, bool flowctrl)
+{
+    RETURN_VAL_ON_FAIL(!IsOpened(), EC_FAIL);
+    struct termios settings;
+    RETURN_VAL_ON_FAIL(MakeSettings(baudrate, mode, flowctrl, settings), EC_FAIL);
+    string devpath = GetDevicePath(portname);
+    RETURN_VAL_ON_FAIL(!devpath.empty(), EC_FAIL);
+
+    int newFd = open(devpath.c_str(), O_RDWR | O_NOCTTY | O_NDELAY | O_CLOEXEC);
+    RETURN_VAL_ON_FAIL(newFd != -1, EC_FAIL);
+
+    // lock access so that another process can't also use the port
+    if(flock(newFd, LOCK_EX | LOCK_NB) != 0)
+    {
+        close(newFd);
+        return EC_FAIL;
+    }
+
+    if(tcgetattr(newFd, &oldSettings) != 0)
+    {
+        flock(newFd, LOCK_UN);
+        close(newFd);
+        return EC_FAIL;
+    }
+
+    if(tcsetattr(newFd, TCSANOW, &settings) != 0)
+    {
+        tcsetattr(newFd, TCSANOW, &oldSettings);
+        flock(newFd, LOCK_UN);
+        close(newFd);
+        return EC_FAIL;
+    }
+
+    fd = newFd;
+    path = devpath;
+
+    /*
+     * Ports without modem lines (pseudo terminals, some USB CDC devices)
+     * reject modem control requests, they are usable anyway.
+     */
+    if(!SetModemLines(TIOCM_DTR | TIOCM_RTS, true) && (errno != ENOTTY) && (errno != EINVAL))
+    {
+        Close();
+        return EC_FAIL;
+    }
+
+    return EC_OK;
+}
+
+ec_t SerialPort::Configure(int baudrate, const char* mode, bool flowctrl)
+{
+    RETURN_VAL_ON_FAIL(IsOpened(), EC_FAIL);
+    struct termios settings;
+    RETURN_VAL_ON_FAIL(MakeSettings(baudrate, mode, flowctrl, settings), EC_FAIL);
+    RETURN_VAL_ON_FAIL(tcsetattr(fd, TCSADRAIN, &settings) == 0, EC_FAIL);
+
+    return EC_OK;
+}
+
+void SerialPort::Close(void)
+{
+    RETURN_VOID_ON_FAIL(IsOpened());
+
+    SetModemLines(TIOCM_DTR | TIOCM_RTS, false);
+    tcsetattr(fd, TCSANOW, &oldSettings);
+    flock(fd, LOCK_UN);
+    close(fd);
+    fd = -1;
+    path.clear();
+}
+
+int SerialPort::GetFd(void)
+{
+    return fd;
+}
+
+int SerialPort::Read(uint8_t* buf, size_t size)
+{
+    RETURN_VAL_ON_FAIL(IsOpened(), -1);
+    RETURN_VAL_ON_FAIL(buf != NULL, -1);
+
+    ssize_t n = read(fd, buf, size);
+    if(n < 0)
+    {
+        return ((errno == EAGAIN) || (errno == EINTR)) ? 0 : -1;
+    }
+
+    return static_cast<int>(n);
+}
+
+int SerialPort::Read(uint8_t* buf, size_t size, uint32_t timeoutMs)
+{
+    RETURN_VAL_ON_FAIL(IsOpened(), -1);
+    RETURN_VAL_ON_FAIL(buf != NULL, -1);
+
+    struct pollfd pfd;
+    pfd.fd = fd;
+    pfd.events = POLLIN;
+    pfd.revents = 0;
+
+    int n = poll(&pfd, 1, static_cast<int>(timeoutMs));
+    if(n < 0)
+    {
+        return (errno == EINTR) ? 0 : -1;
+    }
+    RETURN_VAL_ON_FAIL(n > 0, 0); // timeout expired, nothing received
+
+    return Read(buf, size);
+}
+
+int SerialPort::Write(const uint8_t* buf, size_t size)
+{
+    RETURN_VAL_ON_FAIL(IsOpened(), -1);
+    RETURN_VAL_ON_FAIL(buf != NULL, -1);
+
+    ssize_t n = write(fd, buf, size);
+    if(n < 0)
+    {
+        return ((errno == EAGAIN) || (errno == EINTR)) ? 0 : -1;
+    }
+
+    return static_cast<int>(n);
+}
+
+bool SerialPort::SetModemLines(int mask, bool enable)
+{
+    int status = 0;
+    RETURN_VAL_ON_FAIL(ioctl(fd, TIOCMGET, &status) != -1, false);
+
+    if(enable)
+    {
+        status |= mask;
+    }
+    else
+    {
+        status &= ~mask;
+    }
+
+    return (ioctl(fd, TIOCMSET, &status) != -1);
+}
+
+bool SerialPort::GetModemLines(int mask)
+{
+    RETURN_VAL_ON_FAIL(IsOpened(), false);
+
+    int status = 0;
+    RETURN_VAL_ON_FAIL(ioctl(fd, TIOCMGET, &status) != -1, false);
+
+    return ((status & mask) != 0);
+}
+
+bool SerialPort::IsDCDEnabled(void)
+{
+    return GetModemLines(TIOCM_CAR);
+}
+
+bool SerialPort::IsRINGEnabled(void)
+{
+    return GetModemLines(TIOCM_RNG);
+}
+
+bool SerialPort::IsCTSEnabled(void)
+{
+    return GetModemLines(TIOCM_CTS);
+}
+
+bool SerialPort::IsDSREnabled(void)
+{
+    return GetModemLines(TIOCM_DSR);
+}
+
+void SerialPort::SetDTR(bool enable)
+{
+    RETURN_VOID_ON_FAIL(IsOpened());
+    SetModemLines(TIOCM_DTR, enable);
+}
+
+void SerialPort::SetRTS(bool enable)
+{
+    RETURN_VOID_ON_FAIL(IsOpened());
+    SetModemLines(TIOCM_RTS, enable);
+}
+
+void SerialPort::FlushRX(void)
+{
+    RETURN_VOID_ON_FAIL(IsOpened());
+    tcflush(fd, TCIFLUSH);
+}
+
+void SerialPort::FlushTX(void)
+{
+    RETURN_VOID_ON_FAIL(IsOpened());
+    tcflush(fd, TCOFLUSH);
+}
+
+void SerialPort::FlushRXTX(void)
+{
+    RETURN_VOID_ON_FAIL(IsOpened());
+    tcflush(fd, TCIOFLUSH);
+}
+
+ec_t SerialPort::WaitWritable(uint32_t timeoutMs)
+{
+    RETURN_VAL_ON_FAIL(IsOpened(), EC_FAIL);
+
+    struct pollfd pfd;
+    pfd.fd = fd;
+    pfd.events = POLLOUT;
+    pfd.revents = 0;
+
+    // hang up and errors are reported by the next Write()
+    int n = poll(&pfd, 1, static_cast<int>(timeoutMs));
+    RETURN_VAL_ON_FAIL((n >= 0) || (errno == EINTR), EC_FAIL);
+
+    return EC_OK;
+}
+
+int SerialPort::GetTxQueued(void)
+{
+    RETURN_VAL_ON_FAIL(IsOpened(), -1);
+
+    int queued = 0;
+    RETURN_VAL_ON_FAIL(ioctl(fd, TIOCOUTQ, &queued) == 0, -1);
+
+    return queued;
+}
+
+ec_t SerialPort::Drain(void)
+{
+    RETURN_VAL_ON_FAIL(IsOpened(), EC_FAIL);
+
+    int ec;
+    while(((ec = tcdrain(fd)) != 0) && (errno == EINTR))
+    {
+    }
+
+    return (ec == 0) ? EC_OK : EC_FAIL;
+}
+
+#else  /* windows */
+
+SerialPort::SerialPort(void):
+        handle(INVALID_HANDLE_VALUE)
+{
+}
+
+std::string SerialPort::GetDevicePath(const char* portname)
+{
+    RETURN_VAL_ON_FAIL((portname != NULL) && (portname[0] != '\0'), string());
+
+    if((strchr(portname, '\\') != NULL) || (strchr(portname, '/') != NULL))
+    {
+        return string(portname);
+    }
+
+    return string("\\\\.\\") + portname;
+}
+
+bool SerialPort::IsBaudrateSupported(int baudrate)
+{
+    static const int baudrates[] = {
+            110, 300, 600, 1200, 2400, 4800, 9600, 19200, 38400, 57600, 115200,
+            128000, 256000, 500000, 921600, 1000000, 1500000, 2000000, 3000000
+    };
+
+    for(size_t i = 0; i < ARRAY_LENGTH(baudrates); i++)
+    {
+        if(baudrates[i] == baudrate)
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+ec_t SerialPort::Open(const char* portname, int baudrate, const char* mode, bool flowctrl)
+{
+    RETURN_VAL_ON_FAIL(!IsOpened(), EC_FAIL);
+    RETURN_VAL_ON_FAIL(IsModeValid(mode), EC_FAIL);
+    RETURN_VAL_ON_FAIL(IsBaudrateSupported(baudrate), EC_FAIL);
+    string devpath = GetDevicePath(portname);
+    RETURN_VAL_ON_FAIL(!devpath.empty(), EC_FAIL);
+
+    HANDLE h = CreateFileA(devpath.c_str(),
+            GENERIC_READ | GENERIC_WRITE,
+            0,              /* no share */
+            NULL,           /* no security */
+            OPEN_EXISTING,
+            0,              /* no threads */
+            NULL);          /* no templates */
+    RETURN_VAL_ON_FAIL(h != INVALID_HANDLE_VALUE, EC_FAIL);
+
+    if(!ApplySettings(h, baudrate, mode, flowctrl))
+    {
+        CloseHandle(h);
+        return EC_FAIL;
+    }
+
+    // reads return right away with whatever is available
+    COMMTIMEOUTS timeouts;
+    timeouts.ReadIntervalTimeout = MAXDWORD;
+    timeouts.ReadTotalTimeoutMultiplier = 0;
+    timeouts.ReadTotalTimeoutConstant = 0;
+    timeouts.WriteTotalTimeoutMultiplier = 0;
+    timeouts.WriteTotalTimeoutConstant = 0;
+    if(!SetCommTimeouts(h, &timeouts))
+    {
+        CloseHandle(h);
+        return EC_FAIL;
+    }
+
+    handle = h;
+    path = devpath;
+
+    return EC_OK;
+}
+
+bool SerialPort::ApplySettings(void* h, int baudrate, const char* mode, bool flowctrl)
+{
+    /*
+     * http://msdn.microsoft.com/en-us/library/windows/desktop/aa363145%28v=vs.85%29.aspx
+     * https://docs.microsoft.com/en-us/windows/desktop/api/winbase/ns-winbase-_dcb
+     */
+    char mode_str[128];
+    snprintf(mode_str, sizeof(mode_str),
+            "baud=%d data=%c parity=%c stop=%c xon=off to=off odsr=off dtr=on rts=%s",
+            baudrate, mode[0], mode[1], mode[2], flowctrl ? "off" : "on");
+
+    DCB settings;
+    memset(&settings, 0, sizeof(settings));
+    settings.DCBlength = sizeof(settings);
+    RETURN_VAL_ON_FAIL(BuildCommDCBA(mode_str, &settings), false);
+    if(flowctrl)
+    {
+        settings.fOutxCtsFlow = TRUE;
+        settings.fRtsControl = RTS_CONTROL_HANDSHAKE;
+    }
+    RETURN_VAL_ON_FAIL(SetCommState(static_cast<HANDLE>(h), &settings), false);
+
+    return true;
+}
+
+ec_t SerialPort::Configure(int baudrate, const char* mode, bool flowctrl)
+{
+    RETURN_VAL_ON_FAIL(IsOpened(), EC_FAIL);
+    RETURN_VAL_ON_FAIL(IsModeValid(mode), EC_FAIL);
+    RETURN_VAL_ON_FAIL(IsBaudrateSupported(baudrate), EC_FAIL);
+    // data written with the previous settings is transmitted first
+    RETURN_VAL_ON_FAIL(FlushFileBuffers(static_cast<HANDLE>(handle)), EC_FAIL);
+    RETURN_VAL_ON_FAIL(ApplySettings(handle, baudrate, mode, flowctrl), EC_FAIL);
+
+    return EC_OK;
+}
+
+void SerialPort::Close(void)
+{
+    RETURN_VOID_ON_FAIL(IsOpened());
+
+    CloseHandle(static_cast<HANDLE>(handle));
+    handle = INVALID_HANDLE_VALUE;
+    path.clear();
+}
+
+int SerialPort::GetFd(void)
+{
+    return -1; // no pollable file descriptor behind a HANDLE
+}
+
+int SerialPort::Read(uint8_t* buf, size_t size)
+{
+    RETURN_VAL_ON_FAIL(IsOpened(), -1);
+    RETURN_VAL_ON_FAIL(buf != NULL, -1);
+
+    DWORD n = 0;
+    RETURN_VAL_ON_FAIL(ReadFile(static_cast<HANDLE>(handle), buf, static_cast<DWORD>(size), &n, NULL), -1);
+
+    return static_cast<int>(n);
+}
+
+int SerialPort::Read(uint8_t* buf, size_t size, uint32_t timeoutMs)
+{
+    RETURN_VAL_ON_FAIL(IsOpened(), -1);
+    RETURN_VAL_ON_FAIL(buf != NULL, -1);
+
+    if(timeoutMs == 0)
+    {
+        return Read(buf, size);
+    }
+
+    /*
+     * ReadIntervalTimeout and ReadTotalTimeoutMultiplier both set to MAXDWORD make ReadFile()
+     * return as soon as any byte arrives, or after ReadTotalTimeoutConstant if nothing does.
+     */
+    HANDLE h = static_cast<HANDLE>(handle);
+    COMMTIMEOUTS timeouts;
+    timeouts.ReadIntervalTimeout = MAXDWORD;
+    timeouts.ReadTotalTimeoutMultiplier = MAXDWORD;
+    timeouts.ReadTotalTimeoutConstant = static_cast<DWORD>(timeoutMs);
+    timeouts.WriteTotalTimeoutMultiplier = 0;
+    timeouts.WriteTotalTimeoutConstant = 0;
+    RETURN_VAL_ON_FAIL(SetCommTimeouts(h, &timeouts), -1);
+
+    DWORD n = 0;
+    int ret = ReadFile(h, buf, static_cast<DWORD>(size), &n, NULL) ? static_cast<int>(n) : -1;
+
+    // restore the non-blocking behaviour Read(buf, size) relies on
+    timeouts.ReadTotalTimeoutMultiplier = 0;
+    timeouts.ReadTotalTimeoutConstant = 0;
+    SetCommTimeouts(h, &timeouts);
+
+    return ret;
+}
+
+int SerialPort::Write(const uint8_t* buf, size_t size)
+{
+    RETURN_VAL_ON_FAIL(IsOpened(), -1);
+    RETURN_VAL_ON_FAIL(buf != NULL, -1);
+
+    DWORD n = 0;
+    RETURN_VAL_ON_FAIL(WriteFile(static_cast<HANDLE>(handle), buf, static_cast<DWORD>(size), &n, NULL), -1);
+
+    return static_cast<int>(n);
+}
+
+/*
+ * http://msdn.microsoft.com/en-us/library/windows/desktop/aa363258%28v=vs.85%29.aspx
+ */
+bool SerialPort::GetModemStatus(unsigned long mask)
+{
+    RETURN_VAL_ON_FAIL(IsOpened(), false);
+
+    DWORD status = 0;
+    RETURN_VAL_ON_FAIL(GetCommModemStatus(static_cast<HANDLE>(handle), &status), false);
+
+    return ((status & mask) != 0);
+}
+
+bool SerialPort::IsDCDEnabled(void)
+{
+    return GetModemStatus(MS_RLSD_ON);
+}
+
+bool SerialPort::IsRINGEnabled(void)
+{
+    return GetModemStatus(MS_RING_ON);
+}
+
+bool SerialPort::IsCTSEnabled(void)
+{
+    return GetModemStatus(MS_CTS_ON);
+}
+
+bool SerialPort::IsDSREnabled(void)
+{
+    return GetModemStatus(MS_DSR_ON);
+}
+
+/*
+ * http://msdn.microsoft.com/en-us/library/windows/desktop/aa363254%28v=vs.85%29.aspx
+ */
+void SerialPort::EscapeFunction(unsigned long function)
+{
+    RETURN_VOID_ON_FAIL(IsOpened());
+    EscapeCommFunction(static_cast<HANDLE>(handle), function);
+}
+
+void SerialPort::SetDTR(bool enable)
+{
+    EscapeFunction(enable ? SETDTR : CLRDTR);
+}
+
+void SerialPort::SetRTS(bool enable)
+{
+    EscapeFunction(enable ? SETRTS : CLRRTS);
+}
+
+/*
+ * https://msdn.microsoft.com/en-us/library/windows/desktop/aa363428%28v=vs.85%29.aspx
+ */
+void SerialPort::FlushRX(void)
+{
+    RETURN_VOID_ON_FAIL(IsOpened());
+    PurgeComm(static_cast<HANDLE>(handle), PURGE_RXCLEAR | PURGE_RXABORT);
+}
+
+void SerialPort::FlushTX(void)
+{
+    RETURN_VOID_ON_FAIL(IsOpened());
+    PurgeComm(static_cast<HANDLE>(handle), PURGE_TXCLEAR | PURGE_TXABORT);
+}
+
+void SerialPort::FlushRXTX(void)
+{
+    RETURN_VOID_ON_FAIL(IsOpened());
+    PurgeComm(static_cast<HANDLE>(handle), PURGE_RXCLEAR | PURGE_RXABORT | PURGE_TXCLEAR | PURGE_TXABORT);
+}
+
+ec_t SerialPort::WaitWritable(uint32_t timeoutMs)
+{
+    RETURN_VAL_ON_FAIL(IsOpened(), EC_FAIL);
+    UNUSED(timeoutMs);
+
+    // WriteFile() waits for room itself
+    return EC_OK;
+}
+
+int SerialPort::GetTxQueued(void)
+{
+    RETURN_VAL_ON_FAIL(IsOpened(), -1);
+
+    DWORD errors = 0;
+    COMSTAT stat;
+    RETURN_VAL_ON_FAIL(ClearCommError(static_cast<HANDLE>(handle), &errors, &stat), -1);
+
+    return static_cast<int>(stat.cbOutQue);
+}
+
+ec_t SerialPort::Drain(void)
+{
+    RETURN_VAL_ON_FAIL(IsOpened(), EC_FAIL);
+    RETURN_VAL_ON_FAIL(FlushFileBuffers(static_cast<HANDLE>(handle)), EC_FAIL);
+
+    return EC_OK;
+}
+
+#endif
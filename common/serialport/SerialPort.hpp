@@ -0,0 +1,220 @@
+/*
+***************************************************************************
+*
+* Author: alf64
+*
+* Copyright (C) 2019 alf64
+*
+* Email: alf64gordon@gmail.com
+*
+***************************************************************************
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* See <http://www.gnu.org/licenses/>.
+*
+***************************************************************************
+*/
+
+#ifndef SERIALPORT_SERIALPORT_HPP_
+#define SERIALPORT_SERIALPORT_HPP_
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string>
+
+#if defined(__linux__) || defined(__FreeBSD__)   /* Linux & FreeBSD */
+#include <termios.h>
+#endif
+
+#include "ec.h"
+
+/*
+ * Serial port, shared by SerialTestTool and SerialBinaryDumper.
+ *
+ * Each object owns its OS handle (file descriptor) and the port settings
+ * to be restored on close, there is no global state. Different objects
+ * may be used from different threads at the same time,
+ * a single object must not be used by more than one thread at a time.
+ *
+ * Based on the RS-232 library by Teunis van Beelen (http://www.teuniz.net/RS-232/).
+ */
+class SerialPort
+{
+public:
+    SerialPort(void);
+
+    //!< Closes the port, if opened.
+    ~SerialPort(void);
+
+    /*
+     * @brief Returns device path of the port.
+     * @details Port names (i.e. ttyUSB0, COM3) are prefixed with OS device directory
+     * (/dev/ or \\.\), names containing a path separator (i.e. /dev/serial/by-id/...)
+     * are returned unchanged.
+     */
+    static std::string GetDevicePath(const char* portname);
+
+    //!< Returns true if baudrate is supported on this OS.
+    static bool IsBaudrateSupported(int baudrate);
+
+    //!< Returns true if mode is a valid data mode (i.e. 8n1, 7e2).
+    static bool IsModeValid(const char* mode);
+
+    /*
+     * Returns number of bits a byte takes on the wire in given data mode
+     * (start bit, data bits, parity bit, stop bits), i.e. 10 for 8n1, 12 for 8e2.
+     * Returns 0 if mode is invalid.
+     */
+    static int GetBitsPerByte(const char* mode);
+
+    /*
+     * @brief Opens the port.
+     * @details Port is locked for exclusive use (Linux), switched to raw mode,
+     * DTR and RTS lines are turned on. Reads do not block, see Read().
+     * @param portname Port name or device path (see GetDevicePath()).
+     * @param baudrate Baudrate (in bps).
+     * @param mode Data mode, i.e. 8n1.
+     * @param flowctrl Enables RTS/CTS hardware flow control.
+     * @returns ec_t
+     * @retval EC_OK If port opened.
+     * @retval EC_FAIL If failed (i.e. no such port, port used by another process, invalid settings).
+     */
+    ec_t Open(const char* portname, int baudrate, const char* mode, bool flowctrl = false);
+
+    /*
+     * @brief Changes baudrate, data mode and flow control of the opened port, without reopening it.
+     * @details Data written already is transmitted with the previous settings first.
+     * @returns ec_t
+     * @retval EC_OK If changed.
+     * @retval EC_FAIL If failed (i.e. port not opened, invalid settings).
+     */
+    ec_t Configure(int baudrate, const char* mode, bool flowctrl = false);
+
+    //!< Turns DTR and RTS off, restores previous port settings and closes the port.
+    void Close(void);
+
+    //!< Returns true if port is opened.
+    bool IsOpened(void);
+
+    //!< Returns device path of the opened port (empty string if not opened).
+    const std::string& GetPath(void);
+
+    /*
+     * Returns file descriptor of the opened port, to be watched for events (i.e. by SerialReactor).
+     * Returns -1 if port is not opened or the OS does not provide one (Windows).
+     */
+    int GetFd(void);
+
+    /*
+     * @brief Reads data that is available, does not wait for it.
+     * @returns Number of bytes read, or error.
+     * @retval >= 0 number of bytes read.
+     * @retval < 0 error
+     */
+    int Read(uint8_t* buf, size_t size);
+
+    /*
+     * @brief Waits for data and reads it.
+     * @details Returns as soon as any data is available,
+     * it does not wait for size bytes to be collected.
+     * @returns Number of bytes read, or error.
+     * @retval > 0 number of bytes read.
+     * @retval 0 timeout expired with no data received.
+     * @retval < 0 error
+     */
+    int Read(uint8_t* buf, size_t size, uint32_t timeoutMs);
+
+    /*
+     * @brief Writes data to the port.
+     * @returns Number of bytes written, or error.
+     * @retval > 0 number of bytes written (may be less than size).
+     * @retval 0 OS output buffer is full, nothing written (wait until port is writable).
+     * @retval < 0 error
+     */
+    int Write(const uint8_t* buf, size_t size);
+
+    //!< Writes a single byte, see Write().
+    int WriteByte(uint8_t byte);
+
+    /*
+     * @brief Waits until OS output buffer has room for more data, see Write().
+     * @returns ec_t
+     * @retval EC_OK If port is writable or timeout expired.
+     * @retval EC_FAIL If failed.
+     */
+    ec_t WaitWritable(uint32_t timeoutMs);
+
+    //!< Modem status lines.
+    bool IsDCDEnabled(void);
+    bool IsRINGEnabled(void);
+    bool IsCTSEnabled(void);
+    bool IsDSREnabled(void);
+
+    //!< Modem control lines.
+    void SetDTR(bool enable);
+    void SetRTS(bool enable);
+
+    //!< Discards data received but not read yet.
+    void FlushRX(void);
+
+    //!< Discards data written but not transmitted yet.
+    void FlushTX(void);
+
+    //!< Discards both, see FlushRX() and FlushTX().
+    void FlushRXTX(void);
+
+    /*
+     * Returns number of bytes written but not transmitted yet (held in OS output queue),
+     * or -1 if it is not known.
+     */
+    int GetTxQueued(void);
+
+    //!< Waits until all the data written is transmitted.
+    ec_t Drain(void);
+
+private:
+    std::string path;
+
+#if defined(__linux__) || defined(__FreeBSD__)   /* Linux & FreeBSD */
+    int fd;
+    struct termios oldSettings;
+
+    //!< Returns termios speed constant of baudrate, or B0 if not supported.
+    static speed_t GetSpeed(int baudrate);
+
+    //!< Fills termios settings for raw mode with given baudrate, data mode and flow control. Returns false if invalid.
+    static bool MakeSettings(int baudrate, const char* mode, bool flowctrl, struct termios& settings);
+
+    //!< Sets (enable) or clears modem lines given by mask. Returns false on failure.
+    bool SetModemLines(int mask, bool enable);
+
+    //!< Returns true if modem lines given by mask are set.
+    bool GetModemLines(int mask);
+#else
+    void* handle; //!< HANDLE, kept as void* so windows.h is not pulled into every user
+
+    //!< Applies baudrate, data mode and flow control to port h (HANDLE). Returns false on failure.
+    static bool ApplySettings(void* h, int baudrate, const char* mode, bool flowctrl);
+
+    //!< Returns true if modem status bits given by mask are set.
+    bool GetModemStatus(unsigned long mask);
+
+    //!< Applies EscapeCommFunction() function.
+    void EscapeFunction(unsigned long function);
+#endif
+
+    SerialPort(const SerialPort&) = delete;
+    SerialPort& operator=(const SerialPort&) = delete;
+};
+
+
+#endif /* SERIALPORT_SERIALPORT_HPP_ */
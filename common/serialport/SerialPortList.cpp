@@ -0,0 +1,348 @@
+/*
+***************************************************************************
+*
+* Author: alf64
+*
+* Copyright (C) 2019 alf64
+*
+* Email: alf64gordon@gmail.com
+*
+***************************************************************************
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* See <http://www.gnu.org/licenses/>.
+*
+***************************************************************************
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <algorithm>
+#include <map>
+#include <mutex>
+
+#if defined(__linux__) || defined(__FreeBSD__)   /* Linux & FreeBSD */
+#include <dirent.h>
+#include <limits.h>
+#include <unistd.h>
+#else
+#include <windows.h>
+#endif
+
+#include "serialport/SerialPortList.hpp"
+
+using namespace std;
+
+static std::mutex cacheMutex;
+static bool cacheValid = false;
+static std::vector<SerialPortList::port_info_t> cache;
+
+std::vector<SerialPortList::port_info_t> SerialPortList::Get(void)
+{
+    std::lock_guard<std::mutex> lock(cacheMutex);
+    if(!cacheValid)
+    {
+        cache.clear();
+        Enumerate(cache);
+        sort(cache.begin(), cache.end(), NameLess);
+        cacheValid = true;
+    }
+
+    return cache;
+}
+
+void SerialPortList::Refresh(void)
+{
+    std::lock_guard<std::mutex> lock(cacheMutex);
+    cacheValid = false;
+}
+
+size_t SerialPortList::Find(const char* pattern, std::vector<port_info_t>& ports)
+{
+    RETURN_VAL_ON_FAIL(pattern != NULL, 0);
+
+    vector<port_info_t> all = Get();
+    size_t found = 0;
+    for(size_t i = 0; i < all.size(); i++)
+    {
+        const port_info_t& port = all[i];
+        if(MatchPattern(pattern, port.name.c_str()) ||
+           MatchPattern(pattern, port.path.c_str()) ||
+           (!port.byIdPath.empty() && MatchPattern(pattern, port.byIdPath.c_str())) ||
+           ((port.vid != 0) && MatchPattern(pattern, GetUsbId(port).c_str())))
+        {
+            ports.push_back(port);
+            found++;
+        }
+    }
+
+    return found;
+}
+
+bool SerialPortList::MatchPattern(const char* pattern, const char* name)
+{
+    RETURN_VAL_ON_FAIL((pattern != NULL) && (name != NULL), false);
+
+    // '*' - any sequence of characters, '?' - any single character
+    const char* starPattern = NULL;
+    const char* starName = NULL;
+
+    while(*name != '\0')
+    {
+        if((*pattern == '?') || ((*pattern != '*') && (*pattern == *name)))
+        {
+            pattern++;
+            name++;
+        }
+        else if(*pattern == '*')
+        {
+            starPattern = pattern++;
+            starName = name;
+        }
+        else if(starPattern != NULL)
+        {
+            pattern = starPattern + 1;
+            name = ++starName;
+        }
+        else
+        {
+            return false;
+        }
+    }
+
+    while(*pattern == '*')
+    {
+        pattern++;
+    }
+
+    return (*pattern == '\0');
+}
+
+std::string SerialPortList::GetUsbId(const port_info_t& port)
+{
+    RETURN_VAL_ON_FAIL(port.vid != 0, string());
+
+    char usbId[10];
+    snprintf(usbId, sizeof(usbId), "%04x:%04x", port.vid, port.pid);
+
+    return string(usbId);
+}
+
+bool SerialPortList::NameLess(const port_info_t& a, const port_info_t& b)
+{
+    // compare the non-digit prefix first, then the number that follows it
+    size_t aDigits = a.name.find_first_of("0123456789");
+    size_t bDigits = b.name.find_first_of("0123456789");
+    int prefixCmp = a.name.compare(0, aDigits, b.name, 0, bDigits);
+    if(prefixCmp != 0)
+    {
+        return (prefixCmp < 0);
+    }
+
+    unsigned long aNum = (aDigits != string::npos) ? strtoul(a.name.c_str() + aDigits, NULL, 10) : 0;
+    unsigned long bNum = (bDigits != string::npos) ? strtoul(b.name.c_str() + bDigits, NULL, 10) : 0;
+    if(aNum != bNum)
+    {
+        return (aNum < bNum);
+    }
+
+    return (a.name < b.name);
+}
+
+#if defined(__linux__) || defined(__FreeBSD__)   /* Linux & FreeBSD */
+
+//!< Returns the first line of a sysfs attribute, empty string if there is none.
+static string ReadSysAttr(const string& path)
+{
+    FILE* f = fopen(path.c_str(), "r");
+    RETURN_VAL_ON_FAIL(f != NULL, string());
+
+    char line[256] = {0};
+    if(fgets(line, sizeof(line), f) == NULL)
+    {
+        line[0] = '\0';
+    }
+    fclose(f);
+    line[strcspn(line, "\r\n")] = '\0';
+
+    return string(line);
+}
+
+//!< Returns resolved path (symlinks followed), empty string if it does not exist.
+static string RealPath(const string& path)
+{
+    char resolved[PATH_MAX];
+    RETURN_VAL_ON_FAIL(realpath(path.c_str(), resolved) != NULL, string());
+
+    return string(resolved);
+}
+
+static string BaseName(const string& path)
+{
+    size_t slash = path.find_last_of('/');
+    return (slash == string::npos) ? path : path.substr(slash + 1);
+}
+
+static string DirName(const string& path)
+{
+    size_t slash = path.find_last_of('/');
+    return ((slash == string::npos) || (slash == 0)) ? string("/") : path.substr(0, slash);
+}
+
+/*
+ * Maps /dev/ttyXXX to its /dev/serial/by-id/ alias.
+ */
+static void ReadByIdAliases(map<string, string>& aliases)
+{
+    static const char* byIdDir = "/dev/serial/by-id";
+
+    DIR* dir = opendir(byIdDir);
+    RETURN_VOID_ON_FAIL(dir != NULL);
+
+    struct dirent* entry;
+    while((entry = readdir(dir)) != NULL)
+    {
+        if(entry->d_name[0] == '.')
+        {
+            continue;
+        }
+        string alias = string(byIdDir) + "/" + entry->d_name;
+        string target = RealPath(alias);
+        if(!target.empty())
+        {
+            aliases[target] = alias;
+        }
+    }
+    closedir(dir);
+}
+
+/*
+ * Fills driver and USB details of tty, given its sysfs class and device directories.
+ * Returns false if tty is a placeholder without a UART behind it (i.e. unprobed serial8250 port).
+ */
+static bool ReadDeviceInfo(const string& ttyDir, const string& devDir, SerialPortList::port_info_t& info)
+{
+    // serial core ports report their UART type, 0 is PORT_UNKNOWN
+    RETURN_VAL_ON_FAIL(ReadSysAttr(ttyDir + "/type") != "0", false);
+
+    // serial core (serial-base) devices sit between tty and the actual device since linux 6.5
+    string dev = devDir;
+    while((dev.size() > 1) && (BaseName(RealPath(dev + "/subsystem")) == "serial-base"))
+    {
+        dev = DirName(dev);
+    }
+
+    info.driver = BaseName(RealPath(dev + "/driver"));
+
+    // USB interface is a child of the USB device, which holds ids and strings
+    for(string usb = dev; usb.size() > 1; usb = DirName(usb))
+    {
+        string vid = ReadSysAttr(usb + "/idVendor");
+        if(vid.empty())
+        {
+            continue;
+        }
+        info.vid = static_cast<uint16_t>(strtoul(vid.c_str(), NULL, 16));
+        info.pid = static_cast<uint16_t>(strtoul(ReadSysAttr(usb + "/idProduct").c_str(), NULL, 16));
+        info.serial = ReadSysAttr(usb + "/serial");
+        info.product = ReadSysAttr(usb + "/product");
+        break;
+    }
+
+    return true;
+}
+
+void SerialPortList::Enumerate(std::vector<port_info_t>& ports)
+{
+    static const char* ttyClassDir = "/sys/class/tty";
+
+    DIR* dir = opendir(ttyClassDir);
+    RETURN_VOID_ON_FAIL(dir != NULL);
+
+    map<string, string> aliases;
+    ReadByIdAliases(aliases);
+
+    struct dirent* entry;
+    while((entry = readdir(dir)) != NULL)
+    {
+        if(entry->d_name[0] == '.')
+        {
+            continue;
+        }
+
+        // virtual terminals, ptys and the console have no device behind them
+        string ttyDir = string(ttyClassDir) + "/" + entry->d_name;
+        string devDir = RealPath(ttyDir + "/device");
+        if(devDir.empty())
+        {
+            continue;
+        }
+
+        port_info_t info;
+        info.name = entry->d_name;
+        info.path = string("/dev/") + entry->d_name;
+        info.vid = 0;
+        info.pid = 0;
+        if(!ReadDeviceInfo(ttyDir, devDir, info))
+        {
+            continue;
+        }
+        map<string, string>::iterator alias = aliases.find(info.path);
+        if(alias != aliases.end())
+        {
+            info.byIdPath = alias->second;
+        }
+
+        ports.push_back(info);
+    }
+    closedir(dir);
+}
+
+#else  /* windows */
+
+void SerialPortList::Enumerate(std::vector<port_info_t>& ports)
+{
+    HKEY key;
+    LONG ec = RegOpenKeyExA(HKEY_LOCAL_MACHINE, "HARDWARE\\DEVICEMAP\\SERIALCOMM", 0, KEY_READ, &key);
+    RETURN_VOID_ON_FAIL(ec == ERROR_SUCCESS);
+
+    // value name is the driver's device (i.e. \Device\Serial0, \Device\VCP0), data is the port name
+    for(DWORD i = 0; ; i++)
+    {
+        char valueName[256];
+        DWORD valueNameSize = sizeof(valueName);
+        char data[256];
+        DWORD dataSize = sizeof(data) - 1;
+        DWORD type = 0;
+        ec = RegEnumValueA(key, i, valueName, &valueNameSize, NULL, &type,
+                reinterpret_cast<LPBYTE>(data), &dataSize);
+        BREAK_ON_FAIL((ec == ERROR_SUCCESS) || (ec == ERROR_MORE_DATA));
+        if((ec != ERROR_SUCCESS) || (type != REG_SZ))
+        {
+            continue;
+        }
+        data[dataSize] = '\0';
+
+        port_info_t info;
+        info.name = data;
+        info.path = string("\\\\.\\") + data;
+        info.driver = valueName;
+        info.vid = 0;
+        info.pid = 0;
+        ports.push_back(info);
+    }
+    RegCloseKey(key);
+}
+
+#endif
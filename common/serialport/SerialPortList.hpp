@@ -0,0 +1,93 @@
+/*
+***************************************************************************
+*
+* Author: alf64
+*
+* Copyright (C) 2019 alf64
+*
+* Email: alf64gordon@gmail.com
+*
+***************************************************************************
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* See <http://www.gnu.org/licenses/>.
+*
+***************************************************************************
+*/
+
+#ifndef SERIALPORT_SERIALPORTLIST_HPP_
+#define SERIALPORT_SERIALPORTLIST_HPP_
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+#include "ec.h"
+
+/*
+ * Serial ports present in the system.
+ *
+ * Ports are enumerated without being opened:
+ * - Linux: from /sys/class/tty (ttys backed by a device), with USB details
+ *   and /dev/serial/by-id aliases. Legacy serial8250 placeholders
+ *   (ttyS* whose UART type is unknown, no hardware behind them) are skipped.
+ * - Windows: from HKLM\HARDWARE\DEVICEMAP\SERIALCOMM.
+ *
+ * The list is enumerated once and cached, Refresh() enumerates it again.
+ * All the functions are thread safe.
+ */
+class SerialPortList
+{
+public:
+    typedef struct
+    {
+        std::string name; //!< port name, i.e. ttyUSB0, COM3
+        std::string path; //!< device path, i.e. /dev/ttyUSB0
+        std::string byIdPath; //!< persistent alias (/dev/serial/by-id/...), empty if none
+        std::string driver; //!< driver, i.e. ftdi_sio, cdc_acm
+        uint16_t vid; //!< USB vendor id, 0 if not a USB device
+        uint16_t pid; //!< USB product id, 0 if not a USB device
+        std::string serial; //!< USB serial number
+        std::string product; //!< USB product name
+    }port_info_t;
+
+    //!< Returns ports present in the system (cached), sorted by name.
+    static std::vector<port_info_t> Get(void);
+
+    //!< Drops the cache, so the next Get() enumerates ports again.
+    static void Refresh(void);
+
+    /*
+     * @brief Appends ports matching pattern to ports.
+     * @details Pattern is matched against port name, device path, by-id alias
+     * and USB "vid:pid" (lowercase hex, i.e. 0403:6001).
+     * Pattern may contain wildcards: '*' (any sequence of characters), '?' (any single character).
+     * @returns Number of ports appended.
+     */
+    static size_t Find(const char* pattern, std::vector<port_info_t>& ports);
+
+    //!< Returns true if name matches pattern (see Find()).
+    static bool MatchPattern(const char* pattern, const char* name);
+
+    //!< Returns "vid:pid" of USB port (i.e. 0403:6001), empty string if not a USB port.
+    static std::string GetUsbId(const port_info_t& port);
+
+private:
+    //!< Enumerates ports present in the system.
+    static void Enumerate(std::vector<port_info_t>& ports);
+
+    //!< Returns true if a goes before b (ttyS2 before ttyS10).
+    static bool NameLess(const port_info_t& a, const port_info_t& b);
+};
+
+
+#endif /* SERIALPORT_SERIALPORTLIST_HPP_ */
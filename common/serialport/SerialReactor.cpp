@@ -0,0 +1,351 @@
+/*
+***************************************************************************
+*
+* Author: alf64
+*
+* Copyright (C) 2019 alf64
+*
+* Email: alf64gordon@gmail.com
+*
+***************************************************************************
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* See <http://www.gnu.org/licenses/>.
+*
+***************************************************************************
+*/
+
+#include <errno.h>
+#include <vector>
+
+#if defined(__linux__)
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#endif
+
+#include "serialport/SerialReactor.hpp"
+
+using namespace std;
+using namespace std::chrono;
+
+#if defined(__linux__)
+
+static uint32_t ToEpollEvents(uint32_t events)
+{
+    uint32_t ev = 0;
+    if(events & SerialReactor::EVENT_READABLE)
+    {
+        ev |= EPOLLIN;
+    }
+    if(events & SerialReactor::EVENT_WRITABLE)
+    {
+        ev |= EPOLLOUT;
+    }
+
+    return ev;
+}
+
+static uint32_t FromEpollEvents(uint32_t ev)
+{
+    uint32_t events = 0;
+    if(ev & EPOLLIN)
+    {
+        events |= SerialReactor::EVENT_READABLE;
+    }
+    if(ev & EPOLLOUT)
+    {
+        events |= SerialReactor::EVENT_WRITABLE;
+    }
+    if(ev & (EPOLLERR | EPOLLHUP))
+    {
+        events |= SerialReactor::EVENT_ERROR;
+    }
+
+    return events;
+}
+
+SerialReactor::SerialReactor(void):
+        initOk(false),
+        epollFd(-1),
+        wakeFd(-1),
+        stopRequested(false)
+{
+    epollFd = epoll_create1(EPOLL_CLOEXEC);
+    wakeFd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    if((epollFd != -1) && (wakeFd != -1))
+    {
+        struct epoll_event ev = {};
+        ev.events = EPOLLIN;
+        ev.data.fd = wakeFd;
+        initOk = (epoll_ctl(epollFd, EPOLL_CTL_ADD, wakeFd, &ev) == 0);
+    }
+}
+
+SerialReactor::~SerialReactor(void)
+{
+    if(wakeFd != -1)
+    {
+        close(wakeFd);
+    }
+    if(epollFd != -1)
+    {
+        close(epollFd);
+    }
+}
+
+bool SerialReactor::IsSupported(void)
+{
+    return true;
+}
+
+ec_t SerialReactor::Add(int fd, Handler* handler, uint32_t events)
+{
+    RETURN_VAL_ON_FAIL(initOk, EC_FAIL);
+    RETURN_VAL_ON_FAIL((fd >= 0) && (handler != NULL), EC_FAIL);
+    RETURN_VAL_ON_FAIL(ports.find(fd) == ports.end(), EC_FAIL);
+
+    struct epoll_event ev = {};
+    ev.events = ToEpollEvents(events);
+    ev.data.fd = fd;
+    RETURN_VAL_ON_FAIL(epoll_ctl(epollFd, EPOLL_CTL_ADD, fd, &ev) == 0, EC_FAIL);
+
+    port_t& port = ports[fd];
+    port.handler = handler;
+    port.events = events;
+    port.timeoutArmed = false;
+
+    return EC_OK;
+}
+
+ec_t SerialReactor::Modify(int fd, uint32_t events)
+{
+    RETURN_VAL_ON_FAIL(initOk, EC_FAIL);
+    map<int, port_t>::iterator it = ports.find(fd);
+    RETURN_VAL_ON_FAIL(it != ports.end(), EC_FAIL);
+    RETURN_VAL_ON_FAIL(it->second.events != events, EC_OK);
+
+    struct epoll_event ev = {};
+    ev.events = ToEpollEvents(events);
+    ev.data.fd = fd;
+    RETURN_VAL_ON_FAIL(epoll_ctl(epollFd, EPOLL_CTL_MOD, fd, &ev) == 0, EC_FAIL);
+    it->second.events = events;
+
+    return EC_OK;
+}
+
+ec_t SerialReactor::Remove(int fd)
+{
+    RETURN_VAL_ON_FAIL(initOk, EC_FAIL);
+    map<int, port_t>::iterator it = ports.find(fd);
+    RETURN_VAL_ON_FAIL(it != ports.end(), EC_FAIL);
+
+    // port may be closed already (i.e. after error), then it is gone from epoll set anyway
+    epoll_ctl(epollFd, EPOLL_CTL_DEL, fd, NULL);
+    ports.erase(it);
+
+    return EC_OK;
+}
+
+ec_t SerialReactor::RunOnce(int32_t maxWaitMs)
+{
+    RETURN_VAL_ON_FAIL(initOk, EC_FAIL);
+
+    struct epoll_event evs[maxEventsPerWait];
+    int n = epoll_wait(epollFd, evs, maxEventsPerWait, GetWaitMs(maxWaitMs));
+    if(n < 0)
+    {
+        return (errno == EINTR) ? EC_OK : EC_FAIL;
+    }
+
+    for(int i = 0; i < n; i++)
+    {
+        int fd = evs[i].data.fd;
+        if(fd == wakeFd)
+        {
+            uint64_t cnt;
+            RETURN_VAL_ON_FAIL(read(wakeFd, &cnt, sizeof(cnt)) >= 0, EC_FAIL);
+            continue;
+        }
+
+        // previous handler could have removed this port
+        map<int, port_t>::iterator it = ports.find(fd);
+        if(it == ports.end())
+        {
+            continue;
+        }
+        uint32_t events = FromEpollEvents(evs[i].events);
+        if(events != 0)
+        {
+            it->second.handler->OnPortEvent(fd, events);
+        }
+    }
+
+    DispatchTimeouts();
+
+    return EC_OK;
+}
+
+void SerialReactor::Stop(void)
+{
+    stopRequested = true;
+    if(wakeFd != -1)
+    {
+        uint64_t cnt = 1;
+        RETURN_VOID_ON_FAIL(write(wakeFd, &cnt, sizeof(cnt)) == sizeof(cnt));
+    }
+}
+
+#else
+
+SerialReactor::SerialReactor(void):
+        initOk(false),
+        epollFd(-1),
+        wakeFd(-1),
+        stopRequested(false)
+{
+}
+
+SerialReactor::~SerialReactor(void)
+{
+}
+
+bool SerialReactor::IsSupported(void)
+{
+    return false;
+}
+
+ec_t SerialReactor::Add(int fd, Handler* handler, uint32_t events)
+{
+    UNUSED(fd);
+    UNUSED(handler);
+    UNUSED(events);
+    return EC_FAIL;
+}
+
+ec_t SerialReactor::Modify(int fd, uint32_t events)
+{
+    UNUSED(fd);
+    UNUSED(events);
+    return EC_FAIL;
+}
+
+ec_t SerialReactor::Remove(int fd)
+{
+    UNUSED(fd);
+    return EC_FAIL;
+}
+
+ec_t SerialReactor::RunOnce(int32_t maxWaitMs)
+{
+    UNUSED(maxWaitMs);
+    return EC_FAIL;
+}
+
+void SerialReactor::Stop(void)
+{
+    stopRequested = true;
+}
+
+#endif
+
+ec_t SerialReactor::SetTimeout(int fd, uint32_t timeoutMs)
+{
+    RETURN_VAL_ON_FAIL(initOk, EC_FAIL);
+    map<int, port_t>::iterator it = ports.find(fd);
+    RETURN_VAL_ON_FAIL(it != ports.end(), EC_FAIL);
+
+    it->second.timeoutArmed = (timeoutMs > 0);
+    it->second.deadline = steady_clock::now() + milliseconds(timeoutMs);
+
+    return EC_OK;
+}
+
+size_t SerialReactor::GetPortsCount(void)
+{
+    return ports.size();
+}
+
+ec_t SerialReactor::Run(void)
+{
+    RETURN_VAL_ON_FAIL(initOk, EC_FAIL);
+
+    ec_t ec = EC_OK;
+    while(!stopRequested && !ports.empty())
+    {
+        ec = RunOnce(-1);
+        RETURN_EC_ON_ERROR(ec);
+    }
+
+    return ec;
+}
+
+void SerialReactor::ResetStop(void)
+{
+    stopRequested = false;
+}
+
+int32_t SerialReactor::GetWaitMs(int32_t maxWaitMs)
+{
+    int32_t waitMs = maxWaitMs;
+    const steady_clock::time_point now = steady_clock::now();
+
+    for(map<int, port_t>::iterator it = ports.begin(); it != ports.end(); ++it)
+    {
+        BREAK_ON_FAIL(waitMs != 0);
+        if(!it->second.timeoutArmed)
+        {
+            continue;
+        }
+
+        int32_t portWaitMs = 0;
+        if(it->second.deadline > now)
+        {
+            // round up, so the deadline has passed when the wait ends
+            portWaitMs = static_cast<int32_t>(
+                    duration_cast<milliseconds>(it->second.deadline - now).count() + 1);
+        }
+        if((waitMs < 0) || (portWaitMs < waitMs))
+        {
+            waitMs = portWaitMs;
+        }
+    }
+
+    return waitMs;
+}
+
+void SerialReactor::DispatchTimeouts(void)
+{
+    const steady_clock::time_point now = steady_clock::now();
+
+    // handlers may modify ports, so collect expired ones first
+    vector<int> expired;
+    for(map<int, port_t>::iterator it = ports.begin(); it != ports.end(); ++it)
+    {
+        if(it->second.timeoutArmed && (it->second.deadline <= now))
+        {
+            expired.push_back(it->first);
+        }
+    }
+
+    for(size_t i = 0; i < expired.size(); i++)
+    {
+        map<int, port_t>::iterator it = ports.find(expired[i]);
+        // port could be removed, or its timeout rearmed, by previous handler
+        if((it == ports.end()) || !it->second.timeoutArmed || (it->second.deadline > now))
+        {
+            continue;
+        }
+        it->second.timeoutArmed = false;
+        it->second.handler->OnPortEvent(expired[i], EVENT_TIMEOUT);
+    }
+}
@@ -0,0 +1,158 @@
+/*
+***************************************************************************
+*
+* Author: alf64
+*
+* Copyright (C) 2019 alf64
+*
+* Email: alf64gordon@gmail.com
+*
+***************************************************************************
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* See <http://www.gnu.org/licenses/>.
+*
+***************************************************************************
+*/
+
+#ifndef SERIALPORT_SERIALREACTOR_HPP_
+#define SERIALPORT_SERIALREACTOR_HPP_
+
+#include <stdint.h>
+#include <atomic>
+#include <chrono>
+#include <map>
+
+#include "ec.h"
+
+/*
+ * Event loop serving many serial ports from a single thread.
+ *
+ * Ports are registered by their file descriptors (see SerialPort::GetFd()),
+ * each one with its own handler. The thread sleeps in the OS (epoll) until
+ * some port becomes readable/writable or its timeout expires,
+ * so no CPU time is spent on polling idle ports.
+ *
+ * Handlers are called from the thread running the reactor.
+ * They may add, modify and remove ports (their own port included) from within a call.
+ *
+ * Supported on Linux only, see IsSupported().
+ */
+class SerialReactor
+{
+public:
+    typedef enum
+    {
+        EVENT_READABLE = 0x01, //!< data available for reading
+        EVENT_WRITABLE = 0x02, //!< room available for writing
+        EVENT_TIMEOUT = 0x04, //!< port timeout expired (see SetTimeout())
+        EVENT_ERROR = 0x08 //!< port error or hang up (i.e. device unplugged)
+    }event_t;
+
+    class Handler
+    {
+    public:
+        virtual ~Handler(void) {}
+
+        /*
+         * @brief Called by the reactor when events occurred on registered port.
+         * @param fd File descriptor of the port.
+         * @param events Bitmask of event_t.
+         */
+        virtual void OnPortEvent(int fd, uint32_t events) = 0;
+    };
+
+    SerialReactor(void);
+    ~SerialReactor(void);
+
+    //!< Returns true if reactor is supported on this OS.
+    static bool IsSupported(void);
+
+    /*
+     * @brief Registers port in the reactor.
+     * @param fd File descriptor of the port.
+     * @param handler Handler to be called on port's events.
+     * @param events Bitmask of EVENT_READABLE and/or EVENT_WRITABLE to watch for.
+     * EVENT_ERROR is always watched for.
+     * @returns ec_t
+     * @retval EC_OK If port registered.
+     * @retval EC_FAIL If failed (i.e. port registered already).
+     */
+    ec_t Add(int fd, Handler* handler, uint32_t events);
+
+    //!< Changes events watched for on registered port.
+    ec_t Modify(int fd, uint32_t events);
+
+    //!< Unregisters port from the reactor.
+    ec_t Remove(int fd);
+
+    /*
+     * @brief (Re)arms timeout of registered port.
+     * @details EVENT_TIMEOUT is delivered once, if timeoutMs elapses before
+     * the timeout is armed again. Timeout of 0 disarms it.
+     */
+    ec_t SetTimeout(int fd, uint32_t timeoutMs);
+
+    //!< Returns number of registered ports.
+    size_t GetPortsCount(void);
+
+    /*
+     * @brief Waits for events and dispatches them to the handlers.
+     * @param maxWaitMs Maximum time (in milliseconds) to wait for events,
+     * -1 waits until the nearest port timeout (or forever if there is none).
+     * @returns ec_t
+     * @retval EC_OK If waited successfully (with or without events).
+     * @retval EC_FAIL If failed.
+     */
+    ec_t RunOnce(int32_t maxWaitMs);
+
+    /*
+     * @brief Dispatches events until Stop() is called or no ports are registered.
+     * @details Returns at once if Stop() was called before, unless ResetStop() was called since.
+     * @returns ec_t
+     * @retval EC_OK If stopped.
+     * @retval EC_FAIL If failed.
+     */
+    ec_t Run(void);
+
+    //!< Makes Run() return. May be called from any thread.
+    void Stop(void);
+
+    //!< Forgets Stop() called before, so that the next Run() dispatches events again.
+    void ResetStop(void);
+
+private:
+    typedef struct
+    {
+        Handler* handler;
+        uint32_t events;
+        bool timeoutArmed;
+        std::chrono::steady_clock::time_point deadline;
+    }port_t;
+
+    static const int maxEventsPerWait = 64;
+
+    bool initOk;
+    int epollFd;
+    int wakeFd; //!< wakes the waiting thread up on Stop()
+    std::atomic<bool> stopRequested;
+    std::map<int, port_t> ports;
+
+    //!< Returns time (in milliseconds) to wait for events, considering port timeouts.
+    int32_t GetWaitMs(int32_t maxWaitMs);
+
+    //!< Delivers EVENT_TIMEOUT to ports which timeouts expired.
+    void DispatchTimeouts(void);
+};
+
+
+#endif /* SERIALPORT_SERIALREACTOR_HPP_ */
@@ -0,0 +1,482 @@
+/*
+***************************************************************************
+*
+* Author: alf64
+*
+* Copyright (C) 2019 alf64
+*
+* Email: alf64gordon@gmail.com
+*
+***************************************************************************
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* See <http://www.gnu.org/licenses/>.
+*
+***************************************************************************
+*/
+
+#include <errno.h>
+#include <string.h>
+
+#if defined(__linux__) && defined(__has_include)
+#if __has_include(<linux/io_uring.h>)
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <linux/io_uring.h>
+#if defined(__NR_io_uring_setup) && defined(IORING_FEAT_LINKED_FILE)
+#define SERIALURING_SUPPORTED
+#endif
+#endif
+#endif
+
+#include "serialport/SerialUring.hpp"
+
+using namespace std;
+
+#if defined(SERIALURING_SUPPORTED)
+
+static int UringSetup(uint32_t entries, struct io_uring_params* params)
+{
+    return static_cast<int>(syscall(__NR_io_uring_setup, entries, params));
+}
+
+static int UringEnter(int fd, uint32_t toSubmit, uint32_t minComplete, uint32_t flags)
+{
+    return static_cast<int>(syscall(__NR_io_uring_enter, fd, toSubmit, minComplete, flags, NULL, 0));
+}
+
+static int UringRegister(int fd, uint32_t opcode, const void* arg, uint32_t nrArgs)
+{
+    return static_cast<int>(syscall(__NR_io_uring_register, fd, opcode, arg, nrArgs));
+}
+
+SerialUring::SerialUring(void):
+        fd(-1),
+        sqEntries(0),
+        cqEntries(0),
+        sqRing(NULL),
+        sqRingSize(0),
+        cqRing(NULL),
+        cqRingSize(0),
+        sqes(NULL),
+        sqHead(NULL),
+        sqTail(NULL),
+        sqMask(0),
+        sqArray(NULL),
+        cqHead(NULL),
+        cqTail(NULL),
+        cqMask(0),
+        cqes(NULL),
+        sqePrepared(0),
+        sqeSubmitted(0)
+{
+}
+
+SerialUring::~SerialUring(void)
+{
+    Release();
+}
+
+bool SerialUring::IsSupported(void)
+{
+    static int supported = -1;
+
+    if(supported == -1)
+    {
+        // linked file requests came with 5.17, which has all the opcodes and flags used here
+        struct io_uring_params params;
+        memset(&params, 0, sizeof(params));
+        int probeFd = UringSetup(1, &params);
+        supported = ((probeFd != -1) && (params.features & IORING_FEAT_LINKED_FILE)) ? 1 : 0;
+        if(probeFd != -1)
+        {
+            close(probeFd);
+        }
+    }
+
+    return (supported == 1);
+}
+
+ec_t SerialUring::Init(uint32_t entries)
+{
+    Release();
+
+    struct io_uring_params params;
+    memset(&params, 0, sizeof(params));
+    fd = UringSetup(entries, &params);
+    RETURN_VAL_ON_FAIL(fd != -1, EC_FAIL);
+
+    sqEntries = params.sq_entries;
+    cqEntries = params.cq_entries;
+    sqRingSize = params.sq_off.array + (params.sq_entries * sizeof(uint32_t));
+    cqRingSize = params.cq_off.cqes + (params.cq_entries * sizeof(struct io_uring_cqe));
+    if(params.features & IORING_FEAT_SINGLE_MMAP)
+    {
+        // both rings share a single mapping
+        sqRingSize = (cqRingSize > sqRingSize) ? cqRingSize : sqRingSize;
+        cqRingSize = 0;
+    }
+
+    sqRing = mmap(NULL, sqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+    if(sqRing == MAP_FAILED)
+    {
+        sqRing = NULL;
+        Release();
+        return EC_FAIL;
+    }
+    cqRing = sqRing;
+    if(cqRingSize > 0)
+    {
+        cqRing = mmap(NULL, cqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_CQ_RING);
+        if(cqRing == MAP_FAILED)
+        {
+            cqRing = NULL;
+            Release();
+            return EC_FAIL;
+        }
+    }
+    sqes = mmap(NULL, params.sq_entries * sizeof(struct io_uring_sqe), PROT_READ | PROT_WRITE,
+            MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES);
+    if(sqes == MAP_FAILED)
+    {
+        sqes = NULL;
+        Release();
+        return EC_FAIL;
+    }
+
+    uint8_t* sq = static_cast<uint8_t*>(sqRing);
+    uint8_t* cq = static_cast<uint8_t*>(cqRing);
+    sqHead = reinterpret_cast<uint32_t*>(sq + params.sq_off.head);
+    sqTail = reinterpret_cast<uint32_t*>(sq + params.sq_off.tail);
+    sqMask = *reinterpret_cast<uint32_t*>(sq + params.sq_off.ring_mask);
+    sqArray = reinterpret_cast<uint32_t*>(sq + params.sq_off.array);
+    cqHead = reinterpret_cast<uint32_t*>(cq + params.cq_off.head);
+    cqTail = reinterpret_cast<uint32_t*>(cq + params.cq_off.tail);
+    cqMask = *reinterpret_cast<uint32_t*>(cq + params.cq_off.ring_mask);
+    cqes = cq + params.cq_off.cqes;
+    sqePrepared = *sqTail;
+    sqeSubmitted = sqePrepared;
+    timespecs.assign(sqEntries * 2, 0);
+
+    return EC_OK;
+}
+
+ec_t SerialUring::RegisterBuffers(uint8_t* buffers, uint32_t count, size_t size)
+{
+    RETURN_VAL_ON_FAIL(fd != -1, EC_FAIL);
+
+    vector<struct iovec> iovs(count);
+    for(uint32_t i = 0; i < count; i++)
+    {
+        iovs[i].iov_base = buffers + (i * size);
+        iovs[i].iov_len = size;
+    }
+    RETURN_VAL_ON_FAIL(UringRegister(fd, IORING_REGISTER_BUFFERS, iovs.data(), count) == 0, EC_FAIL);
+
+    return EC_OK;
+}
+
+uint32_t SerialUring::GetSqSpace(void)
+{
+    RETURN_VAL_ON_FAIL(fd != -1, 0);
+
+    return sqEntries - (sqePrepared - __atomic_load_n(sqHead, __ATOMIC_ACQUIRE));
+}
+
+void* SerialUring::GetSqe(void)
+{
+    RETURN_VAL_ON_FAIL(GetSqSpace() > 0, NULL);
+
+    uint32_t index = sqePrepared & sqMask;
+    struct io_uring_sqe* sqe = static_cast<struct io_uring_sqe*>(sqes) + index;
+    memset(sqe, 0, sizeof(*sqe));
+    sqArray[index] = index;
+    sqePrepared++;
+
+    return sqe;
+}
+
+bool SerialUring::PrepReadFixed(int fileFd, uint32_t bufIndex, uint8_t* data, uint32_t len, uint64_t offset,
+        uint64_t userData, bool link)
+{
+    struct io_uring_sqe* sqe = static_cast<struct io_uring_sqe*>(GetSqe());
+    RETURN_VAL_ON_FAIL(sqe != NULL, false);
+
+    sqe->opcode = IORING_OP_READ_FIXED;
+    sqe->fd = fileFd;
+    sqe->addr = reinterpret_cast<uint64_t>(data);
+    sqe->len = len;
+    sqe->off = offset;
+    sqe->buf_index = static_cast<uint16_t>(bufIndex);
+    sqe->user_data = userData;
+    sqe->flags = link ? IOSQE_IO_LINK : 0;
+
+    return true;
+}
+
+bool SerialUring::PrepRead(int fileFd, uint8_t* data, uint32_t len, uint64_t offset, uint64_t userData, bool link)
+{
+    struct io_uring_sqe* sqe = static_cast<struct io_uring_sqe*>(GetSqe());
+    RETURN_VAL_ON_FAIL(sqe != NULL, false);
+
+    sqe->opcode = IORING_OP_READ;
+    sqe->fd = fileFd;
+    sqe->addr = reinterpret_cast<uint64_t>(data);
+    sqe->len = len;
+    sqe->off = offset;
+    sqe->user_data = userData;
+    sqe->flags = link ? IOSQE_IO_LINK : 0;
+
+    return true;
+}
+
+bool SerialUring::PrepWriteFixed(int fileFd, uint32_t bufIndex, const uint8_t* data, uint32_t len, uint64_t offset,
+        uint64_t userData, bool link)
+{
+    struct io_uring_sqe* sqe = static_cast<struct io_uring_sqe*>(GetSqe());
+    RETURN_VAL_ON_FAIL(sqe != NULL, false);
+
+    sqe->opcode = IORING_OP_WRITE_FIXED;
+    sqe->fd = fileFd;
+    sqe->addr = reinterpret_cast<uint64_t>(data);
+    sqe->len = len;
+    sqe->off = offset;
+    sqe->buf_index = static_cast<uint16_t>(bufIndex);
+    sqe->user_data = userData;
+    // ports block on writes: issued from task work (i.e. after a linked timeout) a tty write
+    // takes the task work notification for a pending signal and fails with -EINTR, worker threads do not
+    sqe->flags = (link ? IOSQE_IO_LINK : 0) | IOSQE_ASYNC;
+
+    return true;
+}
+
+bool SerialUring::PrepTimeout(uint64_t ns, bool absolute, uint64_t userData, bool link)
+{
+    struct io_uring_sqe* sqe = static_cast<struct io_uring_sqe*>(GetSqe());
+    RETURN_VAL_ON_FAIL(sqe != NULL, false);
+
+    // the kernel reads the timespec on submit, so it is kept per entry until then
+    uint32_t index = (sqePrepared - 1) & sqMask;
+    struct __kernel_timespec* ts = reinterpret_cast<struct __kernel_timespec*>(&timespecs[index * 2]);
+    ts->tv_sec = static_cast<int64_t>(ns / 1000000000ull);
+    ts->tv_nsec = static_cast<long long>(ns % 1000000000ull);
+
+    sqe->opcode = IORING_OP_TIMEOUT;
+    sqe->fd = -1;
+    sqe->addr = reinterpret_cast<uint64_t>(ts);
+    sqe->len = 1;
+    sqe->off = 0; // complete on expiration only
+    sqe->timeout_flags = IORING_TIMEOUT_ETIME_SUCCESS | (absolute ? IORING_TIMEOUT_ABS : 0);
+    sqe->user_data = userData;
+    sqe->flags = link ? IOSQE_IO_LINK : 0;
+
+    return true;
+}
+
+ec_t SerialUring::Submit(uint32_t waitNr)
+{
+    RETURN_VAL_ON_FAIL(fd != -1, EC_FAIL);
+
+    __atomic_store_n(sqTail, sqePrepared, __ATOMIC_RELEASE);
+
+    while(true)
+    {
+        uint32_t toSubmit = sqePrepared - sqeSubmitted;
+        int ret = UringEnter(fd, toSubmit, waitNr, (waitNr > 0) ? IORING_ENTER_GETEVENTS : 0);
+        if(ret < 0)
+        {
+            RETURN_VAL_ON_FAIL(errno == EINTR, EC_FAIL);
+            continue;
+        }
+        sqeSubmitted += static_cast<uint32_t>(ret);
+        if(sqeSubmitted == sqePrepared)
+        {
+            break;
+        }
+    }
+
+    // the kernel may return before waitNr completions are posted (i.e. on task work), wait for the rest
+    while(true)
+    {
+        uint32_t ready = __atomic_load_n(cqTail, __ATOMIC_ACQUIRE) - *cqHead;
+        if(ready >= waitNr)
+        {
+            break;
+        }
+        int ret = UringEnter(fd, 0, waitNr - ready, IORING_ENTER_GETEVENTS);
+        RETURN_VAL_ON_FAIL((ret >= 0) || (errno == EINTR), EC_FAIL);
+    }
+
+    return EC_OK;
+}
+
+bool SerialUring::PopCompletion(completion_t& completion)
+{
+    RETURN_VAL_ON_FAIL(fd != -1, false);
+
+    uint32_t head = *cqHead;
+    RETURN_VAL_ON_FAIL(head != __atomic_load_n(cqTail, __ATOMIC_ACQUIRE), false);
+
+    const struct io_uring_cqe* cqe = static_cast<const struct io_uring_cqe*>(cqes) + (head & cqMask);
+    completion.userData = cqe->user_data;
+    completion.res = cqe->res;
+    __atomic_store_n(cqHead, head + 1, __ATOMIC_RELEASE);
+
+    return true;
+}
+
+void SerialUring::Release(void)
+{
+    if(sqes != NULL)
+    {
+        munmap(sqes, sqEntries * sizeof(struct io_uring_sqe));
+        sqes = NULL;
+    }
+    if((cqRing != NULL) && (cqRing != sqRing))
+    {
+        munmap(cqRing, cqRingSize);
+    }
+    cqRing = NULL;
+    if(sqRing != NULL)
+    {
+        munmap(sqRing, sqRingSize);
+        sqRing = NULL;
+    }
+    if(fd != -1)
+    {
+        close(fd); // also unregisters the buffers
+        fd = -1;
+    }
+}
+
+#else
+
+SerialUring::SerialUring(void):
+        fd(-1),
+        sqEntries(0),
+        cqEntries(0),
+        sqRing(NULL),
+        sqRingSize(0),
+        cqRing(NULL),
+        cqRingSize(0),
+        sqes(NULL),
+        sqHead(NULL),
+        sqTail(NULL),
+        sqMask(0),
+        sqArray(NULL),
+        cqHead(NULL),
+        cqTail(NULL),
+        cqMask(0),
+        cqes(NULL),
+        sqePrepared(0),
+        sqeSubmitted(0)
+{
+}
+
+SerialUring::~SerialUring(void)
+{
+}
+
+bool SerialUring::IsSupported(void)
+{
+    return false;
+}
+
+ec_t SerialUring::Init(uint32_t entries)
+{
+    UNUSED(entries);
+    return EC_FAIL;
+}
+
+ec_t SerialUring::RegisterBuffers(uint8_t* buffers, uint32_t count, size_t size)
+{
+    UNUSED(buffers);
+    UNUSED(count);
+    UNUSED(size);
+    return EC_FAIL;
+}
+
+uint32_t SerialUring::GetSqSpace(void)
+{
+    return 0;
+}
+
+bool SerialUring::PrepReadFixed(int fileFd, uint32_t bufIndex, uint8_t* data, uint32_t len, uint64_t offset,
+        uint64_t userData, bool link)
+{
+    UNUSED(fileFd);
+    UNUSED(bufIndex);
+    UNUSED(data);
+    UNUSED(len);
+    UNUSED(offset);
+    UNUSED(userData);
+    UNUSED(link);
+    return false;
+}
+
+bool SerialUring::PrepRead(int fileFd, uint8_t* data, uint32_t len, uint64_t offset, uint64_t userData, bool link)
+{
+    UNUSED(fileFd);
+    UNUSED(data);
+    UNUSED(len);
+    UNUSED(offset);
+    UNUSED(userData);
+    UNUSED(link);
+    return false;
+}
+
+bool SerialUring::PrepWriteFixed(int fileFd, uint32_t bufIndex, const uint8_t* data, uint32_t len, uint64_t offset,
+        uint64_t userData, bool link)
+{
+    UNUSED(fileFd);
+    UNUSED(bufIndex);
+    UNUSED(data);
+    UNUSED(len);
+    UNUSED(offset);
+    UNUSED(userData);
+    UNUSED(link);
+    return false;
+}
+
+bool SerialUring::PrepTimeout(uint64_t ns, bool absolute, uint64_t userData, bool link)
+{
+    UNUSED(ns);
+    UNUSED(absolute);
+    UNUSED(userData);
+    UNUSED(link);
+    return false;
+}
+
+ec_t SerialUring::Submit(uint32_t waitNr)
+{
+    UNUSED(waitNr);
+    return EC_FAIL;
+}
+
+bool SerialUring::PopCompletion(completion_t& completion)
+{
+    UNUSED(completion);
+    return false;
+}
+
+void* SerialUring::GetSqe(void)
+{
+    return NULL;
+}
+
+void SerialUring::Release(void)
+{
+}
+
+#endif
@@ -0,0 +1,150 @@
+/*
+***************************************************************************
+*
+* Author: alf64
+*
+* Copyright (C) 2019 alf64
+*
+* Email: alf64gordon@gmail.com
+*
+***************************************************************************
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* See <http://www.gnu.org/licenses/>.
+*
+***************************************************************************
+*/
+
+#ifndef SERIALPORT_SERIALURING_HPP_
+#define SERIALPORT_SERIALURING_HPP_
+
+#include <stdint.h>
+#include <stddef.h>
+#include <vector>
+
+#include "ec.h"
+
+/*
+ * Minimal io_uring instance (raw system calls, no liburing needed)
+ * for moving data between files and serial ports with few system calls.
+ *
+ * Requests are prepared into the submission queue and sent to the kernel
+ * by Submit(), which can also wait for their completions in the same call.
+ * Requests prepared with link set run one after another: the next one starts
+ * when the previous one completed, and is cancelled (-ECANCELED) if it failed.
+ * Fixed reads/writes use buffers registered with RegisterBuffers(),
+ * so the kernel does not map them on each request.
+ *
+ * Note: requests on file descriptors in non-blocking mode complete with -EAGAIN
+ * rather than waiting, so ports shall be switched to blocking mode first.
+ *
+ * Supported on Linux 5.17+ only, see IsSupported().
+ */
+class SerialUring
+{
+public:
+    typedef struct
+    {
+        uint64_t userData; //!< user data of the completed request
+        int32_t res; //!< result: number of bytes transferred or -errno
+    }completion_t;
+
+    SerialUring(void);
+    ~SerialUring(void);
+
+    //!< Returns true if io_uring (with the features used here) is supported by the running kernel.
+    static bool IsSupported(void);
+
+    /*
+     * @brief Sets the instance up.
+     * @param entries Size of the submission queue (rounded up to a power of 2 by the kernel).
+     * @returns ec_t
+     * @retval EC_OK If set up.
+     * @retval EC_FAIL If failed.
+     */
+    ec_t Init(uint32_t entries);
+
+    /*
+     * @brief Registers count buffers of size bytes each, starting at buffers.
+     * @details Buffer i (see PrepReadFixed(), PrepWriteFixed()) starts at buffers + i * size.
+     * @returns ec_t
+     * @retval EC_OK If registered.
+     * @retval EC_FAIL If failed (i.e. RLIMIT_MEMLOCK exceeded on older kernels).
+     */
+    ec_t RegisterBuffers(uint8_t* buffers, uint32_t count, size_t size);
+
+    //!< Returns number of requests that can still be prepared.
+    uint32_t GetSqSpace(void);
+
+    /*
+     * @brief Prepares read of len bytes at offset of fileFd into registered buffer bufIndex.
+     * @param data Where to read to, within the registered buffer.
+     * @param link If true, the next prepared request runs after this one completes.
+     * @retval false If the submission queue is full.
+     */
+    bool PrepReadFixed(int fileFd, uint32_t bufIndex, uint8_t* data, uint32_t len, uint64_t offset,
+            uint64_t userData, bool link);
+
+    //!< Prepares read of len bytes at offset of fileFd into data (not a registered buffer).
+    bool PrepRead(int fileFd, uint8_t* data, uint32_t len, uint64_t offset, uint64_t userData, bool link);
+
+    //!< Prepares write of len bytes from registered buffer bufIndex to fileFd at offset (-1: current position), run by a kernel worker thread.
+    bool PrepWriteFixed(int fileFd, uint32_t bufIndex, const uint8_t* data, uint32_t len, uint64_t offset,
+            uint64_t userData, bool link);
+
+    /*
+     * @brief Prepares timeout of ns nanoseconds (or until ns of CLOCK_MONOTONIC if absolute).
+     * @details Expired timeout completes with -ETIME, which does not cancel the linked requests.
+     */
+    bool PrepTimeout(uint64_t ns, bool absolute, uint64_t userData, bool link);
+
+    /*
+     * @brief Submits prepared requests and waits until at least waitNr completions are available.
+     * @returns ec_t
+     * @retval EC_OK If submitted (and waited).
+     * @retval EC_FAIL If failed.
+     */
+    ec_t Submit(uint32_t waitNr);
+
+    //!< Takes the next completion, returns false if there is none.
+    bool PopCompletion(completion_t& completion);
+
+private:
+    int fd; //!< io_uring file descriptor, -1 if not set up
+    uint32_t sqEntries;
+    uint32_t cqEntries;
+    void* sqRing; //!< submission queue ring (mapped)
+    size_t sqRingSize;
+    void* cqRing; //!< completion queue ring (mapped), may be the same mapping as sqRing
+    size_t cqRingSize;
+    void* sqes; //!< submission queue entries (mapped)
+    uint32_t* sqHead;
+    uint32_t* sqTail;
+    uint32_t sqMask;
+    uint32_t* sqArray;
+    uint32_t* cqHead;
+    uint32_t* cqTail;
+    uint32_t cqMask;
+    void* cqes;
+    uint32_t sqePrepared; //!< tail of prepared, not yet submitted entries
+    uint32_t sqeSubmitted; //!< tail of entries passed to the kernel
+    std::vector<int64_t> timespecs; //!< timeouts of the entries (tv_sec, tv_nsec pairs)
+
+    //!< Returns the next free submission queue entry (zeroed), NULL if the queue is full.
+    void* GetSqe(void);
+
+    //!< Releases the instance.
+    void Release(void);
+};
+
+
+#endif /* SERIALPORT_SERIALURING_HPP_ */